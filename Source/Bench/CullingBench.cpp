@@ -0,0 +1,868 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <random>
+#ifdef _WIN32
+    #include <Windows.h>
+#else
+    #include <sys/mman.h>
+    #define __cdecl
+#endif
+// Forward slashes keep the benchmark buildable on other platforms.
+#include "../Common/Camera.h"
+#include "../Common/CameraPath.h"
+#include "../Common/CommandStream.hpp"
+#include "../Common/Culling.h"
+#include "../Common/DrawEncoding.h"
+#include "../Common/DynBitSet.hpp"
+#include "../Common/HierBitSet.hpp"
+#include "../Common/IndirectDraws.h"
+#include "../Common/JobSystem.h"
+#include "../Common/Math.h"
+#include "../Common/ParallelRecording.h"
+#include "../Common/Primitives.h"
+#include "../Common/SceneGeometry.h"
+#include "../Common/StreamCopy.h"
+#include "../Common/Utility.h"
+
+using namespace DirectX;
+
+using Clock = std::chrono::high_resolution_clock;
+
+// Per-object data used by the renderer for culling, sorting and draw list construction.
+struct BenchScene {
+    size_t                        objCount;
+    std::unique_ptr<AABox[]>      boundingBoxes;
+    std::unique_ptr<uint16_t[]>   materialIndices;
+    std::unique_ptr<uint32_t[]>   indexCounts;
+    std::unique_ptr<DrawPacket[]> drawPackets;    // Built assuming a single index buffer
+    AABox                         bounds;         // Bounding box of the entire scene
+};
+
+// Encoder which only counts the commands. Used to validate command streams.
+struct CommandCounter {
+    void transition(uint32_t, uint32_t, uint32_t, uint32_t)          { ++cmdCount; }
+    void setRootConstants(uint32_t, uint32_t, const void*, uint32_t) { ++cmdCount; }
+    void setDescriptorTable(uint32_t, uint32_t)                      { ++cmdCount; }
+    void setIndexBuffer(uint32_t)                                    { ++cmdCount; }
+    void drawIndexed(uint32_t, uint32_t)                             { ++cmdCount; }
+public:
+    size_t cmdCount;
+};
+
+// Mirrors the state set by Renderer::recordGBufferPass() for a single draw call.
+struct DrawCommand {
+    uint32_t materialIndex;
+    uint32_t indexCount;
+};
+
+// Accumulated per-stage statistics.
+struct BenchStats {
+    double totalCullTime;       // In nanoseconds
+    double totalSortTime;       // In nanoseconds
+    double totalDrawListTime;   // In nanoseconds
+    double totalIncrCullTime;   // In nanoseconds
+    double totalRefineTime;     // In nanoseconds
+    size_t totalVisObjCount;
+    size_t minVisObjCount;
+    size_t maxVisObjCount;
+    size_t totalStateChangeCount;
+    size_t totalTestedObjCount;
+    size_t totalFalsePosCount;
+    size_t totalRefinedVisObjCount;
+    size_t totalRefinedFalsePosCount;
+    size_t totalRefinedFalseNegCount;
+};
+
+// Returns the time elapsed since 't0' in nanoseconds.
+static inline auto elapsedTime(const Clock::time_point t0)
+-> double {
+    return std::chrono::duration<double, std::nano>(Clock::now() - t0).count();
+}
+
+// Stand-in for Renderer::recordGBufferDraws(): records the draws of the sorted visible objects
+// within the range. Like a new command list, each range starts without a material set.
+// Returns the number of material changes.
+static inline auto recordDrawCommands(const BenchScene& scene, const ObjectSortPair* objSortPairs,
+                                      const DrawRange& range, DrawCommand* drawCommands)
+-> size_t {
+    size_t   stateChangeCount = 0;
+    uint32_t materialIndex    = UINT32_MAX;
+    for (size_t i = range.begin; i < range.end; ++i) {
+        const uint32_t objId = objSortPairs[i].index;
+        if (materialIndex != scene.materialIndices[objId]) {
+            materialIndex = scene.materialIndices[objId];
+            ++stateChangeCount;
+        }
+        drawCommands[i] = DrawCommand{materialIndex, scene.indexCounts[objId]};
+    }
+    return stateChangeCount;
+}
+
+// Constructs the draw packets of the scene, assuming a single index buffer.
+// The textures are not loaded, so every other material is assumed to have a bump map.
+static inline auto buildDrawPackets(const BenchScene& scene)
+-> std::unique_ptr<DrawPacket[]> {
+    auto     drawPackets = std::make_unique<DrawPacket[]>(scene.objCount);
+    uint32_t firstIndex  = 0;
+    for (size_t i = 0, n = scene.objCount; i < n; ++i) {
+        const uint16_t matId     = scene.materialIndices[i];
+        const uint32_t bumpTexId = (matId % 2) ? UINT32_MAX : matId;
+        drawPackets[i] = makeDrawPacket(scene.indexCounts[i], firstIndex, matId, bumpTexId);
+        firstIndex    += scene.indexCounts[i];
+    }
+    return drawPackets;
+}
+
+// Loads the scene from an .obj file. The materials and the textures are not loaded.
+static inline auto loadScene(const char* path, const char* objFileName)
+-> BenchScene {
+    const SceneGeometry geometry{path, objFileName};
+    BenchScene scene;
+    scene.objCount        = geometry.objects.size();
+    scene.boundingBoxes   = geometry.computeBoundingBoxes();
+    scene.materialIndices = std::make_unique<uint16_t[]>(scene.objCount);
+    scene.indexCounts     = std::make_unique<uint32_t[]>(scene.objCount);
+    scene.bounds          = AABox::empty();
+    for (size_t i = 0, n = scene.objCount; i < n; ++i) {
+        scene.materialIndices[i] = static_cast<uint16_t>(geometry.objects[i].material);
+        scene.indexCounts[i]     = static_cast<uint32_t>(geometry.objects[i].indices.size());
+        scene.bounds.extend(scene.boundingBoxes[i].minPoint());
+        scene.bounds.extend(scene.boundingBoxes[i].maxPoint());
+    }
+    scene.drawPackets = buildDrawPackets(scene);
+    return scene;
+}
+
+// Generates a deterministic scene composed of 'objCount' randomly placed boxes.
+// Similarly to the scene loader, sorts the objects by material.
+static inline auto generateScene(const size_t objCount)
+-> BenchScene {
+    constexpr float    sceneSize = 4096.f;
+    constexpr uint32_t matCount  = 32;
+    std::mt19937 rng{1234567};
+    std::uniform_real_distribution<float> posDistr{0.f, sceneSize};
+    std::uniform_real_distribution<float> logSizeDistr{0.f, 6.f};
+    std::uniform_int_distribution<uint32_t> matDistr{0, matCount - 1};
+    std::uniform_int_distribution<uint32_t> triDistr{12, 10000};
+    BenchScene scene;
+    scene.objCount        = objCount;
+    scene.boundingBoxes   = std::make_unique<AABox[]>(objCount);
+    scene.materialIndices = std::make_unique<uint16_t[]>(objCount);
+    scene.indexCounts     = std::make_unique<uint32_t[]>(objCount);
+    scene.bounds          = AABox::empty();
+    for (size_t i = 0; i < objCount; ++i) {
+        const XMFLOAT3 pMin = {posDistr(rng), posDistr(rng), posDistr(rng)};
+        // Use a log-uniform distribution of sizes (from 1 to 400 meters).
+        const float dims[3] = {expf(logSizeDistr(rng)), expf(logSizeDistr(rng)),
+                               expf(logSizeDistr(rng))};
+        scene.boundingBoxes[i]   = AABox{pMin, dims};
+        scene.materialIndices[i] = static_cast<uint16_t>(matDistr(rng));
+        scene.indexCounts[i]     = 3 * triDistr(rng);
+        scene.bounds.extend(scene.boundingBoxes[i].minPoint());
+        scene.bounds.extend(scene.boundingBoxes[i].maxPoint());
+    }
+    // Sort the objects by material.
+    auto order = std::make_unique<uint32_t[]>(objCount);
+    for (uint32_t i = 0; i < objCount; ++i) {
+        order[i] = i;
+    }
+    std::stable_sort(order.get(), order.get() + objCount,
+                     [&scene](const uint32_t a, const uint32_t b) {
+                         return scene.materialIndices[a] < scene.materialIndices[b];
+                     });
+    BenchScene sorted;
+    sorted.objCount        = objCount;
+    sorted.boundingBoxes   = std::make_unique<AABox[]>(objCount);
+    sorted.materialIndices = std::make_unique<uint16_t[]>(objCount);
+    sorted.indexCounts     = std::make_unique<uint32_t[]>(objCount);
+    sorted.bounds          = scene.bounds;
+    for (size_t i = 0; i < objCount; ++i) {
+        sorted.boundingBoxes[i]   = scene.boundingBoxes[order[i]];
+        sorted.materialIndices[i] = scene.materialIndices[order[i]];
+        sorted.indexCounts[i]     = scene.indexCounts[order[i]];
+    }
+    sorted.drawPackets = buildDrawPackets(sorted);
+    return sorted;
+}
+
+// Generates 'poseCount' camera poses along a closed path inside the scene bounds.
+// Consecutive poses are close to each other, similarly to interactive camera motion.
+static inline auto generateCameraPoses(const AABox& bounds, const size_t poseCount)
+-> std::vector<PerspectiveCamera> {
+    const XMVECTOR center  = bounds.center();
+    const XMVECTOR extents = 0.5f * (bounds.maxPoint() - bounds.minPoint());
+    const float    radius  = 0.3f * std::max(XMVectorGetX(extents), XMVectorGetZ(extents));
+    const float    height  = 0.1f * XMVectorGetY(extents);
+    std::vector<PerspectiveCamera> poses;
+    poses.reserve(poseCount);
+    for (size_t i = 0; i < poseCount; ++i) {
+        const float t = 2.f * M_PI * static_cast<float>(i) / static_cast<float>(poseCount);
+        const float c = cosf(t), s = sinf(t);
+        // Orbit around the center, looking slightly inwards and periodically up and down.
+        const XMVECTOR pos = center + XMVECTOR{radius * c, height * sinf(3.f * t), radius * s};
+        const XMVECTOR dir = XMVECTOR{-s - 0.5f * c, 0.25f * cosf(3.f * t), c - 0.5f * s};
+        poses.emplace_back(static_cast<float>(RES_X), static_cast<float>(RES_Y), VERTICAL_FOV,
+                           pos, dir, g_XMIdentityR1.v);
+    }
+    return poses;
+}
+
+// Samples the recorded camera path with the fixed playback time step.
+static inline auto loadCameraPoses(const char* camPathFileName)
+-> std::vector<PerspectiveCamera> {
+    const CameraPath camPath{camPathFileName};
+    const size_t     poseCount = camPath.poseCount() > 0
+                               ? static_cast<size_t>(camPath.duration() / PLAYBACK_STEP) + 1
+                               : 0;
+    std::vector<PerspectiveCamera> poses;
+    poses.reserve(poseCount);
+    for (size_t i = 0; i < poseCount; ++i) {
+        PerspectiveCamera pCam{static_cast<float>(RES_X), static_cast<float>(RES_Y),
+                               VERTICAL_FOV, g_XMZero, g_XMIdentityR2, g_XMIdentityR1};
+        camPath.applyPose(static_cast<float>(i) * PLAYBACK_STEP, &pCam);
+        poses.push_back(pCam);
+    }
+    return poses;
+}
+
+// Returns 'true' if the box overlaps the frustum. Exact, but slow.
+// Clips each face of the box against the planes of the frustum, and checks
+// whether anything remains (Sutherland-Hodgman polygon clipping).
+static inline auto intersectsReference(const Frustum& frustum, const AABox& aaBox)
+-> bool {
+    XMVECTOR planes[5];
+    for (size_t p = 0; p < 5; ++p) {
+        planes[p] = frustum.computePlane(p);
+    }
+    // Corner 'c' is composed of the coordinates of the points [c & 1], [c >> 1 & 1], [c >> 2].
+    const XMVECTOR points[2] = {XMVectorSetW(aaBox.minPoint(), 1.f),
+                                XMVectorSetW(aaBox.maxPoint(), 1.f)};
+    XMVECTOR corners[8];
+    for (uint32_t c = 0; c < 8; ++c) {
+        corners[c] = XMVectorSelect(points[0], points[1],
+                                    XMVectorSelectControl(c & 1, c >> 1 & 1, c >> 2, 0));
+    }
+    constexpr uint8_t faces[6][4] = {{0, 2, 6, 4}, {1, 3, 7, 5}, {0, 1, 5, 4},
+                                     {2, 3, 7, 6}, {0, 1, 3, 2}, {4, 5, 7, 6}};
+    for (size_t f = 0; f < 6; ++f) {
+        // Clipping a quadrilateral by 5 planes produces at most 9 vertices.
+        XMVECTOR poly[9], clipped[9];
+        size_t   vertCount = 4;
+        for (size_t v = 0; v < 4; ++v) {
+            poly[v] = corners[faces[f][v]];
+        }
+        for (size_t p = 0; p < 5 && vertCount > 0; ++p) {
+            size_t clippedCount = 0;
+            for (size_t v = 0; v < vertCount; ++v) {
+                const XMVECTOR curr = poly[v];
+                const XMVECTOR next = poly[(v + 1) % vertCount];
+                const float    dCurr = XMVectorGetX(SSE4::XMVector4Dot(planes[p], curr));
+                const float    dNext = XMVectorGetX(SSE4::XMVector4Dot(planes[p], next));
+                if (dCurr > 0.f) {
+                    clipped[clippedCount++] = curr;
+                }
+                if ((dCurr > 0.f) != (dNext > 0.f)) {
+                    clipped[clippedCount++] = curr + (dCurr / (dCurr - dNext)) * (next - curr);
+                }
+            }
+            memcpy(poly, clipped, clippedCount * sizeof(XMVECTOR));
+            vertCount = clippedCount;
+        }
+        if (vertCount > 0) return true;
+    }
+    return false;
+}
+
+// Runs the benchmark for the given camera pose, and accumulates the statistics.
+static inline void benchmarkPose(const BenchScene& scene, const PerspectiveCamera& pCam,
+                                 const size_t repCount, FrustumCuller& frustumCuller,
+                                 ObjectSortPair* objSortPairs, ObjectSortPair* sortedPairs,
+                                 DrawCommand* drawCommands, BenchStats& stats) {
+    const Frustum frustum = pCam.computeViewFrustum();
+    const size_t  n       = scene.objCount;
+    // Perform frustum culling.
+    size_t visObjCount = 0;
+    for (size_t r = 0; r < repCount; ++r) {
+        const Clock::time_point t0 = Clock::now();
+        visObjCount = 0;
+        for (uint32_t i = 0; i < n; ++i) {
+            float dist;
+            if (frustum.intersects(scene.boundingBoxes[i], &dist)) {
+                objSortPairs[visObjCount].key.depth = dist;
+                objSortPairs[visObjCount].index     = i;
+                ++visObjCount;
+            }
+        }
+        stats.totalCullTime += elapsedTime(t0);
+    }
+    // Sort the visible objects front to back.
+    for (size_t r = 0; r < repCount; ++r) {
+        memcpy(sortedPairs, objSortPairs, visObjCount * sizeof(ObjectSortPair));
+        const Clock::time_point t0 = Clock::now();
+        std::sort(sortedPairs, sortedPairs + visObjCount);
+        stats.totalSortTime += elapsedTime(t0);
+    }
+    // Construct the draw list.
+    size_t stateChangeCount = 0;
+    for (size_t r = 0; r < repCount; ++r) {
+        const Clock::time_point t0 = Clock::now();
+        stateChangeCount = recordDrawCommands(scene, sortedPairs, DrawRange{0, visObjCount},
+                                              drawCommands);
+        stats.totalDrawListTime += elapsedTime(t0);
+    }
+    // Perform incremental culling and sorting. It is stateful, so it is only run once.
+    {
+        const Clock::time_point t0 = Clock::now();
+        const size_t incrVisObjCount = frustumCuller.cull(pCam, scene.boundingBoxes.get(),
+                                                          sortedPairs);
+        stats.totalIncrCullTime   += elapsedTime(t0);
+        stats.totalTestedObjCount += frustumCuller.testedObjectCount();
+        if (incrVisObjCount != visObjCount) {
+            printWarning("Incremental culling: %zu visible objects instead of %zu.",
+                         incrVisObjCount, visObjCount);
+        }
+    }
+    // Refine the results of culling using the exact test.
+    size_t refinedVisObjCount = 0;
+    for (size_t r = 0; r < repCount; ++r) {
+        const Clock::time_point t0 = Clock::now();
+        refinedVisObjCount = 0;
+        for (size_t i = 0; i < visObjCount; ++i) {
+            if (frustum.intersectsExactly(scene.boundingBoxes[objSortPairs[i].index])) {
+                ++refinedVisObjCount;
+            }
+        }
+        stats.totalRefineTime += elapsedTime(t0);
+    }
+    // Compare against the reference test.
+    size_t falsePosCount = 0, refinedFalsePosCount = 0, refinedFalseNegCount = 0;
+    for (size_t i = 0; i < visObjCount; ++i) {
+        const AABox& aaBox = scene.boundingBoxes[objSortPairs[i].index];
+        const bool   isVisible = intersectsReference(frustum, aaBox);
+        const bool   isRefined = frustum.intersectsExactly(aaBox);
+        falsePosCount        += !isVisible;
+        refinedFalsePosCount += !isVisible && isRefined;
+        refinedFalseNegCount += isVisible && !isRefined;
+    }
+    stats.totalVisObjCount          += visObjCount;
+    stats.minVisObjCount             = std::min(stats.minVisObjCount, visObjCount);
+    stats.maxVisObjCount             = std::max(stats.maxVisObjCount, visObjCount);
+    stats.totalStateChangeCount     += stateChangeCount;
+    stats.totalFalsePosCount        += falsePosCount;
+    stats.totalRefinedVisObjCount   += refinedVisObjCount;
+    stats.totalRefinedFalsePosCount += refinedFalsePosCount;
+    stats.totalRefinedFalseNegCount += refinedFalseNegCount;
+}
+
+// Compares batched culling against 'frustumCount' frusta (formed by consecutive camera poses)
+// with sequential culling against each frustum.
+static inline void benchmarkFrustumSet(const BenchScene& scene,
+                                       const std::vector<PerspectiveCamera>& poses,
+                                       const size_t frustumCount, const size_t repCount) {
+    const size_t n = scene.objCount;
+    auto pairStorage  = std::make_unique<ObjectSortPair[]>(frustumCount * n);
+    auto objSortPairs = std::make_unique<ObjectSortPair*[]>(frustumCount);
+    auto visObjCounts = std::make_unique<size_t[]>(frustumCount);
+    auto seqObjCounts = std::make_unique<size_t[]>(frustumCount);
+    for (size_t k = 0; k < frustumCount; ++k) {
+        objSortPairs[k] = &pairStorage[k * n];
+    }
+    std::vector<Frustum> frusta(frustumCount);
+    double batchedTime = 0.0, sequentialTime = 0.0;
+    size_t mismatchCount = 0;
+    for (size_t p = 0, poseCount = poses.size(); p < poseCount; ++p) {
+        for (size_t k = 0; k < frustumCount; ++k) {
+            frusta[k] = poses[(p + k) % poseCount].computeViewFrustum();
+        }
+        const FrustumSet frustumSet{frusta.data(), frustumCount};
+        for (size_t r = 0; r < repCount; ++r) {
+            const Clock::time_point t0 = Clock::now();
+            frustumSet.cull(scene.boundingBoxes.get(), n, objSortPairs.get(), visObjCounts.get());
+            batchedTime += elapsedTime(t0);
+        }
+        for (size_t r = 0; r < repCount; ++r) {
+            const Clock::time_point t0 = Clock::now();
+            for (size_t k = 0; k < frustumCount; ++k) {
+                size_t visObjCount = 0;
+                for (uint32_t i = 0; i < n; ++i) {
+                    float dist;
+                    if (frusta[k].intersects(scene.boundingBoxes[i], &dist)) {
+                        objSortPairs[k][visObjCount].key.depth = dist;
+                        objSortPairs[k][visObjCount].index     = i;
+                        ++visObjCount;
+                    }
+                }
+                seqObjCounts[k] = visObjCount;
+            }
+            sequentialTime += elapsedTime(t0);
+        }
+        for (size_t k = 0; k < frustumCount; ++k) {
+            mismatchCount += std::max(visObjCounts[k], seqObjCounts[k])
+                           - std::min(visObjCounts[k], seqObjCounts[k]);
+        }
+    }
+    const double testCount = static_cast<double>(n * frustumCount * poses.size() * repCount);
+    printInfo("Batched culling:      %.2f ns/object/frustum (%zu frusta), "
+              "sequential: %.2f ns/object/frustum.",
+              batchedTime / testCount, frustumCount, sequentialTime / testCount);
+    printInfo("Batched culling:      %zu visibility mismatches (due to rounding).",
+              mismatchCount);
+}
+
+// Compares recording of the draw list into a single command list with parallel recording
+// into multiple command lists (using recordDrawCommands() as a stand-in for a command list).
+static inline void benchmarkParallelRecording(const BenchScene& scene,
+                                              const std::vector<PerspectiveCamera>& poses,
+                                              const size_t repCount) {
+    const size_t n = scene.objCount;
+    auto objSortPairs = std::make_unique<ObjectSortPair[]>(n);
+    auto serialCmds   = std::make_unique<DrawCommand[]>(n);
+    auto parallelCmds = std::make_unique<DrawCommand[]>(n);
+    auto stateChanges = std::make_unique<size_t[]>(MAX_GBUF_LISTS);
+    FrustumCuller frustumCuller{n};
+    const size_t threadCount = JobSystem::workerCount() + 1;
+    double serialTime = 0.0, parallelTime = 0.0;
+    size_t totalDrawCount = 0, totalListCount = 0, extraStateChangeCount = 0, mismatchCount = 0;
+    for (const PerspectiveCamera& pCam : poses) {
+        const size_t visObjCount = frustumCuller.cull(pCam, scene.boundingBoxes.get(),
+                                                      objSortPairs.get());
+        const size_t listCount   = computeCommandListCount(visObjCount, threadCount,
+                                                           MAX_GBUF_LISTS, MIN_LIST_DRAWS);
+        size_t serialStateChangeCount = 0;
+        for (size_t r = 0; r < repCount; ++r) {
+            const Clock::time_point t0 = Clock::now();
+            serialStateChangeCount = recordDrawCommands(scene, objSortPairs.get(),
+                                                        DrawRange{0, visObjCount},
+                                                        serialCmds.get());
+            serialTime += elapsedTime(t0);
+        }
+        for (size_t r = 0; r < repCount; ++r) {
+            const Clock::time_point t0 = Clock::now();
+            recordDraws(visObjCount, listCount, [&](size_t listIndex, DrawRange range) {
+                stateChanges[listIndex] = recordDrawCommands(scene, objSortPairs.get(), range,
+                                                             parallelCmds.get());
+            });
+            parallelTime += elapsedTime(t0);
+        }
+        // Concatenating the command lists must reproduce the serial draw list.
+        for (size_t i = 0; i < visObjCount; ++i) {
+            mismatchCount += serialCmds[i].materialIndex != parallelCmds[i].materialIndex ||
+                             serialCmds[i].indexCount    != parallelCmds[i].indexCount;
+        }
+        for (size_t k = 0; k < listCount; ++k) {
+            extraStateChangeCount += stateChanges[k];
+        }
+        extraStateChangeCount -= serialStateChangeCount;
+        totalDrawCount        += visObjCount;
+        totalListCount        += listCount;
+    }
+    const double drawCnt = std::max(static_cast<double>(totalDrawCount * repCount), 1.0);
+    const double poseCnt = static_cast<double>(poses.size());
+    printInfo("Parallel recording:   %.2f ns/draw (%.1f command lists on average), "
+              "serial: %.2f ns/draw.", parallelTime / drawCnt,
+              static_cast<double>(totalListCount) / poseCnt, serialTime / drawCnt);
+    printInfo("Parallel recording:   %.1f extra material changes on average, %zu mismatches.",
+              static_cast<double>(extraStateChangeCount) / poseCnt, mismatchCount);
+}
+
+// Records the draws of every pose into command streams (the null backend) in parallel,
+// and reports the throughput and the size of the streams.
+static inline void benchmarkCommandStreams(const BenchScene& scene,
+                                           const std::vector<PerspectiveCamera>& poses,
+                                           const size_t repCount) {
+    // D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE and D3D12_RESOURCE_STATE_RENDER_TARGET.
+    constexpr uint32_t stateSrv = 0x80, stateRtv = 0x4;
+    const size_t n = scene.objCount;
+    auto objSortPairs = std::make_unique<ObjectSortPair[]>(n);
+    auto streams      = std::make_unique<CommandStream[]>(MAX_GBUF_LISTS);
+    FrustumCuller frustumCuller{n};
+    const size_t threadCount = JobSystem::workerCount() + 1;
+    const float  matCols[12] = {};
+    double recTime  = 0.0;
+    size_t cmdCount = 0, byteCount = 0, mismatchCount = 0;
+    size_t objDrawCount = 0, drawCount = 0;
+    DrawCounts drawCounts[MAX_GBUF_LISTS];
+    for (const PerspectiveCamera& pCam : poses) {
+        const size_t visObjCount = frustumCuller.cull(pCam, scene.boundingBoxes.get(),
+                                                      objSortPairs.get());
+        const size_t listCount   = computeCommandListCount(visObjCount, threadCount,
+                                                           MAX_GBUF_LISTS, MIN_LIST_DRAWS);
+        for (size_t r = 0; r < repCount; ++r) {
+            const Clock::time_point t0 = Clock::now();
+            recordDraws(visObjCount, listCount, [&](size_t listIndex, DrawRange range) {
+                CommandStream& stream = streams[listIndex];
+                stream.clear();
+                if (0 == listIndex) {
+                    // Transition the G-buffer to the writable state.
+                    for (uint32_t k = 0; k < 5; ++k) {
+                        stream.transition(k, stateSrv, stateRtv);
+                    }
+                }
+                stream.setRootConstants(2, 12, matCols, 0);
+                stream.setIndexBuffer(0);
+                drawCounts[listIndex] = encodeDraws(stream, range, objSortPairs.get(),
+                                                    scene.drawPackets.get());
+            });
+            recTime += elapsedTime(t0);
+        }
+        for (size_t k = 0; k < listCount; ++k) {
+            cmdCount  += streams[k].commandCount();
+            byteCount += streams[k].size();
+            // Replaying the stream must reproduce all commands.
+            CommandCounter counter = {};
+            streams[k].replay(counter);
+            mismatchCount += counter.cmdCount != streams[k].commandCount();
+            objDrawCount  += drawCounts[k].objDrawCount;
+            drawCount     += drawCounts[k].drawCount;
+        }
+    }
+    const double poseCnt = static_cast<double>(poses.size());
+    const double cmdCnt  = static_cast<double>(cmdCount);
+    printInfo("Command streams:      %.1f M commands/s, %.1f commands/frame, "
+              "%.1f KiB/frame.", 1e3 * cmdCnt * static_cast<double>(repCount) / recTime,
+              cmdCnt / poseCnt, static_cast<double>(byteCount) / (1024.0 * poseCnt));
+    printInfo("Command streams:      %zu replay mismatches.", mismatchCount);
+    const double objDrawCnt = static_cast<double>(objDrawCount);
+    const double drawCnt    = static_cast<double>(drawCount);
+    printInfo("Draw coalescing:      %.1f draws/frame before, %.1f after (%.2f%% fewer).",
+              objDrawCnt / poseCnt, drawCnt / poseCnt,
+              100.0 * (objDrawCnt - drawCnt) / std::max(objDrawCnt, 1.0));
+}
+
+// Builds the indirect argument streams of every pose in parallel (one range per command list),
+// and reports the throughput and the size of the streams.
+static inline void benchmarkIndirectDraws(const BenchScene& scene,
+                                          const std::vector<PerspectiveCamera>& poses,
+                                          const size_t repCount) {
+    const size_t n = scene.objCount;
+    auto objSortPairs = std::make_unique<ObjectSortPair[]>(n);
+    auto draws        = std::make_unique<IndirectDraw[]>(n);
+    FrustumCuller frustumCuller{n};
+    const size_t threadCount = JobSystem::workerCount() + 1;
+    double buildTime = 0.0;
+    size_t visObjCount = 0, drawCount = 0, mismatchCount = 0;
+    DrawCounts drawCounts[MAX_GBUF_LISTS];
+    for (const PerspectiveCamera& pCam : poses) {
+        const size_t count     = frustumCuller.cull(pCam, scene.boundingBoxes.get(),
+                                                    objSortPairs.get());
+        const size_t listCount = computeCommandListCount(count, threadCount,
+                                                         MAX_GBUF_LISTS, MIN_LIST_DRAWS);
+        for (size_t r = 0; r < repCount; ++r) {
+            const Clock::time_point t0 = Clock::now();
+            recordDraws(count, listCount, [&](size_t listIndex, DrawRange range) {
+                drawCounts[listIndex] = buildIndirectDraws(range, objSortPairs.get(),
+                                                           scene.drawPackets.get(), 1,
+                                                           &draws[range.begin]);
+            });
+            buildTime += elapsedTime(t0);
+        }
+        // The records of each range must cover all indices of its visible objects.
+        for (size_t k = 0; k < listCount; ++k) {
+            const DrawRange range = computeDrawRange(count, listCount, k);
+            size_t objIndexCount = 0, drawIndexCount = 0;
+            for (size_t i = range.begin; i < range.end; ++i) {
+                objIndexCount += scene.drawPackets[objSortPairs[i].index].indexCount;
+            }
+            for (size_t i = 0; i < drawCounts[k].drawCount; ++i) {
+                const IndirectDraw& draw = draws[range.begin + i];
+                drawIndexCount += draw.args.indexCountPerInstance * draw.args.instanceCount;
+            }
+            mismatchCount += objIndexCount != drawIndexCount;
+            drawCount     += drawCounts[k].drawCount;
+        }
+        visObjCount += count;
+    }
+    const double poseCnt   = static_cast<double>(poses.size());
+    const double visObjCnt = static_cast<double>(visObjCount);
+    const double drawCnt   = static_cast<double>(drawCount);
+    printInfo("Indirect draws:       %.2f ns/visible object, %.1f draws/frame, "
+              "%.1f KiB/frame.", buildTime / (visObjCnt * static_cast<double>(repCount)),
+              drawCnt / poseCnt,
+              drawCnt * static_cast<double>(sizeof(IndirectDraw)) / (1024.0 * poseCnt));
+    printInfo("Indirect draws:       %zu index count mismatches.", mismatchCount);
+}
+
+// Intersects two random sets of 'bitCount' bits (like the visibility and the residency masks),
+// and iterates over the result. Compares the bulk operations with the per-bit loops,
+// and the flat bit set with the hierarchical one (which only visits the non-empty words).
+static inline void benchmarkBitSets(const size_t bitCount, const double density,
+                                    const size_t repCount) {
+    std::mt19937 rng{12345};
+    std::bernoulli_distribution bitDistr{density};
+    DynBitSet  a{bitCount},     b{bitCount};
+    HierBitSet hierA{bitCount}, hierB{bitCount};
+    for (size_t i = 0; i < bitCount; ++i) {
+        if (bitDistr(rng)) {
+            a.setBit(i);
+            hierA.setBit(i);
+        }
+        if (bitDistr(rng)) {
+            b.setBit(i);
+            hierB.setBit(i);
+        }
+    }
+    DynBitSet  perBit{bitCount}, bulk{bitCount};
+    HierBitSet hier{bitCount};
+    double perBitTime = 0.0, bulkTime = 0.0, hierTime = 0.0;
+    size_t perBitSum  = 0,   bulkSum  = 0,   hierSum  = 0;
+    for (size_t r = 0; r < repCount; ++r) {
+        Clock::time_point t0 = Clock::now();
+        for (size_t i = 0; i < bitCount; ++i) {
+            if (a.testBit(i) && b.testBit(i)) {
+                perBit.setBit(i);
+            } else {
+                perBit.clearBit(i);
+            }
+        }
+        for (size_t i = 0; i < bitCount; ++i) {
+            if (perBit.testBit(i)) perBitSum += i;
+        }
+        perBitTime += elapsedTime(t0);
+        t0 = Clock::now();
+        bulk  = a;
+        bulk &= b;
+        bulk.forEachSetBit([&bulkSum](const size_t index) { bulkSum += index; });
+        bulkTime += elapsedTime(t0);
+        t0 = Clock::now();
+        hier.clear();
+        hier |= hierA;
+        hier &= hierB;
+        hier.forEachSetBit([&hierSum](const size_t index) { hierSum += index; });
+        hierTime += elapsedTime(t0);
+    }
+    // All methods must produce the same set, and visit the same indices.
+    size_t mismatchCount = (perBitSum != bulkSum) + (perBitSum != hierSum);
+    for (size_t i = 0; i < bitCount; ++i) {
+        mismatchCount += perBit.testBit(i) != bulk.testBit(i);
+        mismatchCount += perBit.testBit(i) != hier.testBit(i);
+    }
+    const double bitCnt = static_cast<double>(bitCount) * static_cast<double>(repCount);
+    printInfo("Bit sets:             %zu bits, %.1f%% set: per-bit: %.3f ns/bit, "
+              "bulk: %.3f ns/bit, hierarchical: %.3f ns/bit.", bitCount, 100.0 * density,
+              perBitTime / bitCnt, bulkTime / bitCnt, hierTime / bitCnt);
+    printInfo("Bit sets:             %zu mismatches.", mismatchCount);
+}
+
+// Allocates write-combined memory (like the upload heap). Returns nullptr on failure.
+// Other platforms do not expose write combining to user mode, so ordinary pages are used.
+static inline auto allocateUploadMemory(const size_t size)
+-> byte_t* {
+    #ifdef _WIN32
+        return static_cast<byte_t*>(VirtualAlloc(nullptr, size, MEM_COMMIT | MEM_RESERVE,
+                                                 PAGE_READWRITE | PAGE_WRITECOMBINE));
+    #else
+        void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        return (MAP_FAILED != memory) ? static_cast<byte_t*>(memory) : nullptr;
+    #endif
+}
+
+// Frees the memory allocated by allocateUploadMemory().
+static inline void freeUploadMemory(byte_t* memory, const size_t size) {
+    #ifdef _WIN32
+        (void)size;
+        VirtualFree(memory, 0, MEM_RELEASE);
+    #else
+        munmap(memory, size);
+    #endif
+}
+
+// Copies the MIP chain of a 'texSize' x 'texSize' RGBA8 texture into write-combined memory
+// (like the upload heap), converting the row pitch to the one required by Direct3D 12.
+// Compares the row-by-row copy using memcpy() with single-threaded and parallel streaming copies.
+static inline void benchmarkUploadCopy(const uint32_t texSize, const size_t repCount) {
+    struct MipLevel {
+        size_t srcOffset, dstOffset;
+        size_t srcPitch,  dstPitch;
+        size_t height;
+    };
+    std::vector<MipLevel> mipLevels;
+    size_t srcSize = 0, dstSize = 0;
+    for (uint32_t size = texSize; ; size = std::max(1u, size / 2)) {
+        const size_t srcPitch = size_t{size} * 4;
+        const size_t dstPitch = (srcPitch + 255) & ~size_t{255};
+        mipLevels.push_back(MipLevel{srcSize, dstSize, srcPitch, dstPitch, size});
+        srcSize += srcPitch * size;
+        // Each MIP level is aligned to 512 bytes.
+        dstSize  = (dstSize + dstPitch * size + 511) & ~size_t{511};
+        if (1 == size) break;
+    }
+    auto src = std::make_unique<byte_t[]>(srcSize);
+    for (size_t i = 0; i < srcSize; ++i) {
+        src[i] = static_cast<byte_t>(i * 7 + (i >> 12));
+    }
+    byte_t* dst = allocateUploadMemory(dstSize);
+    if (!dst) {
+        printError("Failed to allocate write-combined memory.");
+        return;
+    }
+    const auto copyMemcpy = [](byte_t* d, size_t dPitch, const byte_t* s, size_t sPitch,
+                               size_t rowSize, size_t rowCount) {
+        for (size_t row = 0; row < rowCount; ++row) {
+            memcpy(d + row * dPitch, s + row * sPitch, rowSize);
+        }
+    };
+    // Returns the number of rows which differ from the source.
+    const auto countMismatches = [&]() {
+        size_t mismatchCount = 0;
+        for (const MipLevel& level : mipLevels) {
+            for (size_t row = 0; row < level.height; ++row) {
+                mismatchCount += 0 != memcmp(dst + level.dstOffset + row * level.dstPitch,
+                                             &src[level.srcOffset + row * level.srcPitch],
+                                             level.srcPitch);
+            }
+        }
+        return mismatchCount;
+    };
+    // Returns the time of the copy of the entire MIP chain in nanoseconds.
+    // Clearing the destination commits its pages before timing, and ensures that
+    // the validation only passes if the copy writes every row.
+    size_t mismatchCount = 0;
+    const auto timeCopy = [&](auto&& copy) {
+        memset(dst, 0, dstSize);
+        double time = 0.0;
+        for (size_t r = 0; r < repCount; ++r) {
+            const Clock::time_point t0 = Clock::now();
+            for (const MipLevel& level : mipLevels) {
+                copy(dst + level.dstOffset, level.dstPitch, &src[level.srcOffset],
+                     level.srcPitch, level.srcPitch, level.height);
+            }
+            time += elapsedTime(t0);
+        }
+        mismatchCount += countMismatches();
+        return time / static_cast<double>(repCount);
+    };
+    const double memcpyTime   = timeCopy(copyMemcpy);
+    const double streamTime   = timeCopy(streamCopyRows);
+    const double parallelTime = timeCopy(parallelStreamCopyRows);
+    freeUploadMemory(dst, dstSize);
+    // Bytes per nanosecond are gigabytes per second.
+    const double size = static_cast<double>(srcSize);
+    printInfo("Upload copy:          %u x %u MIP chain, %.1f MiB.", texSize, texSize,
+              size / (1024.0 * 1024.0));
+    printInfo("Upload copy:          memcpy: %.2f GB/s, streaming: %.2f GB/s, "
+              "parallel streaming: %.2f GB/s.", size / memcpyTime, size / streamTime,
+              size / parallelTime);
+    printInfo("Upload copy:          %zu row mismatches (all copies).", mismatchCount);
+}
+
+int __cdecl main(const int argc, const char* argv[]) {
+    const char* scenePath    = nullptr;
+    const char* objFileName  = nullptr;
+    const char* camPathName  = nullptr;
+    size_t      synthObjCnt  = 100000;
+    size_t      poseCount    = 256;
+    size_t      repCount     = 8;
+    size_t      frustumCount = 4;
+    // Parse command line arguments.
+    for (int i = 1; i < argc; ++i) {
+        if (0 == strcmp(argv[i], "-scene") && i + 2 < argc) {
+            scenePath   = argv[++i];
+            objFileName = argv[++i];
+        } else if (0 == strcmp(argv[i], "-synthetic") && i + 1 < argc) {
+            synthObjCnt = strtoull(argv[++i], nullptr, 10);
+        } else if (0 == strcmp(argv[i], "-path") && i + 1 < argc) {
+            camPathName = argv[++i];
+        } else if (0 == strcmp(argv[i], "-poses") && i + 1 < argc) {
+            poseCount = strtoull(argv[++i], nullptr, 10);
+        } else if (0 == strcmp(argv[i], "-reps") && i + 1 < argc) {
+            repCount = strtoull(argv[++i], nullptr, 10);
+        } else if (0 == strcmp(argv[i], "-frusta") && i + 1 < argc) {
+            frustumCount = strtoull(argv[++i], nullptr, 10);
+        } else {
+            printError("Usage: %s [-scene <path> <file.obj> | -synthetic <object count>] "
+                       "[-path <file> | -poses <count>] [-reps <count>] [-frusta <count>]",
+                       argv[0]);
+            return -1;
+        }
+    }
+    if (0 == poseCount || 0 == repCount || 0 == frustumCount) {
+        printError("The pose, the repetition and the frustum counts must be positive.");
+        return -1;
+    }
+    // Verify SSE4.1 support for the DirectXMath library.
+    if (!SSE4::XMVerifySSE4Support()) {
+        printError("The CPU doesn't support SSE4.1. Aborting.");
+        return -1;
+    }
+    // Start the worker threads (used by the loader and the parallel recording benchmark).
+    JobSystem::start();
+    // Load or generate the scene.
+    const BenchScene scene = scenePath ? loadScene(scenePath, objFileName)
+                                       : generateScene(synthObjCnt);
+    const size_t n = scene.objCount;
+    if (0 == n) {
+        printError("The scene contains no objects.");
+        JobSystem::stop();
+        return -1;
+    }
+    // Replay the recorded camera path, or generate a closed path.
+    const std::vector<PerspectiveCamera> poses = camPathName
+                                               ? loadCameraPoses(camPathName)
+                                               : generateCameraPoses(scene.bounds, poseCount);
+    if (poses.empty()) {
+        printError("The camera path is empty.");
+        JobSystem::stop();
+        return -1;
+    }
+    poseCount = poses.size();
+    // Allocate the working memory.
+    auto objSortPairs = std::make_unique<ObjectSortPair[]>(n);
+    auto sortedPairs  = std::make_unique<ObjectSortPair[]>(n);
+    auto drawCommands = std::make_unique<DrawCommand[]>(n);
+    FrustumCuller frustumCuller{n};
+    // Run the benchmark.
+    BenchStats stats     = {};
+    stats.minVisObjCount = SIZE_MAX;
+    for (const PerspectiveCamera& pCam : poses) {
+        benchmarkPose(scene, pCam, repCount, frustumCuller, objSortPairs.get(),
+                      sortedPairs.get(), drawCommands.get(), stats);
+    }
+    // Report the results.
+    const double poseCnt     = static_cast<double>(poseCount);
+    const double repCnt      = static_cast<double>(repCount);
+    const double objCnt      = static_cast<double>(n) * poseCnt;
+    const double visObjCnt   = std::max(static_cast<double>(stats.totalVisObjCount), 1.0);
+    const double savedObjCnt = static_cast<double>(stats.totalVisObjCount
+                                                 - stats.totalRefinedVisObjCount);
+    printInfo("Objects: %zu, camera poses: %zu, repetitions: %zu.", n, poseCount, repCount);
+    printInfo("Visible objects:      %.1f on average (min: %zu, max: %zu).",
+              static_cast<double>(stats.totalVisObjCount) / poseCnt,
+              stats.minVisObjCount, stats.maxVisObjCount);
+    printInfo("Material changes:     %.1f on average.",
+              static_cast<double>(stats.totalStateChangeCount) / poseCnt);
+    printInfo("Frustum culling:      %.2f ns/object.", stats.totalCullTime / (objCnt * repCnt));
+    printInfo("Sorting:              %.2f ns/visible object.",
+              stats.totalSortTime / (visObjCnt * repCnt));
+    printInfo("Draw list:            %.2f ns/visible object.",
+              stats.totalDrawListTime / (visObjCnt * repCnt));
+    printInfo("Incremental culling:  %.2f ns/object (incl. sorting), %.1f%% objects tested.",
+              stats.totalIncrCullTime / objCnt,
+              100.0 * static_cast<double>(stats.totalTestedObjCount) / objCnt);
+    printInfo("False positives:      %zu in total, %.2f%% of visible objects.",
+              stats.totalFalsePosCount,
+              100.0 * static_cast<double>(stats.totalFalsePosCount) / visObjCnt);
+    printInfo("Exact refinement:     %.2f ns/visible object.",
+              stats.totalRefineTime / (visObjCnt * repCnt));
+    printInfo("Draws saved:          %.1f on average, %.2f%% of visible objects.",
+              savedObjCnt / poseCnt, 100.0 * savedObjCnt / visObjCnt);
+    printInfo("After refinement:     %zu false positives, %zu false negatives.",
+              stats.totalRefinedFalsePosCount, stats.totalRefinedFalseNegCount);
+    // Run the batched culling benchmark.
+    benchmarkFrustumSet(scene, poses, frustumCount, repCount);
+    // Run the parallel recording benchmark.
+    benchmarkParallelRecording(scene, poses, repCount);
+    // Run the command stream benchmark.
+    benchmarkCommandStreams(scene, poses, repCount);
+    // Run the indirect argument stream benchmark.
+    benchmarkIndirectDraws(scene, poses, repCount);
+    // Run the bit set benchmark (dense and sparse visibility sets of 1M objects).
+    benchmarkBitSets(1 << 20, 0.5,   repCount);
+    benchmarkBitSets(1 << 20, 0.001, repCount);
+    // Run the upload copy benchmark. The texture size is not a multiple of 64,
+    // so the pitch of every MIP level has to be converted.
+    benchmarkUploadCopy(4000, repCount);
+    JobSystem::stop();
+    return 0;
+}
@@ -46,6 +46,10 @@ XMMATRIX PerspectiveCamera::projectionMatrix() const {
     return XMLoadFloat4x4A(&m_projMat);
 }
 
+XMVECTOR PerspectiveCamera::resolution() const {
+    return XMLoadFloat2A(&m_resolution);
+}
+
 XMVECTOR PerspectiveCamera::computeForwardDir() const {
     const XMMATRIX orientMat = orientationMatrix();
     return orientMat.r[2];
@@ -150,6 +154,14 @@ Frustum PerspectiveCamera::computeViewFrustum() const {
     for (size_t i = 0; i < 8; ++i) {
         frustum.m_bBox.extend(frustumCorners[i] / XMVectorGetW(frustumCorners[i]));
     }
+    // Compute the separating axes using the corners lying on the far plane.
+    const XMVECTOR farCorners[4] = {
+        frustumCorners[0] / XMVectorGetW(frustumCorners[0]),
+        frustumCorners[1] / XMVectorGetW(frustumCorners[1]),
+        frustumCorners[2] / XMVectorGetW(frustumCorners[2]),
+        frustumCorners[3] / XMVectorGetW(frustumCorners[3])
+    };
+    frustum.computeSeparatingAxes(farCorners, position());
     return frustum;
 }
 
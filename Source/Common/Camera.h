@@ -30,6 +30,8 @@ public:
     void setOrientation(DirectX::FXMVECTOR orientQuat);
     // Returns the projection matrix.
     DirectX::XMMATRIX projectionMatrix() const;
+    // Returns the dimensions of the sensor (in pixels) in the X and Y components.
+    DirectX::XMVECTOR resolution() const;
     // Returns the normalized direction along the optical axis.
     DirectX::XMVECTOR computeForwardDir() const;
     // Returns the view matrix.
@@ -0,0 +1,138 @@
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include "Camera.h"
+#include "CameraPath.h"
+#include "Utility.h"
+
+using namespace DirectX;
+
+// File header. The header is followed by an array of poses.
+struct CameraPathHeader {
+    char     magic[4];    // "RXCP"
+    uint32_t version;
+    uint32_t poseCount;
+};
+
+static constexpr char     CAM_PATH_MAGIC[4] = {'R', 'X', 'C', 'P'};
+static constexpr uint32_t CAM_PATH_VERSION  = 1;
+
+CameraPath::CameraPath(const char* fileWithPath) {
+    FILE* file;
+    // Open the file.
+    if (fopen_s(&file, fileWithPath, "rb")) {
+        printError("File not found: %s", fileWithPath);
+        TERMINATE();
+    }
+    // Read and validate the header.
+    CameraPathHeader header;
+    if (1 != fread(&header, sizeof(header), 1, file) ||
+        0 != memcmp(header.magic, CAM_PATH_MAGIC, sizeof(CAM_PATH_MAGIC)) ||
+        CAM_PATH_VERSION != header.version) {
+        printError("Invalid camera path file: %s", fileWithPath);
+        TERMINATE();
+    }
+    if (0 == header.poseCount) {
+        printError("Empty camera path file: %s", fileWithPath);
+        TERMINATE();
+    }
+    // The poses follow the header. Check the size of the file before allocating memory,
+    // so that a corrupt header cannot cause an excessive allocation.
+    const long posesBegin = ftell(file);
+    fseek(file, 0, SEEK_END);
+    const long fileSize = ftell(file);
+    fseek(file, posesBegin, SEEK_SET);
+    if (posesBegin < 0 || fileSize < posesBegin ||
+        static_cast<uint64_t>(fileSize - posesBegin) / sizeof(Pose) < header.poseCount) {
+        printError("Truncated camera path file: %s", fileWithPath);
+        TERMINATE();
+    }
+    // Read the poses.
+    m_poses.resize(header.poseCount);
+    if (header.poseCount != fread(m_poses.data(), sizeof(Pose), header.poseCount, file)) {
+        printError("Truncated camera path file: %s", fileWithPath);
+        TERMINATE();
+    }
+    // The poses are looked up using binary search, so they must be sorted by time.
+    for (size_t i = 1; i < m_poses.size(); ++i) {
+        if (!(m_poses[i - 1].time <= m_poses[i].time)) {
+            printError("The poses of the camera path are not sorted by time: %s", fileWithPath);
+            TERMINATE();
+        }
+    }
+    // Close the file.
+    fclose(file);
+    printInfo("Loaded a camera path with %u poses (%.2f seconds).",
+              header.poseCount, duration());
+}
+
+bool CameraPath::save(const char* fileWithPath) const {
+    // An empty path cannot be played back.
+    if (m_poses.empty()) {
+        printError("Refusing to save an empty camera path: %s", fileWithPath);
+        return false;
+    }
+    FILE* file;
+    // Open the file.
+    if (fopen_s(&file, fileWithPath, "wb")) {
+        printError("Failed to create the file: %s", fileWithPath);
+        return false;
+    }
+    // Write the header followed by the poses.
+    CameraPathHeader header;
+    memcpy(header.magic, CAM_PATH_MAGIC, sizeof(CAM_PATH_MAGIC));
+    header.version   = CAM_PATH_VERSION;
+    header.poseCount = static_cast<uint32_t>(m_poses.size());
+    const bool success = 1 == fwrite(&header, sizeof(header), 1, file) &&
+                         m_poses.size() == fwrite(m_poses.data(), sizeof(Pose),
+                                                  m_poses.size(), file);
+    // Close the file.
+    fclose(file);
+    if (!success) {
+        printError("Failed to write the file: %s", fileWithPath);
+    }
+    return success;
+}
+
+void CameraPath::record(const PerspectiveCamera& pCam, const float time) {
+    assert(m_poses.empty() || m_poses.back().time <= time);
+    Pose pose;
+    XMStoreFloat3(&pose.position,   pCam.position());
+    XMStoreFloat4(&pose.orientQuat, pCam.orientationQuaternion());
+    pose.time = time;
+    m_poses.push_back(pose);
+}
+
+void CameraPath::applyPose(const float time, PerspectiveCamera* pCam) const {
+    assert(!m_poses.empty() && pCam);
+    // Find the first pose recorded after 'time'.
+    const auto next = std::upper_bound(m_poses.begin(), m_poses.end(), time,
+                                       [](const float t, const Pose& pose) {
+                                           return t < pose.time;
+                                       });
+    XMVECTOR position, orientQuat;
+    if (next == m_poses.begin() || next == m_poses.end()) {
+        // Clamp the time to the duration of the path.
+        const Pose& pose = (next == m_poses.begin()) ? m_poses.front() : m_poses.back();
+        position   = XMLoadFloat3(&pose.position);
+        orientQuat = XMLoadFloat4(&pose.orientQuat);
+    } else {
+        // Interpolate between the two poses.
+        const Pose& pose0 = *(next - 1);
+        const Pose& pose1 = *next;
+        const float t     = (time - pose0.time) / (pose1.time - pose0.time);
+        position   = XMVectorLerp(XMLoadFloat3(&pose0.position), XMLoadFloat3(&pose1.position), t);
+        orientQuat = XMQuaternionSlerp(XMLoadFloat4(&pose0.orientQuat),
+                                       XMLoadFloat4(&pose1.orientQuat), t);
+    }
+    pCam->setPosition(position);
+    pCam->setOrientation(orientQuat);
+}
+
+float CameraPath::duration() const {
+    return m_poses.empty() ? 0.f : m_poses.back().time;
+}
+
+size_t CameraPath::poseCount() const {
+    return m_poses.size();
+}
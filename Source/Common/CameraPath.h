@@ -0,0 +1,39 @@
+#pragma once
+
+#include <vector>
+#include <DirectXMathSSE4.h>
+#include "Definitions.h"
+
+class PerspectiveCamera;
+
+// Sequence of camera poses (position and orientation) sampled over time.
+// Used to record the motion of the camera, and to replay it deterministically.
+class CameraPath {
+public:
+    RULE_OF_ZERO_MOVE_ONLY(CameraPath);
+    // Constructs an empty path.
+    CameraPath() = default;
+    // Loads the path from the file. Terminates if the file is invalid, the path is empty,
+    // or the poses are not sorted by time.
+    explicit CameraPath(const char* fileWithPath);
+    // Saves the path to the file. Returns 'false' on failure, or if the path is empty.
+    bool save(const char* fileWithPath) const;
+    // Appends the pose of the camera at the specified time (in seconds).
+    // The time must not be smaller than the time of the last recorded pose.
+    void record(const PerspectiveCamera& pCam, const float time);
+    // Sets the pose of the camera to the pose on the path at the specified time (in seconds).
+    // The position is interpolated linearly, and the orientation - spherically.
+    // The time is clamped to the duration of the path. The path must not be empty.
+    void applyPose(const float time, PerspectiveCamera* pCam) const;
+    // Returns the time of the last recorded pose (in seconds).
+    float duration() const;
+    // Returns the number of recorded poses.
+    size_t poseCount() const;
+private:
+    struct Pose {
+        DirectX::XMFLOAT3 position;    // Position
+        DirectX::XMFLOAT4 orientQuat;  // Orientation (quaternion)
+        float             time;        // Time stamp (in seconds)
+    };
+    std::vector<Pose> m_poses; // Sorted by time
+};
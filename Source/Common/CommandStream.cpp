@@ -0,0 +1,97 @@
+#include <algorithm>
+#include "CommandStream.hpp"
+
+// Writes the value of type T (possibly unaligned), and advances the pointer.
+template <typename T>
+static inline void writeValue(const T value, byte_t*& ptr) {
+    memcpy(ptr, &value, sizeof(T));
+    ptr += sizeof(T);
+}
+
+CommandStream::CommandStream()
+    : m_data{nullptr}
+    , m_size{0}
+    , m_capacity{0}
+    , m_cmdCount{0} {}
+
+CommandStream::CommandStream(const size_t capacity)
+    : m_data{std::make_unique<byte_t[]>(capacity)}
+    , m_size{0}
+    , m_capacity{capacity}
+    , m_cmdCount{0} {}
+
+void CommandStream::transition(const uint32_t resource, const uint32_t stateBefore,
+                               const uint32_t stateAfter, const uint32_t flags) {
+    byte_t* ptr = append(CmdOpcode::TRANSITION, 4 * sizeof(uint32_t));
+    writeValue(resource,    ptr);
+    writeValue(stateBefore, ptr);
+    writeValue(stateAfter,  ptr);
+    writeValue(flags,       ptr);
+}
+
+void CommandStream::setRootConstants(const uint32_t param, const uint32_t count,
+                                     const void* data, const uint32_t offset) {
+    // Root signatures are limited to 64 DWORDs.
+    assert(param < 64 && count <= 64 && offset < 64);
+    const size_t size = count * sizeof(uint32_t);
+    byte_t* ptr = append(CmdOpcode::SET_ROOT_CONSTANTS, 3 * sizeof(uint8_t) + size);
+    writeValue(static_cast<uint8_t>(param),  ptr);
+    writeValue(static_cast<uint8_t>(count),  ptr);
+    writeValue(static_cast<uint8_t>(offset), ptr);
+    memcpy(ptr, data, size);
+}
+
+void CommandStream::setRootConstant(const uint32_t param, const uint32_t value,
+                                    const uint32_t offset) {
+    setRootConstants(param, 1, &value, offset);
+}
+
+void CommandStream::setDescriptorTable(const uint32_t param, const uint32_t texIndex) {
+    assert(param < 64);
+    byte_t* ptr = append(CmdOpcode::SET_DESCRIPTOR_TABLE, sizeof(uint8_t) + sizeof(uint32_t));
+    writeValue(static_cast<uint8_t>(param), ptr);
+    writeValue(texIndex,                    ptr);
+}
+
+void CommandStream::setIndexBuffer(const uint32_t buffer) {
+    byte_t* ptr = append(CmdOpcode::SET_INDEX_BUFFER, sizeof(uint32_t));
+    writeValue(buffer, ptr);
+}
+
+void CommandStream::drawIndexed(const uint32_t indexCount, const uint32_t firstIndex) {
+    byte_t* ptr = append(CmdOpcode::DRAW_INDEXED, 2 * sizeof(uint32_t));
+    writeValue(indexCount, ptr);
+    writeValue(firstIndex, ptr);
+}
+
+void CommandStream::clear() {
+    m_size     = 0;
+    m_cmdCount = 0;
+}
+
+size_t CommandStream::commandCount() const {
+    return m_cmdCount;
+}
+
+size_t CommandStream::size() const {
+    return m_size;
+}
+
+byte_t* CommandStream::append(const CmdOpcode opcode, const size_t size) {
+    const size_t newSize = m_size + 1 + size;
+    if (newSize > m_capacity) {
+        // Grow the stream geometrically.
+        const size_t newCapacity = std::max(newSize, 2 * m_capacity);
+        auto data = std::make_unique<byte_t[]>(newCapacity);
+        if (m_size > 0) {
+            memcpy(data.get(), m_data.get(), m_size);
+        }
+        m_data     = std::move(data);
+        m_capacity = newCapacity;
+    }
+    byte_t* ptr = &m_data[m_size];
+    *ptr++      = static_cast<byte_t>(opcode);
+    m_size      = newSize;
+    ++m_cmdCount;
+    return ptr;
+}
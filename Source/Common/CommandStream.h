@@ -0,0 +1,61 @@
+#pragma once
+
+#include <memory>
+#include "Definitions.h"
+
+// Opcodes of the commands stored in a command stream.
+enum class CmdOpcode : uint8_t {
+    TRANSITION,             // Resource state transition barrier
+    SET_ROOT_CONSTANTS,     // 32-bit root constants
+    SET_DESCRIPTOR_TABLE,   // Root descriptor table (identified by the texture index)
+    SET_INDEX_BUFFER,       // Index buffer (identified by the buffer index)
+    DRAW_INDEXED,           // Indexed draw using the current index buffer
+    COUNT
+};
+
+// Backend-agnostic command stream. Serves as the null (recording) backend:
+// the commands are stored in memory in a compact binary form (a 1-byte opcode followed
+// by the arguments), and can later be replayed into another backend.
+// All command encoders (e.g. D3D12::CommandEncoder) implement the same set of commands.
+// Resources, buffers and textures are identified by indices.
+class CommandStream {
+public:
+    RULE_OF_ZERO_MOVE_ONLY(CommandStream);
+    // Ctor; performs zero-initialization.
+    CommandStream();
+    // Ctor; takes the initial capacity (in bytes) as input. The stream grows as necessary.
+    explicit CommandStream(const size_t capacity);
+    // Transitions the resource with the specified index from 'stateBefore' to 'stateAfter'.
+    // The states and the flags use the values of the Direct3D 12 enumerations.
+    void transition(const uint32_t resource, const uint32_t stateBefore,
+                    const uint32_t stateAfter, const uint32_t flags = 0);
+    // Sets 'count' 32-bit root constants of the root parameter, starting at 'offset'.
+    void setRootConstants(const uint32_t param, const uint32_t count, const void* data,
+                          const uint32_t offset);
+    // Sets a single 32-bit root constant of the root parameter at 'offset'.
+    void setRootConstant(const uint32_t param, const uint32_t value, const uint32_t offset);
+    // Sets the descriptor table of the root parameter to start at the texture descriptor.
+    void setDescriptorTable(const uint32_t param, const uint32_t texIndex);
+    // Sets the index buffer with the specified index.
+    void setIndexBuffer(const uint32_t buffer);
+    // Draws 'indexCount' indices of the current index buffer, starting with 'firstIndex'.
+    void drawIndexed(const uint32_t indexCount, const uint32_t firstIndex);
+    // Discards all commands, but keeps the memory.
+    void clear();
+    // Replays all commands into the encoder.
+    template <typename Encoder>
+    void replay(Encoder& encoder) const;
+    // Returns the number of commands.
+    size_t commandCount() const;
+    // Returns the size (in bytes) of the stream.
+    size_t size() const;
+private:
+    // Appends the opcode of the command followed by 'size' bytes of arguments.
+    // Returns the address of the arguments.
+    byte_t* append(const CmdOpcode opcode, const size_t size);
+private:
+    std::unique_ptr<byte_t[]> m_data;
+    size_t                    m_size;
+    size_t                    m_capacity;
+    size_t                    m_cmdCount;
+};
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cassert>
+#include <cstring>
+#include "CommandStream.h"
+
+// Reads a value of type T (possibly unaligned), and advances the pointer.
+template <typename T>
+static inline auto readValue(const byte_t*& ptr)
+-> T {
+    T value;
+    memcpy(&value, ptr, sizeof(T));
+    ptr += sizeof(T);
+    return value;
+}
+
+template <typename Encoder>
+inline void CommandStream::replay(Encoder& encoder) const {
+    const byte_t* ptr = m_data.get();
+    const byte_t* end = ptr + m_size;
+    while (ptr < end) {
+        switch (static_cast<CmdOpcode>(*ptr++)) {
+            case CmdOpcode::TRANSITION:
+                {
+                    const uint32_t resource    = readValue<uint32_t>(ptr);
+                    const uint32_t stateBefore = readValue<uint32_t>(ptr);
+                    const uint32_t stateAfter  = readValue<uint32_t>(ptr);
+                    const uint32_t flags       = readValue<uint32_t>(ptr);
+                    encoder.transition(resource, stateBefore, stateAfter, flags);
+                }
+                break;
+            case CmdOpcode::SET_ROOT_CONSTANTS:
+                {
+                    const uint32_t param  = readValue<uint8_t>(ptr);
+                    const uint32_t count  = readValue<uint8_t>(ptr);
+                    const uint32_t offset = readValue<uint8_t>(ptr);
+                    encoder.setRootConstants(param, count, ptr, offset);
+                    ptr += count * sizeof(uint32_t);
+                }
+                break;
+            case CmdOpcode::SET_DESCRIPTOR_TABLE:
+                {
+                    const uint32_t param    = readValue<uint8_t>(ptr);
+                    const uint32_t texIndex = readValue<uint32_t>(ptr);
+                    encoder.setDescriptorTable(param, texIndex);
+                }
+                break;
+            case CmdOpcode::SET_INDEX_BUFFER:
+                encoder.setIndexBuffer(readValue<uint32_t>(ptr));
+                break;
+            case CmdOpcode::DRAW_INDEXED:
+                {
+                    const uint32_t indexCount = readValue<uint32_t>(ptr);
+                    const uint32_t firstIndex = readValue<uint32_t>(ptr);
+                    encoder.drawIndexed(indexCount, firstIndex);
+                }
+                break;
+            default:
+                assert(false && "Invalid command opcode.");
+                return;
+        }
+    }
+}
@@ -1,11 +1,29 @@
 #pragma once
 
-// Typedefs for dxgitype.h.
-using BOOL = int;
-using BYTE = unsigned char;
-using UINT = unsigned int;
+#ifdef _WIN32
+    // Typedefs for dxgitype.h.
+    using BOOL = int;
+    using BYTE = unsigned char;
+    using UINT = unsigned int;
 
-#include <dxgitype.h>
+    #include <dxgitype.h>
+#endif
+
+// The C library may define the mathematical constants as macros (e.g. glibc does).
+#include <cmath>
+#undef M_E
+#undef M_LOG2E
+#undef M_LOG10E
+#undef M_LN2
+#undef M_LN10
+#undef M_PI
+#undef M_PI_2
+#undef M_PI_4
+#undef M_1_PI
+#undef M_2_PI
+#undef M_2_SQRTPI
+#undef M_SQRT2
+#undef M_SQRT1_2
 
 // Mathematical constants.
 constexpr float M_E            = 2.71828175f;   // e
@@ -29,9 +47,10 @@ constexpr auto RES_X           = 1280;
 constexpr auto RES_Y           = 720;
 // Vertical field of view (in radians).
 constexpr auto VERTICAL_FOV    = M_PI / 3.f;
-// Maximal texture count.
-constexpr auto TEX_CNT         = 256;
-// Maximal number of materials.
+// Capacity of the texture descriptor pool. A shader-visible descriptor heap cannot be resized
+// while it is in use, so the pool is large (512 KiB), and its slots are recycled.
+constexpr auto TEX_CNT         = 16384;
+// Initial capacity of the material buffer. It grows on demand.
 constexpr auto MAT_CNT         = 32;
 // Double/triple buffering.
 constexpr auto BUF_CNT         = 3;
@@ -45,6 +64,8 @@ constexpr auto FRAME_CNT       = 2;
 constexpr auto VSYNC_INTERVAL  = 0;
 // Software rendering flag.
 constexpr bool USE_WARP_DEVICE = false;
+// DXGI types are only available on Windows (headless builds do not use them).
+#ifdef _WIN32
 // Normal texture's format.
 constexpr auto FORMAT_NORMAL   = DXGI_FORMAT_R16G16_SNORM;
 // UV coordinate texture's format.
@@ -59,13 +80,47 @@ constexpr auto FORMAT_SC       = DXGI_FORMAT_R8G8B8A8_UNORM;
 constexpr auto FORMAT_RTV      = DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
 // Primary depth stencil view's format.
 constexpr auto FORMAT_DSV      = DXGI_FORMAT_D24_UNORM_S8_UINT;
+// Default sampling mode (no multi-sampling).
+constexpr auto SINGLE_SAMPLE   = DXGI_SAMPLE_DESC{1, 0};
+#endif
 // Upload buffer size (32 MiB).
 constexpr auto UPLOAD_BUF_SIZE = 32 * 1024 * 1024;
-// Temporary allocator's buffer size (4 KiB).
-constexpr auto TEMP_DATA_SIZE = 4 * 1024;
+// Maximal number of upload buffer segments in flight.
+constexpr auto UPLOAD_SEG_CNT  = 16;
+// Maximal number of copy batches in flight.
+constexpr auto COPY_BATCH_CNT  = 4;
+// Amount of copied data after which a copy batch is submitted (8 MiB).
+constexpr auto COPY_BATCH_SIZE = 8 * 1024 * 1024;
+// Maximal size of a texture MIP chain reserved within the upload buffer at once (8 MiB).
+// Larger MIP chains are uploaded level by level.
+constexpr auto TEX_CHAIN_SIZE  = UPLOAD_BUF_SIZE / 4;
+// Maximal number of MIP chain reservations outstanding at once. Together, they must fit
+// into the upload buffer, so that the reservations never wait for each other.
+constexpr auto TEX_CHAIN_CNT   = 3;
+// Minimal amount of data copied into the upload buffer by a thread (512 KiB).
+// Larger copies are split across worker threads.
+constexpr auto COPY_CHUNK_SIZE = 512 * 1024;
+// Size of a default heap used to suballocate buffers and textures (64 MiB).
+constexpr auto HEAP_PAGE_SIZE  = 64 * 1024 * 1024;
+// Initial size of a temporary per-frame data arena (64 KiB). Arenas grow on demand.
+constexpr auto TEMP_DATA_SIZE  = 64 * 1024;
+// Incremental (temporally coherent) frustum culling flag.
+constexpr bool INCR_CULLING    = true;
+// Exact (separating axis) frustum culling flag.
+constexpr bool EXACT_CULLING   = false;
+// Minimal screen-space area (in pixels) of the bounding box of a visible object.
+constexpr auto MIN_OBJ_AREA    = 1.f;
+// Maximal number of command lists used to record the G-buffer pass.
+constexpr auto MAX_GBUF_LISTS  = 8;
+// Minimal number of draws per G-buffer command list.
+constexpr auto MIN_LIST_DRAWS  = 256;
+// Indirect (ExecuteIndirect) G-buffer draws flag.
+constexpr bool INDIRECT_DRAWS  = true;
 // Camera's speed (in meters/sec).
 constexpr auto CAM_SPEED       = 500.f;
 // Camera's angular speed (in radians/sec).
 constexpr auto CAM_ANG_SPEED   = 2.0f;
-// Default sampling mode (no multi-sampling).
-constexpr auto SINGLE_SAMPLE   = DXGI_SAMPLE_DESC{1, 0};
+// Fixed time step (in seconds) of the camera path playback.
+constexpr auto PLAYBACK_STEP   = 1.f / 60.f;
+// Maximal number of frames stored for the frame time statistics.
+constexpr auto FRAME_STATS_CNT = 16384;
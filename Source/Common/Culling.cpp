@@ -0,0 +1,462 @@
+#include <algorithm>
+#include <cassert>
+#include "Camera.h"
+#include "Culling.h"
+#include "Math.h"
+#include "Primitives.h"
+
+using namespace DirectX;
+
+// Accumulated camera motion after which the history is discarded
+// in order to preserve the precision of the motion bounds.
+static constexpr float MAX_TOTAL_DIST  = 65536.f;
+static constexpr float MAX_TOTAL_ANGLE = 1024.f;
+
+// Maximal average number of positions an object may be shifted by the insertion sort.
+// Past this point, the input is not nearly sorted (e.g. after a fast camera turn),
+// and the quadratic worst case of the insertion sort has to be avoided.
+static constexpr size_t MAX_SORT_SHIFTS = 8;
+
+// Sorts the array using insertion sort. Efficient for nearly-sorted inputs.
+// Gives up once more than 'maxShiftCount' elements have been shifted, and returns 'false';
+// the array then remains a (partially sorted) permutation of the input.
+static inline bool tryInsertionSort(ObjectSortPair* objSortPairs, const size_t count,
+                                    const size_t maxShiftCount) {
+    size_t shiftCount = 0;
+    for (size_t i = 1; i < count; ++i) {
+        const ObjectSortPair pair = objSortPairs[i];
+        size_t j = i;
+        for (; j > 0 && pair < objSortPairs[j - 1]; --j) {
+            objSortPairs[j] = objSortPairs[j - 1];
+        }
+        objSortPairs[j] = pair;
+        shiftCount += i - j;
+        if (shiftCount > maxShiftCount) return false;
+    }
+    return true;
+}
+
+FrustumSet::FrustumSet()
+    : m_count{0}
+    , m_frustumQuads{nullptr}
+    , m_sidePlanes{nullptr} {}
+
+FrustumSet::FrustumSet(const Frustum* frusta, const size_t count)
+    : m_count{count}
+    , m_frustumQuads{std::make_unique<FrustumQuad[]>((count + 3) / 4)}
+    , m_sidePlanes{std::make_unique<PlaneQuad[]>(count)} {
+    assert(frusta || 0 == count);
+    // Stores the transposed equations of 4 planes.
+    const auto storePlanes = [](FXMMATRIX tPlanes, PlaneQuad& planes) {
+        XMStoreFloat4A(&planes.normX,    tPlanes.r[0]);
+        XMStoreFloat4A(&planes.normY,    tPlanes.r[1]);
+        XMStoreFloat4A(&planes.normZ,    tPlanes.r[2]);
+        XMStoreFloat4A(&planes.dist,     tPlanes.r[3]);
+        XMStoreFloat4A(&planes.absNormX, XMVectorAbs(tPlanes.r[0]));
+        XMStoreFloat4A(&planes.absNormY, XMVectorAbs(tPlanes.r[1]));
+        XMStoreFloat4A(&planes.absNormZ, XMVectorAbs(tPlanes.r[2]));
+    };
+    for (size_t q = 0, n = (count + 3) / 4; q < n; ++q) {
+        // Pad the last quad with frusta which reject all objects.
+        const XMVECTOR negInf = XMVectorNegate(g_XMInfinity);
+        XMMATRIX farPlanes = {g_XMZero, g_XMZero, g_XMZero, g_XMZero};
+        XMMATRIX bBoxMins  = {g_XMInfinity, g_XMInfinity, g_XMInfinity, g_XMInfinity};
+        XMMATRIX bBoxMaxs  = {negInf, negInf, negInf, negInf};
+        for (size_t a = 0; a < 4 && 4 * q + a < count; ++a) {
+            const Frustum& frustum = frusta[4 * q + a];
+            farPlanes.r[a] = XMLoadFloat4A(&frustum.m_farPlane);
+            bBoxMins.r[a]  = frustum.m_bBox.minPoint();
+            bBoxMaxs.r[a]  = frustum.m_bBox.maxPoint();
+        }
+        FrustumQuad& quad = m_frustumQuads[q];
+        storePlanes(XMMatrixTranspose(farPlanes), quad.farPlanes);
+        const XMMATRIX tBBoxMins = XMMatrixTranspose(bBoxMins);
+        const XMMATRIX tBBoxMaxs = XMMatrixTranspose(bBoxMaxs);
+        XMStoreFloat4A(&quad.bBoxMinX, tBBoxMins.r[0]);
+        XMStoreFloat4A(&quad.bBoxMinY, tBBoxMins.r[1]);
+        XMStoreFloat4A(&quad.bBoxMinZ, tBBoxMins.r[2]);
+        XMStoreFloat4A(&quad.bBoxMaxX, tBBoxMaxs.r[0]);
+        XMStoreFloat4A(&quad.bBoxMaxY, tBBoxMaxs.r[1]);
+        XMStoreFloat4A(&quad.bBoxMaxZ, tBBoxMaxs.r[2]);
+    }
+    for (size_t k = 0; k < count; ++k) {
+        // The left/right/top/bottom planes are already transposed.
+        storePlanes(XMLoadFloat4x4A(&frusta[k].m_tPlanes), m_sidePlanes[k]);
+    }
+}
+
+size_t FrustumSet::size() const {
+    return m_count;
+}
+
+template <typename F>
+void FrustumSet::traverse(const AABox* boundingBoxes, const size_t objCount,
+                          F&& onVisible) const {
+    assert(boundingBoxes || 0 == objCount);
+    const size_t quadCount = (m_count + 3) / 4;
+    for (size_t i = 0; i < objCount; ++i) {
+        // Load the box once, and splat its components.
+        const XMVECTOR pMin     = boundingBoxes[i].minPoint();
+        const XMVECTOR pMax     = boundingBoxes[i].maxPoint();
+        const XMVECTOR center   = 0.5f * (pMin + pMax);
+        const XMVECTOR extents  = 0.5f * (pMax - pMin);
+        const XMVECTOR pMinX    = XMVectorSplatX(pMin);
+        const XMVECTOR pMinY    = XMVectorSplatY(pMin);
+        const XMVECTOR pMinZ    = XMVectorSplatZ(pMin);
+        const XMVECTOR pMaxX    = XMVectorSplatX(pMax);
+        const XMVECTOR pMaxY    = XMVectorSplatY(pMax);
+        const XMVECTOR pMaxZ    = XMVectorSplatZ(pMax);
+        const XMVECTOR centerX  = XMVectorSplatX(center);
+        const XMVECTOR centerY  = XMVectorSplatY(center);
+        const XMVECTOR centerZ  = XMVectorSplatZ(center);
+        const XMVECTOR extentsX = XMVectorSplatX(extents);
+        const XMVECTOR extentsY = XMVectorSplatY(extents);
+        const XMVECTOR extentsZ = XMVectorSplatZ(extents);
+        // Computes the largest signed distances from the box to 4 planes.
+        const auto computeLargestSignDists = [&](const PlaneQuad& planes) {
+            return XMLoadFloat4A(&planes.normX)    * centerX
+                 + XMLoadFloat4A(&planes.normY)    * centerY
+                 + XMLoadFloat4A(&planes.normZ)    * centerZ
+                 + XMLoadFloat4A(&planes.dist)
+                 + XMLoadFloat4A(&planes.absNormX) * extentsX
+                 + XMLoadFloat4A(&planes.absNormY) * extentsY
+                 + XMLoadFloat4A(&planes.absNormZ) * extentsZ;
+        };
+        for (size_t q = 0; q < quadCount; ++q) {
+            const FrustumQuad& quad = m_frustumQuads[q];
+            // Test whether the bounding boxes are disjoint, for 4 frusta at a time.
+            XMVECTOR outsideTests = XMVectorFalseInt();
+            outsideTests = XMVectorOrInt(outsideTests,
+                                         XMVectorLess(pMaxX, XMLoadFloat4A(&quad.bBoxMinX)));
+            outsideTests = XMVectorOrInt(outsideTests,
+                                         XMVectorLess(pMaxY, XMLoadFloat4A(&quad.bBoxMinY)));
+            outsideTests = XMVectorOrInt(outsideTests,
+                                         XMVectorLess(pMaxZ, XMLoadFloat4A(&quad.bBoxMinZ)));
+            outsideTests = XMVectorOrInt(outsideTests,
+                                         XMVectorGreater(pMinX, XMLoadFloat4A(&quad.bBoxMaxX)));
+            outsideTests = XMVectorOrInt(outsideTests,
+                                         XMVectorGreater(pMinY, XMLoadFloat4A(&quad.bBoxMaxY)));
+            outsideTests = XMVectorOrInt(outsideTests,
+                                         XMVectorGreater(pMinZ, XMLoadFloat4A(&quad.bBoxMaxZ)));
+            // Test whether the box is in front of the cameras.
+            const XMVECTOR farDists = computeLargestSignDists(quad.farPlanes);
+            outsideTests = XMVectorOrInt(outsideTests, XMVectorLessOrEqual(farDists, g_XMZero));
+            const int insideMask = ~_mm_movemask_ps(outsideTests) & 0xF;
+            if (0 == insideMask) continue;
+            XMFLOAT4A distances;
+            XMStoreFloat4A(&distances, farDists);
+            // Test the remaining frusta against the left/right/top/bottom planes.
+            for (size_t a = 0; a < 4; ++a) {
+                const size_t k = 4 * q + a;
+                if (0 == (insideMask & (1 << a)) || k >= m_count) continue;
+                const XMVECTOR sideDists = computeLargestSignDists(m_sidePlanes[k]);
+                if (XMVector4Greater(sideDists, g_XMZero)) {
+                    onVisible(k, i, (&distances.x)[a]);
+                }
+            }
+        }
+    }
+}
+
+void FrustumSet::cull(const AABox* boundingBoxes, const size_t objCount,
+                      ObjectSortPair* const* objSortPairs, size_t* visObjCounts) const {
+    assert(objSortPairs && visObjCounts);
+    std::fill(visObjCounts, visObjCounts + m_count, 0);
+    const auto appendObject = [objSortPairs, visObjCounts](const size_t k, const size_t i,
+                                                            const float distance) {
+        ObjectSortKey key;
+        key.depth = distance;
+        objSortPairs[k][visObjCounts[k]++] = {key, static_cast<uint32_t>(i)};
+    };
+    traverse(boundingBoxes, objCount, appendObject);
+}
+
+void FrustumSet::cull(const AABox* boundingBoxes, const size_t objCount,
+                      DynBitSet* visibility) const {
+    assert(visibility);
+    for (size_t k = 0; k < m_count; ++k) {
+        visibility[k].reset(0);
+    }
+    const auto markObject = [visibility](const size_t k, const size_t i, const float) {
+        visibility[k].setBit(i);
+    };
+    traverse(boundingBoxes, objCount, markObject);
+}
+
+FrustumCuller::FrustumCuller()
+    : m_objCount{0}
+    , m_records{nullptr}
+    , m_visObjOrder{nullptr}
+    , m_visObjCount{0}
+    , m_keptObjCount{0}
+    , m_testedObjCount{0}
+    , m_hasHistory{false}
+    , m_totalDist{0.f}
+    , m_totalAngle{0.f} {}
+
+FrustumCuller::FrustumCuller(const size_t objCount)
+    : m_objCount{objCount}
+    , m_records{std::make_unique<TestRecord[]>(objCount)}
+    , m_visibility{objCount}
+    , m_visObjOrder{std::make_unique<uint32_t[]>(objCount)}
+    , m_visObjCount{0}
+    , m_keptObjCount{0}
+    , m_testedObjCount{0}
+    , m_hasHistory{false}
+    , m_totalDist{0.f}
+    , m_totalAngle{0.f} {}
+
+size_t FrustumCuller::cull(const PerspectiveCamera& pCam, const AABox* boundingBoxes,
+                           ObjectSortPair* objSortPairs, const bool useHistory,
+                           const bool exactTest) {
+    const size_t visObjCount = cullObjects(pCam, boundingBoxes, objSortPairs,
+                                           useHistory, exactTest);
+    sortObjects(objSortPairs);
+    return visObjCount;
+}
+
+size_t FrustumCuller::cullObjects(const PerspectiveCamera& pCam, const AABox* boundingBoxes,
+                                  ObjectSortPair* objSortPairs, const bool useHistory,
+                                  const bool exactTest) {
+    assert(boundingBoxes && objSortPairs);
+    // Compute the viewing frustum.
+    const Frustum  frustum   = pCam.computeViewFrustum();
+    const XMVECTOR camPos    = pCam.position();
+    const XMVECTOR camOrient = pCam.orientationQuaternion();
+    if (!useHistory) {
+        invalidate();
+    }
+    if (m_hasHistory) {
+        // Accumulate the motion of the camera since the last call.
+        const XMVECTOR prevPos    = XMLoadFloat3A(&m_camPosition);
+        const XMVECTOR prevOrient = XMLoadFloat4A(&m_camOrientQuat);
+        const float    dist       = XMVectorGetX(SSE4::XMVector3Length(camPos - prevPos));
+        const float    cosHalfAng = fabsf(XMVectorGetX(XMQuaternionDot(camOrient, prevOrient)));
+        const float    angle      = 2.f * acosf(std::min(cosHalfAng, 1.f));
+        m_totalDist  += dist;
+        m_totalAngle += angle;
+        if (m_totalDist > MAX_TOTAL_DIST || m_totalAngle > MAX_TOTAL_ANGLE) {
+            invalidate();
+        }
+    }
+    XMStoreFloat3A(&m_camPosition,   camPos);
+    XMStoreFloat4A(&m_camOrientQuat, camOrient);
+    m_testedObjCount = 0;
+    // Objects which remain visible are stored first (in the order of the last call),
+    // and are followed by the objects which have become visible.
+    size_t keptObjCount = 0;
+    size_t newObjCount  = 0;
+    if (!m_hasHistory) {
+        // Test all objects.
+        for (size_t i = 0; i < m_objCount; ++i) {
+            float depth;
+            if (testObject(frustum, camPos, boundingBoxes[i], i, exactTest, &depth)) {
+                ObjectSortKey key;
+                key.depth = depth;
+                objSortPairs[newObjCount++] = {key, static_cast<uint32_t>(i)};
+            }
+        }
+        m_hasHistory = true;
+    } else {
+        // The objects which have become visible are temporarily stored after the objects
+        // which were visible during the last call (so that the two ranges never overlap).
+        ObjectSortPair* newVisObjs = &objSortPairs[m_visObjCount];
+        // Test the objects which were invisible during the last call.
+        for (size_t i = 0; i < m_objCount; ++i) {
+            if (!m_visibility.testBit(i) && requiresTest(i)) {
+                float depth;
+                if (testObject(frustum, camPos, boundingBoxes[i], i, exactTest, &depth)) {
+                    ObjectSortKey key;
+                    key.depth = depth;
+                    newVisObjs[newObjCount++] = {key, static_cast<uint32_t>(i)};
+                }
+            }
+        }
+        // Process the objects which were visible during the last call, in the sorted order.
+        for (size_t k = 0; k < m_visObjCount; ++k) {
+            const uint32_t i = m_visObjOrder[k];
+            float depth;
+            if (requiresTest(i)) {
+                if (!testObject(frustum, camPos, boundingBoxes[i], i, exactTest, &depth)) continue;
+            } else {
+                // The object is still visible; only update its depth.
+                depth = frustum.computeDistance(boundingBoxes[i]);
+            }
+            ObjectSortKey key;
+            key.depth = depth;
+            objSortPairs[keptObjCount++] = {key, i};
+        }
+        // Close the gap between the two ranges.
+        std::move(&newVisObjs[0], &newVisObjs[newObjCount], &objSortPairs[keptObjCount]);
+    }
+    m_keptObjCount = keptObjCount;
+    m_visObjCount  = keptObjCount + newObjCount;
+    return m_visObjCount;
+}
+
+void FrustumCuller::sortObjects(ObjectSortPair* objSortPairs) {
+    assert(objSortPairs);
+    const size_t keptObjCount = m_keptObjCount;
+    const size_t visObjCount  = m_visObjCount;
+    // Restore the order of the objects which remain visible.
+    // The order usually changes slightly, so the input is nearly sorted.
+    // Bound the amount of work in case it is not.
+    if (!tryInsertionSort(objSortPairs, keptObjCount, MAX_SORT_SHIFTS * keptObjCount)) {
+        std::sort(&objSortPairs[0], &objSortPairs[keptObjCount]);
+    }
+    // Sort the objects which have become visible, and merge the two ranges.
+    std::sort(&objSortPairs[keptObjCount], &objSortPairs[visObjCount]);
+    std::inplace_merge(&objSortPairs[0], &objSortPairs[keptObjCount],
+                       &objSortPairs[visObjCount]);
+    // Store the sorted order for the next call.
+    for (size_t k = 0; k < visObjCount; ++k) {
+        m_visObjOrder[k] = objSortPairs[k].index;
+    }
+}
+
+bool FrustumCuller::testObject(const Frustum& frustum, FXMVECTOR camPos, const AABox& aaBox,
+                               const size_t index, const bool exactTest, float* distance) {
+    bool        isVisible = frustum.intersects(aaBox, distance);
+    const float margin    = frustum.computeMargin(aaBox);
+    // The margin is not valid if the test against the bounding box of the frustum has failed.
+    bool        isValid   = isVisible == (margin > 0.f);
+    if (isVisible && exactTest && !frustum.intersectsExactly(aaBox)) {
+        // The margin does not account for the separating axes of the exact test.
+        isVisible = false;
+        isValid   = false;
+    }
+    // Bound the distance from the camera to any point of the box.
+    const XMVECTOR halfDiag = 0.5f * (aaBox.maxPoint() - aaBox.minPoint());
+    const XMVECTOR centDist = SSE4::XMVector3Length(aaBox.center() - camPos);
+    const XMVECTOR radius   = centDist + SSE4::XMVector3Length(halfDiag);
+    // Update the record.
+    TestRecord& record = m_records[index];
+    record.margin      = isValid ? fabsf(margin) : 0.f;
+    record.radius      = XMVectorGetX(radius);
+    record.distRef     = m_totalDist;
+    record.angleRef    = m_totalAngle;
+    if (isVisible) {
+        m_visibility.setBit(index);
+    } else {
+        m_visibility.clearBit(index);
+    }
+    ++m_testedObjCount;
+    return isVisible;
+}
+
+bool FrustumCuller::requiresTest(const size_t index) const {
+    const TestRecord& record = m_records[index];
+    // Compute the camera motion since the last test of the object.
+    const float dist  = m_totalDist  - record.distRef;
+    const float angle = m_totalAngle - record.angleRef;
+    // The planes of the frustum are attached to the camera. Translation moves them by at most
+    // 'dist', and rotation by 'angle' displaces the points of the box by at most
+    // 'angle' times the distance to the camera (which itself may grow by 'dist').
+    const float displacement = dist + angle * (record.radius + dist);
+    return displacement >= record.margin;
+}
+
+void FrustumCuller::invalidate(const size_t index) {
+    assert(index < m_objCount);
+    m_records[index].margin = 0.f;
+}
+
+void FrustumCuller::invalidate() {
+    m_hasHistory   = false;
+    m_visObjCount  = 0;
+    m_keptObjCount = 0;
+    m_totalDist    = 0.f;
+    m_totalAngle   = 0.f;
+}
+
+size_t FrustumCuller::objectCount() const {
+    return m_objCount;
+}
+
+size_t FrustumCuller::testedObjectCount() const {
+    return m_testedObjCount;
+}
+
+size_t cullSmallObjects(const PerspectiveCamera& pCam, const AABox* boundingBoxes,
+                        const float minArea, const size_t count,
+                        ObjectSortPair* objSortPairs, ScreenBounds* bounds) {
+    assert(boundingBoxes && objSortPairs);
+    // Store the view-projection matrix in the transposed form, so that each row
+    // contains the coefficients of a single component of the clip-space position.
+    const XMMATRIX tViewProj = XMMatrixTranspose(pCam.computeViewProjMatrix());
+    XMVECTOR coeffs[4][4];
+    for (size_t r = 0; r < 4; ++r) {
+        coeffs[r][0] = XMVectorSplatX(tViewProj.r[r]);
+        coeffs[r][1] = XMVectorSplatY(tViewProj.r[r]);
+        coeffs[r][2] = XMVectorSplatZ(tViewProj.r[r]);
+        coeffs[r][3] = XMVectorSplatW(tViewProj.r[r]);
+    }
+    // Each vector holds 4 corners of the box: (Y0, Z0), (Y1, Z0), (Y0, Z1), (Y1, Z1).
+    // The two vectors correspond to the minimal and the maximal X coordinates.
+    const XMVECTOR selY = XMVectorSelectControl(0, 1, 0, 1);
+    const XMVECTOR selZ = XMVectorSelectControl(0, 0, 1, 1);
+    // Transforms NDC coordinates into raster coordinates.
+    const XMVECTOR res    = pCam.resolution();
+    const XMVECTOR scaleX = XMVectorReplicate( 0.5f * XMVectorGetX(res));
+    const XMVECTOR scaleY = XMVectorReplicate(-0.5f * XMVectorGetY(res));
+    const XMVECTOR maxX   = XMVectorSplatX(res);
+    const XMVECTOR maxY   = XMVectorSplatY(res);
+    size_t remObjCount = 0;
+    for (size_t i = 0; i < count; ++i) {
+        const ObjectSortPair pair = objSortPairs[i];
+        const AABox&   aaBox = boundingBoxes[pair.index];
+        const XMVECTOR pMin  = aaBox.minPoint();
+        const XMVECTOR pMax  = aaBox.maxPoint();
+        const XMVECTOR ys    = XMVectorSelect(XMVectorSplatY(pMin), XMVectorSplatY(pMax), selY);
+        const XMVECTOR zs    = XMVectorSelect(XMVectorSplatZ(pMin), XMVectorSplatZ(pMax), selZ);
+        const XMVECTOR xMin  = XMVectorSplatX(pMin);
+        const XMVECTOR xMax  = XMVectorSplatX(pMax);
+        // Compute the X, Y, Z, W clip-space coordinates of all 8 corners.
+        XMVECTOR clip[4][2];
+        for (size_t c = 0; c < 4; ++c) {
+            const XMVECTOR yz = ys * coeffs[c][1] + zs * coeffs[c][2] + coeffs[c][3];
+            clip[c][0] = yz + xMin * coeffs[c][0];
+            clip[c][1] = yz + xMax * coeffs[c][0];
+        }
+        ScreenBounds sb;
+        // Check whether the box crosses the plane of the camera.
+        const XMVECTOR minW = XMVectorMin(clip[3][0], clip[3][1]);
+        if (XMVector4Greater(minW, g_XMZero)) {
+            // Perform the perspective division.
+            XMVECTOR ndc[3][2];
+            for (size_t k = 0; k < 2; ++k) {
+                const XMVECTOR invW = XMVectorReciprocal(clip[3][k]);
+                ndc[0][k] = clip[0][k] * invW;
+                ndc[1][k] = clip[1][k] * invW;
+                ndc[2][k] = clip[2][k] * invW;
+            }
+            // Compute the bounding rectangle in the NDC space.
+            const XMVECTOR ndcMinX = XMVector4Min(XMVectorMin(ndc[0][0], ndc[0][1]));
+            const XMVECTOR ndcMaxX = XMVector4Max(XMVectorMax(ndc[0][0], ndc[0][1]));
+            const XMVECTOR ndcMinY = XMVector4Min(XMVectorMin(ndc[1][0], ndc[1][1]));
+            const XMVECTOR ndcMaxY = XMVector4Max(XMVectorMax(ndc[1][0], ndc[1][1]));
+            const XMVECTOR ndcMaxZ = XMVector4Max(XMVectorMax(ndc[2][0], ndc[2][1]));
+            // Transform it into raster coordinates, and clamp to the dimensions of the screen.
+            // Note that the Y axis is flipped.
+            const XMVECTOR rMinX = XMVectorClamp(ndcMinX * scaleX + scaleX, g_XMZero, maxX);
+            const XMVECTOR rMaxX = XMVectorClamp(ndcMaxX * scaleX + scaleX, g_XMZero, maxX);
+            const XMVECTOR rMinY = XMVectorClamp(ndcMaxY * scaleY - scaleY, g_XMZero, maxY);
+            const XMVECTOR rMaxY = XMVectorClamp(ndcMinY * scaleY - scaleY, g_XMZero, maxY);
+            sb = ScreenBounds{XMVectorGetX(rMinX), XMVectorGetX(rMinY),
+                              XMVectorGetX(rMaxX), XMVectorGetX(rMaxY),
+                              XMVectorGetX(ndcMaxZ)};
+        } else {
+            // The box cannot be projected, so assume that it covers the entire screen.
+            sb = ScreenBounds{0.f, 0.f, XMVectorGetX(maxX), XMVectorGetX(maxY), 1.f};
+        }
+        // Discard the object if its projection is too small.
+        const float area = (sb.maxX - sb.minX) * (sb.maxY - sb.minY);
+        if (area >= minArea) {
+            if (bounds) {
+                bounds[remObjCount] = sb;
+            }
+            objSortPairs[remObjCount++] = pair;
+        }
+    }
+    return remObjCount;
+}
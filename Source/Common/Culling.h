@@ -0,0 +1,133 @@
+#pragma once
+
+#include <memory>
+#include <DirectXMathSSE4.h>
+#include "DynBitSet.h"
+#include "ObjectSort.h"
+
+class AABox;
+class Frustum;
+class PerspectiveCamera;
+
+// Screen-space bounds of the projected bounding box of an object.
+struct ScreenBounds {
+    float minX, minY;   // Top left corner of the bounding rectangle (in pixels)
+    float maxX, maxY;   // Bottom right corner of the bounding rectangle (in pixels)
+    float depth;        // Depth of the nearest point (reversed, larger values are closer)
+};
+
+// Projects the bounding boxes of 'count' visible objects onto the screen, and removes
+// the objects which cover less than 'minArea' pixels, preserving the order of the rest.
+// Optionally, outputs the screen-space bounds of the remaining objects into 'bounds'.
+// Returns the number of the remaining objects.
+size_t cullSmallObjects(const PerspectiveCamera& pCam, const AABox* boundingBoxes,
+                        const float minArea, const size_t count,
+                        ObjectSortPair* objSortPairs, ScreenBounds* bounds = nullptr);
+
+// Set of frusta packed for batched culling (e.g. several views, or shadow cascades).
+// The bounding boxes are traversed once, and each box is tested against all frusta.
+// The far planes and the bounding boxes of 4 frusta are tested at a time, and the
+// left/right/top/bottom planes are only tested for the frusta which pass these tests.
+class FrustumSet {
+public:
+    RULE_OF_ZERO_MOVE_ONLY(FrustumSet);
+    // Ctor; performs zero-initialization.
+    FrustumSet();
+    // Ctor; takes an array of 'count' frusta as input.
+    explicit FrustumSet(const Frustum* frusta, const size_t count);
+    // Returns the number of frusta.
+    size_t size() const;
+    // Culls 'objCount' objects represented by their bounding boxes against all frusta.
+    // For each frustum 'k', outputs the visible objects (in the original order) into
+    // 'objSortPairs[k]', and returns their count in 'visObjCounts[k]'.
+    // The keys contain the distances returned by Frustum::intersects().
+    // Each array 'objSortPairs[k]' must be large enough to hold all objects.
+    void cull(const AABox* boundingBoxes, const size_t objCount,
+              ObjectSortPair* const* objSortPairs, size_t* visObjCounts) const;
+    // Culls 'objCount' objects represented by their bounding boxes against all frusta.
+    // For each frustum 'k', outputs the visibility of objects into 'visibility[k]'.
+    // Each bit set must be able to hold at least 'objCount' bits.
+    void cull(const AABox* boundingBoxes, const size_t objCount, DynBitSet* visibility) const;
+private:
+    // Calls 'onVisible(k, i, distance)' for every object 'i' visible in frustum 'k'.
+    template <typename F>
+    void traverse(const AABox* boundingBoxes, const size_t objCount, F&& onVisible) const;
+private:
+    // 4 planes in the SoA layout.
+    struct PlaneQuad {
+        DirectX::XMFLOAT4A normX, normY, normZ, dist;
+        DirectX::XMFLOAT4A absNormX, absNormY, absNormZ;
+    };
+    // Far planes and bounding boxes of 4 frusta in the SoA layout.
+    struct FrustumQuad {
+        PlaneQuad          farPlanes;
+        DirectX::XMFLOAT4A bBoxMinX, bBoxMinY, bBoxMinZ;
+        DirectX::XMFLOAT4A bBoxMaxX, bBoxMaxY, bBoxMaxZ;
+    };
+    size_t                         m_count;
+    std::unique_ptr<FrustumQuad[]> m_frustumQuads;  // (m_count + 3) / 4 elements
+    std::unique_ptr<PlaneQuad[]>   m_sidePlanes;    // Left/right/top/bottom planes, per frustum
+};
+
+// Performs frustum culling and front-to-back sorting of a fixed set of objects.
+// Exploits temporal coherence: the visibility of objects is kept between calls, and
+// only the objects which could have crossed the boundary of the frustum (given the motion
+// of the camera) or the objects marked as changed are tested again.
+// The sorted order of the previous call is reused as a nearly-sorted input.
+class FrustumCuller {
+public:
+    RULE_OF_ZERO_MOVE_ONLY(FrustumCuller);
+    // Ctor; performs zero-initialization.
+    FrustumCuller();
+    // Ctor; takes the number of objects as input.
+    explicit FrustumCuller(const size_t objCount);
+    // Culls the objects represented by their bounding boxes against the viewing frustum.
+    // Outputs the visible objects sorted front to back, and returns their count.
+    // 'objSortPairs' must be large enough to hold all objects.
+    // If 'useHistory' is 'false', all objects are tested, and the history is rebuilt.
+    // If 'exactTest' is 'true', the objects are also tested using Frustum::intersectsExactly().
+    size_t cull(const PerspectiveCamera& pCam, const AABox* boundingBoxes,
+                ObjectSortPair* objSortPairs, const bool useHistory = true,
+                const bool exactTest = false);
+    // Performs the culling step of cull(). Outputs the visible objects in an unspecified
+    // order, and returns their count. Must be followed by a call to sortObjects().
+    size_t cullObjects(const PerspectiveCamera& pCam, const AABox* boundingBoxes,
+                       ObjectSortPair* objSortPairs, const bool useHistory = true,
+                       const bool exactTest = false);
+    // Performs the sorting step of cull(). Sorts the output of cullObjects() front to back.
+    void sortObjects(ObjectSortPair* objSortPairs);
+    // Marks the object as changed. It will be tested during the next call to cull().
+    void invalidate(const size_t index);
+    // Discards the history. All objects will be tested during the next call to cull().
+    void invalidate();
+    // Returns the number of objects.
+    size_t objectCount() const;
+    // Returns the number of objects tested during the last call to cull().
+    size_t testedObjectCount() const;
+private:
+    // Per-object record of the last visibility test.
+    struct TestRecord {
+        float margin;       // Distance the planes have to move to change the outcome of the test
+        float radius;       // Upper bound of the distance from the camera to the box
+        float distRef;      // Total distance traveled by the camera at the time of the test
+        float angleRef;     // Total angle of rotation of the camera at the time of the test
+    };
+    // Tests the object for visibility, and updates its record.
+    bool testObject(const Frustum& frustum, DirectX::FXMVECTOR camPos, const AABox& aaBox,
+                    const size_t index, const bool exactTest, float* distance);
+    // Returns 'true' if the outcome of the last test of the object may no longer be valid.
+    bool requiresTest(const size_t index) const;
+private:
+    size_t                        m_objCount;
+    std::unique_ptr<TestRecord[]> m_records;        // Per object
+    DynBitSet                     m_visibility;     // Per object, as of the last call
+    std::unique_ptr<uint32_t[]>   m_visObjOrder;    // Visible objects, sorted front to back
+    size_t                        m_visObjCount;
+    size_t                        m_keptObjCount;   // Visible during the last 2 calls
+    size_t                        m_testedObjCount;
+    bool                          m_hasHistory;
+    DirectX::XMFLOAT3A            m_camPosition;    // Camera position during the last call
+    DirectX::XMFLOAT4A            m_camOrientQuat;  // Camera orientation during the last call
+    float                         m_totalDist;      // Total distance traveled by the camera
+    float                         m_totalAngle;     // Total angle of rotation of the camera
+};
@@ -1,6 +1,7 @@
 #pragma once
 
 // Fixed width integer types for storage.
+#include <cstddef>
 #include <cstdint>
 
 // Fast integer types for compute.
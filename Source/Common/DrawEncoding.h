@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include "ObjectSort.h"
+#include "ParallelRecording.h"
+
+// Per-object data required to record a draw, precomputed at load time.
+// The objects share a single index buffer. 4 packets fit into a single cache line.
+// 'matConstant' and 'bumpTexId' form the 2 per-draw root constants of the G-buffer pass.
+struct DrawPacket {
+    uint32_t indexCount;    // Number of indices of the object
+    uint32_t firstIndex;    // Location of the first index within the index buffer
+    uint32_t matConstant;   // Bump map flag (bit 31) | material index
+    uint32_t bumpTexId;     // Texture index of the bump map (UINT32_MAX if there is none)
+};
+
+static_assert(sizeof(DrawPacket) == 16, "Invalid draw packet size.");
+static_assert(offsetof(DrawPacket, bumpTexId) == offsetof(DrawPacket, matConstant) + 4,
+              "The root constants must be contiguous.");
+
+// Constructs the draw packet of an object.
+inline auto makeDrawPacket(const uint32_t indexCount, const uint32_t firstIndex,
+                           const uint16_t matId, const uint32_t bumpTexId)
+-> DrawPacket {
+    const uint32_t bumpMapFlag = (bumpTexId < UINT32_MAX) ? 1u << 31 : 0;
+    return DrawPacket{indexCount, firstIndex, bumpMapFlag | matId, bumpTexId};
+}
+
+// Numbers of draws and material changes of the encoded visible objects.
+struct DrawCounts {
+    size_t objDrawCount;    // Before coalescing (one draw per object)
+    size_t drawCount;       // After coalescing
+    size_t matChangeCount;
+};
+
+// Encodes the draws of the visible objects (sorted front to back) within the range.
+// 'Encoder' is a command encoder, such as CommandStream or D3D12::CommandEncoder.
+// The index buffer shared by the objects must already be set.
+// The ranges are typically recorded into separate command lists,
+// so each range starts without a material set.
+// Consecutive objects with the same material and adjacent index ranges (e.g. neighboring
+// objects of the scene, which is sorted by material at load) are coalesced into a single draw.
+template <typename Encoder>
+inline auto encodeDraws(Encoder& encoder, const DrawRange& range,
+                        const ObjectSortPair* objSortPairs, const DrawPacket* drawPackets)
+-> DrawCounts {
+    DrawCounts counts{range.end - range.begin, 0, 0};
+    uint32_t   matConstant = UINT32_MAX;
+    for (size_t i = range.begin; i < range.end; ++i) {
+        const DrawPacket& packet = drawPackets[objSortPairs[i].index];
+        if (matConstant != packet.matConstant) {
+            matConstant = packet.matConstant;
+            ++counts.matChangeCount;
+            // Set the bump map flag, the material index and the bump map index.
+            encoder.setRootConstants(1, 2, &packet.matConstant, 0);
+        }
+        // Extend the run of indices in either direction while possible.
+        uint32_t firstIndex = packet.firstIndex;
+        uint32_t indexCount = packet.indexCount;
+        for (; i + 1 < range.end; ++i) {
+            const DrawPacket& next = drawPackets[objSortPairs[i + 1].index];
+            if (matConstant != next.matConstant) break;
+            if (firstIndex + indexCount == next.firstIndex) {
+                indexCount += next.indexCount;
+            } else if (next.firstIndex + next.indexCount == firstIndex) {
+                firstIndex  = next.firstIndex;
+                indexCount += next.indexCount;
+            } else {
+                break;
+            }
+        }
+        encoder.drawIndexed(indexCount, firstIndex);
+        ++counts.drawCount;
+    }
+    return counts;
+}
@@ -1,6 +1,25 @@
 #include <cassert>
+#include <cstring>
+#include <immintrin.h>
 #include "DynBitSet.h"
 
+// Performs 'bits[i] = op(bits[i], otherBits[i])' for 'dwordCount' dwords.
+// 'simdOp' processes 4 dwords at a time, and 'scalarOp' processes the remainder.
+template <typename SimdOp, typename ScalarOp>
+static inline auto applyBitwiseOp(uint32_t* bits, const uint32_t* otherBits,
+                                  const size_t dwordCount, SimdOp simdOp, ScalarOp scalarOp)
+-> void {
+    size_t i = 0;
+    for (; i + 4 <= dwordCount; i += 4) {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bits + i));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(otherBits + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(bits + i), simdOp(a, b));
+    }
+    for (; i < dwordCount; ++i) {
+        bits[i] = scalarOp(bits[i], otherBits[i]);
+    }
+}
+
 DynBitSet::DynBitSet()
     : m_bits{nullptr}
     , m_bitCount{0}
@@ -45,6 +64,11 @@ DynBitSet::~DynBitSet() noexcept = default;
 void DynBitSet::reset(const bool value) {
     const byte_t val = value ? 0xFF : 0x0;
     memset(m_bits.get(), val, m_dwordCount * sizeof(uint32_t));
+    // Clear the padding bits.
+    const uint32_t lastBitCount = m_bitCount % 32;
+    if (value && lastBitCount != 0) {
+        m_bits[m_dwordCount - 1] = (1u << lastBitCount) - 1;
+    }
 }
 
 void DynBitSet::clearBit(const size_t index) {
@@ -66,3 +90,70 @@ bool DynBitSet::testBit(const size_t index) const {
     assert(index < m_bitCount);
     return 0 != (m_bits[index / 32] & 1 << (index % 32));
 }
+
+size_t DynBitSet::size() const {
+    return m_bitCount;
+}
+
+size_t DynBitSet::popCount() const {
+    size_t count = 0;
+    size_t i     = 0;
+    for (; i + 2 <= m_dwordCount; i += 2) {
+        uint64_t qword;
+        memcpy(&qword, &m_bits[i], sizeof(uint64_t));
+        count += _mm_popcnt_u64(qword);
+    }
+    if (i < m_dwordCount) {
+        count += _mm_popcnt_u32(m_bits[i]);
+    }
+    return count;
+}
+
+bool DynBitSet::any() const {
+    size_t i = 0;
+    for (; i + 4 <= m_dwordCount; i += 4) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&m_bits[i]));
+        if (!_mm_testz_si128(v, v)) return true;
+    }
+    for (; i < m_dwordCount; ++i) {
+        if (m_bits[i]) return true;
+    }
+    return false;
+}
+
+bool DynBitSet::none() const {
+    return !any();
+}
+
+DynBitSet& DynBitSet::operator&=(const DynBitSet& other) {
+    assert(m_bitCount == other.m_bitCount);
+    applyBitwiseOp(m_bits.get(), other.m_bits.get(), m_dwordCount,
+                   [](const __m128i a, const __m128i b) { return _mm_and_si128(a, b); },
+                   [](const uint32_t a, const uint32_t b) { return a & b; });
+    return *this;
+}
+
+DynBitSet& DynBitSet::operator|=(const DynBitSet& other) {
+    assert(m_bitCount == other.m_bitCount);
+    applyBitwiseOp(m_bits.get(), other.m_bits.get(), m_dwordCount,
+                   [](const __m128i a, const __m128i b) { return _mm_or_si128(a, b); },
+                   [](const uint32_t a, const uint32_t b) { return a | b; });
+    return *this;
+}
+
+DynBitSet& DynBitSet::operator^=(const DynBitSet& other) {
+    assert(m_bitCount == other.m_bitCount);
+    applyBitwiseOp(m_bits.get(), other.m_bits.get(), m_dwordCount,
+                   [](const __m128i a, const __m128i b) { return _mm_xor_si128(a, b); },
+                   [](const uint32_t a, const uint32_t b) { return a ^ b; });
+    return *this;
+}
+
+DynBitSet& DynBitSet::andNot(const DynBitSet& other) {
+    assert(m_bitCount == other.m_bitCount);
+    // Note: _mm_andnot_si128(b, a) computes (~b & a).
+    applyBitwiseOp(m_bits.get(), other.m_bits.get(), m_dwordCount,
+                   [](const __m128i a, const __m128i b) { return _mm_andnot_si128(b, a); },
+                   [](const uint32_t a, const uint32_t b) { return a & ~b; });
+    return *this;
+}
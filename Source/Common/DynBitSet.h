@@ -4,6 +4,8 @@
 #include "Definitions.h"
 
 // BitSet with size specified at runtime.
+// Bulk operations process 128 bits at a time using SSE.
+// The padding bits (past the size) are always 0.
 class DynBitSet {
 public:
     RULE_OF_FIVE(DynBitSet);
@@ -21,6 +23,23 @@ public:
     void toggleBit(const size_t index);
     // Returns 'true' if the specified bit is 1, 'false' otherwise.
     bool testBit(const size_t index) const;
+    // Returns the size (number of bits).
+    size_t size() const;
+    // Returns the number of bits set to 1.
+    size_t popCount() const;
+    // Returns 'true' if any bit is 1, 'false' otherwise.
+    bool any() const;
+    // Returns 'true' if all bits are 0, 'false' otherwise.
+    bool none() const;
+    // Bitwise operations with the set of the same size.
+    DynBitSet& operator&=(const DynBitSet& other);
+    DynBitSet& operator|=(const DynBitSet& other);
+    DynBitSet& operator^=(const DynBitSet& other);
+    // Performs 'this &= ~other' for the set of the same size.
+    DynBitSet& andNot(const DynBitSet& other);
+    // Invokes 'f(index)' for each bit set to 1, in the ascending order of indices.
+    template <typename F>
+    void forEachSetBit(F&& f) const;
 private:
     std::unique_ptr<uint32_t[]> m_bits;
     uint32_t                    m_bitCount;
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <immintrin.h>
+#include "DynBitSet.h"
+
+template <typename F>
+inline void DynBitSet::forEachSetBit(F&& f) const {
+    for (uint32_t i = 0; i < m_dwordCount; ++i) {
+        uint32_t dword = m_bits[i];
+        while (0 != dword) {
+            // Find the lowest set bit, and clear it.
+            const uint32_t bit = _tzcnt_u32(dword);
+            dword &= dword - 1;
+            f(static_cast<size_t>(i * 32 + bit));
+        }
+    }
+}
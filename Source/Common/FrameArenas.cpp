@@ -0,0 +1,43 @@
+#include <algorithm>
+#include <cassert>
+#include "FrameArenas.hpp"
+
+FrameArenas::FrameArenas()
+    : m_frameCount{0}
+    , m_threadCount{0}
+    , m_highWaterMark{0} {}
+
+FrameArenas::FrameArenas(const size_t frameCount, const size_t threadCount,
+                         const size_t chunkSize)
+    : m_frameCount{frameCount}
+    , m_threadCount{threadCount}
+    , m_highWaterMark{0} {
+    assert(frameCount > 0 && threadCount > 0);
+    const size_t arenaCount = frameCount * threadCount;
+    m_arenas = std::make_unique<LinearAllocator[]>(arenaCount);
+    for (size_t i = 0; i < arenaCount; ++i) {
+        m_arenas[i] = LinearAllocator{chunkSize};
+    }
+}
+
+void FrameArenas::beginFrame(const size_t frameIndex) {
+    // Update the statistics using the previous frame which has used the arenas.
+    size_t usedSize = 0;
+    for (size_t t = 0; t < m_threadCount; ++t) {
+        usedSize += arena(frameIndex, t).usedSize();
+        arena(frameIndex, t).reset();
+    }
+    m_highWaterMark = std::max(m_highWaterMark, usedSize);
+}
+
+size_t FrameArenas::highWaterMark() const {
+    return m_highWaterMark;
+}
+
+size_t FrameArenas::capacity() const {
+    size_t totalSize = 0;
+    for (size_t i = 0, n = m_frameCount * m_threadCount; i < n; ++i) {
+        totalSize += m_arenas[i].capacity();
+    }
+    return totalSize;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "Resources.h"
+
+// Set of growable linear allocators used for temporary (scratch) per-frame data.
+// There is an arena per frame in flight and per thread (see JobSystem::threadIndex()),
+// so the threads allocate memory without locks. The arenas of a frame are reset
+// once the frame begins, and the memory remains valid until the frame is complete.
+// Threads which are not workers share an arena, so only one of them may use it at a time.
+class FrameArenas {
+public:
+    RULE_OF_ZERO_MOVE_ONLY(FrameArenas);
+    // Ctor; performs zero-initialization.
+    FrameArenas();
+    // Ctor; takes the maximal number of frames in flight, the number of threads,
+    // and the initial size (in bytes) of each arena as input.
+    explicit FrameArenas(const size_t frameCount, const size_t threadCount,
+                         const size_t chunkSize);
+    // Resets the arenas of the frame. The previous frame which has used the same arenas
+    // (frameIndex - frameCount) must be complete.
+    void beginFrame(const size_t frameIndex);
+    // Allocates 'size' bytes for the frame from the arena of the calling thread.
+    template <size_t alignment>
+    void* allocate(const size_t frameIndex, const size_t size);
+    // Returns the maximal amount of memory (in bytes) used by a single frame
+    // (as of the last call to beginFrame()).
+    size_t highWaterMark() const;
+    // Returns the total size (in bytes) of the memory reserved by all arenas.
+    size_t capacity() const;
+private:
+    // Returns the arena of the thread for the frame.
+    LinearAllocator& arena(const size_t frameIndex, const size_t threadIndex);
+private:
+    size_t                             m_frameCount;
+    size_t                             m_threadCount;
+    size_t                             m_highWaterMark;
+    std::unique_ptr<LinearAllocator[]> m_arenas;        // Per frame slot, per thread
+};
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "FrameArenas.h"
+#include "JobSystem.h"
+#include "Resources.hpp"
+
+template <size_t alignment>
+inline auto FrameArenas::allocate(const size_t frameIndex, const size_t size)
+-> void* {
+    return arena(frameIndex, JobSystem::threadIndex()).allocate<alignment>(size);
+}
+
+inline auto FrameArenas::arena(const size_t frameIndex, const size_t threadIndex)
+-> LinearAllocator& {
+    assert(threadIndex < m_threadCount);
+    return m_arenas[(frameIndex % m_frameCount) * m_threadCount + threadIndex];
+}
@@ -0,0 +1,83 @@
+#include <cassert>
+#include "FramePipeline.h"
+
+FramePipeline::FramePipeline()
+    : m_stageCount{0}
+    , m_maxFrameCount{0}
+    , m_frameCount{0} {}
+
+FramePipeline::FramePipeline(const size_t stageCount, const size_t maxFrameCount)
+    : m_stageCount{stageCount}
+    , m_maxFrameCount{maxFrameCount}
+    , m_frameCount{0}
+    , m_stages{std::make_unique<Stage[]>(stageCount)}
+    , m_stageJobs{std::make_unique<JobHandle[]>(stageCount * maxFrameCount)} {
+    assert(stageCount > 0);
+    // The stages of the previous frame must remain accessible.
+    assert(maxFrameCount >= 2);
+    for (size_t s = 0; s < stageCount; ++s) {
+        m_stages[s].prevFrameStage = s;
+    }
+}
+
+void FramePipeline::setStage(const size_t stage, std::function<void(size_t)> task,
+                             const size_t prevFrameStage) {
+    assert(stage < m_stageCount);
+    m_stages[stage].task = std::move(task);
+    if (prevFrameStage != SIZE_MAX) {
+        assert(stage <= prevFrameStage && prevFrameStage < m_stageCount);
+        m_stages[stage].prevFrameStage = prevFrameStage;
+    }
+}
+
+size_t FramePipeline::scheduleFrame() {
+    const size_t frameIndex = m_frameCount;
+    // Make sure the slot of the frame is no longer in use.
+    if (frameIndex >= m_maxFrameCount) {
+        waitForFrame(frameIndex - m_maxFrameCount);
+    }
+    for (size_t s = 0; s < m_stageCount; ++s) {
+        JobHandle dependencies[2];
+        size_t    depCount = 0;
+        if (s > 0) {
+            dependencies[depCount++] = stageJob(frameIndex, s - 1);
+        }
+        if (frameIndex > 0) {
+            dependencies[depCount++] = stageJob(frameIndex - 1, m_stages[s].prevFrameStage);
+        }
+        const std::function<void(size_t)>* task = &m_stages[s].task;
+        m_stageJobs[frameSlot(frameIndex) * m_stageCount + s] =
+            JobSystem::schedule(depCount, dependencies, [task, frameIndex]() {
+                if (*task) (*task)(frameIndex);
+            });
+    }
+    m_frameCount = frameIndex + 1;
+    return frameIndex;
+}
+
+void FramePipeline::waitForFrame(const size_t frameIndex,
+                                 const std::function<void()>& onIdle) const {
+    assert(frameIndex < m_frameCount);
+    // Frames which are no longer tracked have already completed.
+    if (frameIndex + m_maxFrameCount >= m_frameCount) {
+        JobSystem::wait(stageJob(frameIndex, m_stageCount - 1), onIdle);
+    }
+}
+
+void FramePipeline::flush() const {
+    if (m_frameCount > 0) {
+        waitForFrame(m_frameCount - 1);
+    }
+}
+
+size_t FramePipeline::frameCount() const {
+    return m_frameCount;
+}
+
+size_t FramePipeline::frameSlot(const size_t frameIndex) const {
+    return frameIndex % m_maxFrameCount;
+}
+
+const JobHandle& FramePipeline::stageJob(const size_t frameIndex, const size_t stage) const {
+    return m_stageJobs[frameSlot(frameIndex) * m_stageCount + stage];
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include "JobSystem.h"
+
+// Pipelined frame scheduler. Each frame is processed by a sequence of stages
+// (e.g. simulation, culling, recording, submission) executed as jobs of the JobSystem.
+// A stage of a frame starts once the previous stage of the same frame and the same stage
+// of the previous frame are complete, so the stages of consecutive frames overlap.
+// At most 'maxFrameCount' frames are in flight. Therefore, the data of a frame can be stored
+// in the slot 'frameIndex % maxFrameCount', which is reused once the frame is complete.
+class FramePipeline {
+public:
+    RULE_OF_ZERO_MOVE_ONLY(FramePipeline);
+    // Ctor; performs zero-initialization.
+    FramePipeline();
+    // Ctor; takes the number of stages and the maximal number of frames in flight as input.
+    explicit FramePipeline(const size_t stageCount, const size_t maxFrameCount);
+    // Sets the task 'task(frameIndex)' of the stage.
+    // Optionally, the stage can be made to wait for a later stage 'prevFrameStage'
+    // of the previous frame (e.g. recording may have to wait for the submission).
+    void setStage(const size_t stage, std::function<void(size_t)> task,
+                  const size_t prevFrameStage = SIZE_MAX);
+    // Schedules all stages of the next frame. Returns the index of the frame.
+    // If 'maxFrameCount' frames are already in flight, blocks until the oldest one completes.
+    size_t scheduleFrame();
+    // Blocks until all stages of the frame complete.
+    // Meanwhile, the calling thread executes other jobs, and calls 'onIdle()' (if provided)
+    // whenever there are no jobs to execute.
+    void waitForFrame(const size_t frameIndex,
+                      const std::function<void()>& onIdle = nullptr) const;
+    // Blocks until all scheduled frames complete.
+    void flush() const;
+    // Returns the number of scheduled frames.
+    size_t frameCount() const;
+    // Returns the data slot of the frame.
+    size_t frameSlot(const size_t frameIndex) const;
+private:
+    // Returns the handle of the stage of the frame in flight.
+    const JobHandle& stageJob(const size_t frameIndex, const size_t stage) const;
+private:
+    struct Stage {
+        std::function<void(size_t)> task;
+        size_t                      prevFrameStage; // Stage of the previous frame to wait for
+    };
+    size_t                       m_stageCount;
+    size_t                       m_maxFrameCount;
+    size_t                       m_frameCount;      // Number of scheduled frames
+    std::unique_ptr<Stage[]>     m_stages;
+    std::unique_ptr<JobHandle[]> m_stageJobs;       // Per frame slot, per stage
+};
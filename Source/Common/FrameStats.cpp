@@ -0,0 +1,149 @@
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <vector>
+#include "FrameStats.h"
+#include "Utility.h"
+
+using Clock = std::chrono::high_resolution_clock;
+
+static const char* PHASE_NAMES[] = {
+    "culling", "sorting", "recording", "submission", "cpu_frame", "gpu_frame"
+};
+
+static_assert(_countof(PHASE_NAMES) == static_cast<size_t>(FramePhase::COUNT),
+              "Missing phase names.");
+
+Stopwatch::Stopwatch()
+    : m_time{Clock::now()} {}
+
+float Stopwatch::lap() {
+    const Clock::time_point time = Clock::now();
+    const float elapsedTime = std::chrono::duration<float, std::milli>(time - m_time).count();
+    m_time = time;
+    return elapsedTime;
+}
+
+FrameStats::FrameStats()
+    : m_frames{nullptr}
+    , m_capacity{0}
+    , m_frameCount{0}
+    , m_nextFrame{0} {}
+
+FrameStats::FrameStats(const size_t capacity)
+    : m_frames{std::make_unique<FrameTimings[]>(capacity)}
+    , m_capacity{capacity}
+    , m_frameCount{0}
+    , m_nextFrame{0} {
+    assert(capacity > 0);
+}
+
+void FrameStats::addFrame(const FrameTimings& timings) {
+    m_frames[m_nextFrame] = timings;
+    m_nextFrame  = (m_nextFrame + 1) % m_capacity;
+    m_frameCount = std::min(m_frameCount + 1, m_capacity);
+}
+
+size_t FrameStats::frameCount() const {
+    return m_frameCount;
+}
+
+FrameStats::Summary FrameStats::computeSummary(const FramePhase phase) const {
+    Summary summary = {};
+    if (0 == m_frameCount) return summary;
+    // Gather and sort the timings of the phase.
+    const size_t n = m_frameCount;
+    std::vector<float> times(n);
+    double sum = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        times[i] = m_frames[i].phases[static_cast<size_t>(phase)];
+        sum     += times[i];
+    }
+    std::sort(times.begin(), times.end());
+    // Use the nearest-rank method for percentiles.
+    const auto percentile = [&times, n](const float p) {
+        const size_t rank = static_cast<size_t>(ceilf(p * static_cast<float>(n)));
+        return times[std::max(rank, size_t{1}) - 1];
+    };
+    summary.min  = times.front();
+    summary.mean = static_cast<float>(sum / static_cast<double>(n));
+    summary.p50  = percentile(0.50f);
+    summary.p95  = percentile(0.95f);
+    summary.p99  = percentile(0.99f);
+    summary.max  = times.back();
+    // Compute the histogram.
+    const float binCount = static_cast<float>(histBinCount);
+    const float range    = summary.max - summary.min;
+    for (const float time : times) {
+        size_t bin = 0;
+        if (range > 0.f) {
+            bin = static_cast<size_t>((time - summary.min) / range * binCount);
+            bin = std::min(bin, histBinCount - 1);
+        }
+        ++summary.histogram[bin];
+    }
+    return summary;
+}
+
+bool FrameStats::writeJson(const char* fileWithPath) const {
+    FILE* file;
+    // Open the file.
+    if (fopen_s(&file, fileWithPath, "w")) {
+        printError("Failed to create the file: %s", fileWithPath);
+        return false;
+    }
+    fprintf(file, "{\n  \"frames\": %zu,\n  \"phases\": {\n", m_frameCount);
+    for (size_t p = 0; p < static_cast<size_t>(FramePhase::COUNT); ++p) {
+        const Summary s = computeSummary(static_cast<FramePhase>(p));
+        fprintf(file, "    \"%s\": {\n", PHASE_NAMES[p]);
+        fprintf(file, "      \"min\": %.4f, \"mean\": %.4f, \"p50\": %.4f, "
+                      "\"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f,\n",
+                s.min, s.mean, s.p50, s.p95, s.p99, s.max);
+        fprintf(file, "      \"histogram\": {\"min\": %.4f, \"binWidth\": %.4f, \"counts\": [",
+                s.min, (s.max - s.min) / static_cast<float>(histBinCount));
+        for (size_t b = 0; b < histBinCount; ++b) {
+            fprintf(file, b > 0 ? ", %u" : "%u", s.histogram[b]);
+        }
+        const bool isLast = p + 1 == static_cast<size_t>(FramePhase::COUNT);
+        fprintf(file, "]}\n    }%s\n", isLast ? "" : ",");
+    }
+    fprintf(file, "  }\n}\n");
+    // Close the file.
+    const bool success = !ferror(file);
+    fclose(file);
+    if (!success) {
+        printError("Failed to write the file: %s", fileWithPath);
+    }
+    return success;
+}
+
+bool FrameStats::writeCsv(const char* fileWithPath) const {
+    FILE* file;
+    // Open the file.
+    if (fopen_s(&file, fileWithPath, "w")) {
+        printError("Failed to create the file: %s", fileWithPath);
+        return false;
+    }
+    fprintf(file, "phase,frames,min,mean,p50,p95,p99,max,bin_width");
+    for (size_t b = 0; b < histBinCount; ++b) {
+        fprintf(file, ",bin%zu", b);
+    }
+    fprintf(file, "\n");
+    for (size_t p = 0; p < static_cast<size_t>(FramePhase::COUNT); ++p) {
+        const Summary s = computeSummary(static_cast<FramePhase>(p));
+        fprintf(file, "%s,%zu,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f", PHASE_NAMES[p], m_frameCount,
+                s.min, s.mean, s.p50, s.p95, s.p99, s.max,
+                (s.max - s.min) / static_cast<float>(histBinCount));
+        for (size_t b = 0; b < histBinCount; ++b) {
+            fprintf(file, ",%u", s.histogram[b]);
+        }
+        fprintf(file, "\n");
+    }
+    // Close the file.
+    const bool success = !ferror(file);
+    fclose(file);
+    if (!success) {
+        printError("Failed to write the file: %s", fileWithPath);
+    }
+    return success;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include "Definitions.h"
+
+// CPU phases of a frame. The frame times are also tracked.
+enum class FramePhase {
+    CULLING,        // Frustum and screen-space size culling
+    SORTING,        // Front-to-back sorting
+    RECORDING,      // Command list recording
+    SUBMISSION,     // Command list submission and presentation
+    CPU_FRAME,      // Entire frame on the CPU
+    GPU_FRAME,      // Entire frame on the GPU
+    COUNT
+};
+
+// Timings (in milliseconds) of a single frame.
+struct FrameTimings {
+    float& operator[](const FramePhase phase) {
+        return phases[static_cast<size_t>(phase)];
+    }
+public:
+    float phases[static_cast<size_t>(FramePhase::COUNT)];
+};
+
+// Measures the time elapsed between consecutive calls.
+class Stopwatch {
+public:
+    RULE_OF_ZERO(Stopwatch);
+    // Ctor; starts the stopwatch.
+    Stopwatch();
+    // Returns the time (in milliseconds) elapsed since the last call (or construction).
+    float lap();
+private:
+    std::chrono::high_resolution_clock::time_point m_time;
+};
+
+// Collects the timings of the most recent frames in a ring buffer, and
+// reports the summary statistics (min/mean/percentiles/max) and the histograms.
+class FrameStats {
+public:
+    RULE_OF_ZERO_MOVE_ONLY(FrameStats);
+    // Ctor; performs zero-initialization.
+    FrameStats();
+    // Ctor; takes the maximal number of stored frames as input.
+    explicit FrameStats(const size_t capacity);
+    // Stores the timings of the frame. Overwrites the oldest frame if the buffer is full.
+    void addFrame(const FrameTimings& timings);
+    // Returns the number of stored frames.
+    size_t frameCount() const;
+    // Writes the statistics in the JSON format. Returns 'false' on failure.
+    bool writeJson(const char* fileWithPath) const;
+    // Writes the statistics in the CSV format (one row per phase). Returns 'false' on failure.
+    bool writeCsv(const char* fileWithPath) const;
+    // Number of histogram bins. The bins evenly divide the range between min and max.
+    static constexpr size_t histBinCount = 32;
+private:
+    struct Summary {
+        float    min, mean, p50, p95, p99, max;
+        uint32_t histogram[histBinCount];
+    };
+    // Computes the summary of the phase over all stored frames.
+    Summary computeSummary(const FramePhase phase) const;
+private:
+    std::unique_ptr<FrameTimings[]> m_frames;       // Ring buffer
+    size_t                          m_capacity;
+    size_t                          m_frameCount;   // Number of stored frames
+    size_t                          m_nextFrame;    // Index of the next frame to write to
+};
@@ -0,0 +1,96 @@
+#include <cassert>
+#include <cstring>
+#include <immintrin.h>
+#include "HierBitSet.hpp"
+
+HierBitSet::HierBitSet()
+    : m_words{nullptr}
+    , m_summary{nullptr}
+    , m_bitCount{0}
+    , m_wordCount{0}
+    , m_summaryCount{0} {}
+
+HierBitSet::HierBitSet(const size_t size)
+    : m_words{std::make_unique<uint64_t[]>((size + 63) / 64)}
+    , m_summary{std::make_unique<uint64_t[]>((size + 4095) / 4096)}
+    , m_bitCount{size}
+    , m_wordCount{(size + 63) / 64}
+    , m_summaryCount{(size + 4095) / 4096} {
+    memset(m_words.get(),   0, m_wordCount    * sizeof(uint64_t));
+    memset(m_summary.get(), 0, m_summaryCount * sizeof(uint64_t));
+}
+
+void HierBitSet::clear() {
+    forEachWord(m_summary.get(), [this](const size_t w) {
+        m_words[w] = 0;
+    });
+    memset(m_summary.get(), 0, m_summaryCount * sizeof(uint64_t));
+}
+
+void HierBitSet::clearBit(const size_t index) {
+    assert(index < m_bitCount);
+    const size_t w = index / 64;
+    m_words[w] &= ~(1ull << (index % 64));
+    if (0 == m_words[w]) {
+        m_summary[w / 64] &= ~(1ull << (w % 64));
+    }
+}
+
+void HierBitSet::setBit(const size_t index) {
+    assert(index < m_bitCount);
+    const size_t w = index / 64;
+    m_words[w]        |= 1ull << (index % 64);
+    m_summary[w / 64] |= 1ull << (w % 64);
+}
+
+bool HierBitSet::testBit(const size_t index) const {
+    assert(index < m_bitCount);
+    return 0 != (m_words[index / 64] & 1ull << (index % 64));
+}
+
+size_t HierBitSet::size() const {
+    return m_bitCount;
+}
+
+size_t HierBitSet::popCount() const {
+    size_t count = 0;
+    forEachWord(m_summary.get(), [this, &count](const size_t w) {
+        count += _mm_popcnt_u64(m_words[w]);
+    });
+    return count;
+}
+
+bool HierBitSet::any() const {
+    for (size_t s = 0; s < m_summaryCount; ++s) {
+        if (m_summary[s]) return true;
+    }
+    return false;
+}
+
+bool HierBitSet::none() const {
+    return !any();
+}
+
+HierBitSet& HierBitSet::operator|=(const HierBitSet& other) {
+    assert(m_bitCount == other.m_bitCount);
+    // Only the non-empty words of 'other' can change the set.
+    forEachWord(other.m_summary.get(), [this, &other](const size_t w) {
+        m_words[w] |= other.m_words[w];
+    });
+    for (size_t s = 0; s < m_summaryCount; ++s) {
+        m_summary[s] |= other.m_summary[s];
+    }
+    return *this;
+}
+
+HierBitSet& HierBitSet::operator&=(const HierBitSet& other) {
+    assert(m_bitCount == other.m_bitCount);
+    // Only the non-empty words of the set can change.
+    forEachWord(m_summary.get(), [this, &other](const size_t w) {
+        m_words[w] &= other.m_words[w];
+        if (0 == m_words[w]) {
+            m_summary[w / 64] &= ~(1ull << (w % 64));
+        }
+    });
+    return *this;
+}
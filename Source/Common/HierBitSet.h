@@ -0,0 +1,51 @@
+#pragma once
+
+#include <memory>
+#include "Definitions.h"
+
+// Two-level BitSet with size specified at runtime, intended for sparse sets.
+// The bits are stored in 64-bit words, and each word has a summary bit, which is 1
+// if and only if the word is non-zero. Therefore, a summary word covers 4096 bits.
+// Iteration, clearing and bulk operations skip empty words, so their cost is proportional
+// to the number of non-empty words rather than to the size.
+class HierBitSet {
+public:
+    RULE_OF_ZERO_MOVE_ONLY(HierBitSet);
+    // Ctor; performs zero-initialization.
+    HierBitSet();
+    // Ctor; takes the size (number of bits) as input.
+    explicit HierBitSet(const size_t size);
+    // Sets the values of all bits to 0. Only touches non-empty words.
+    void clear();
+    // Sets the value of the specified bit to 0.
+    void clearBit(const size_t index);
+    // Sets the value of the specified bit to 1.
+    void setBit(const size_t index);
+    // Returns 'true' if the specified bit is 1, 'false' otherwise.
+    bool testBit(const size_t index) const;
+    // Returns the size (number of bits).
+    size_t size() const;
+    // Returns the number of bits set to 1.
+    size_t popCount() const;
+    // Returns 'true' if any bit is 1, 'false' otherwise.
+    bool any() const;
+    // Returns 'true' if all bits are 0, 'false' otherwise.
+    bool none() const;
+    // Computes the union with the set of the same size.
+    HierBitSet& operator|=(const HierBitSet& other);
+    // Computes the intersection with the set of the same size.
+    HierBitSet& operator&=(const HierBitSet& other);
+    // Invokes 'f(index)' for each bit set to 1, in the ascending order of indices.
+    template <typename F>
+    void forEachSetBit(F&& f) const;
+private:
+    // Invokes 'f(wordIndex)' for each non-empty word.
+    template <typename F>
+    void forEachWord(const uint64_t* summary, F&& f) const;
+private:
+    std::unique_ptr<uint64_t[]> m_words;
+    std::unique_ptr<uint64_t[]> m_summary;      // Bit per word
+    size_t                      m_bitCount;
+    size_t                      m_wordCount;
+    size_t                      m_summaryCount; // Number of summary words
+};
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <immintrin.h>
+#include "HierBitSet.h"
+
+template <typename F>
+inline void HierBitSet::forEachSetBit(F&& f) const {
+    forEachWord(m_summary.get(), [this, &f](const size_t w) {
+        uint64_t word = m_words[w];
+        while (0 != word) {
+            // Find the lowest set bit, and clear it.
+            const size_t bit = _tzcnt_u64(word);
+            word &= word - 1;
+            f(w * 64 + bit);
+        }
+    });
+}
+
+template <typename F>
+inline void HierBitSet::forEachWord(const uint64_t* summary, F&& f) const {
+    for (size_t s = 0; s < m_summaryCount; ++s) {
+        // Copy the summary word, since 'f' may modify it.
+        uint64_t summaryWord = summary[s];
+        while (0 != summaryWord) {
+            const size_t bit = _tzcnt_u64(summaryWord);
+            summaryWord &= summaryWord - 1;
+            f(s * 64 + bit);
+        }
+    }
+}
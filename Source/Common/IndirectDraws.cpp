@@ -0,0 +1,11 @@
+#include "IndirectDraws.hpp"
+
+DrawCounts buildIndirectDraws(const DrawRange& range, const ObjectSortPair* objSortPairs,
+                              const DrawPacket* drawPackets, const uint32_t rootParam,
+                              IndirectDraw* draws) {
+    assert(objSortPairs && drawPackets && draws);
+    IndirectDrawWriter writer{draws, rootParam};
+    const DrawCounts counts = encodeDraws(writer, range, objSortPairs, drawPackets);
+    assert(writer.drawCount() == counts.drawCount);
+    return counts;
+}
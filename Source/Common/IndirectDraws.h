@@ -0,0 +1,56 @@
+#pragma once
+
+#include "DrawEncoding.h"
+
+// Arguments of an indexed draw. Matches the layout of D3D12_DRAW_INDEXED_ARGUMENTS.
+struct DrawIndexedArgs {
+    uint32_t indexCountPerInstance;
+    uint32_t instanceCount;
+    uint32_t startIndexLocation;
+    int32_t  baseVertexLocation;
+    uint32_t startInstanceLocation;
+};
+
+// Record of the indirect argument stream: the root constants of the draw,
+// followed by the arguments of the draw (see the command signature of the G-buffer pass).
+struct IndirectDraw {
+    static constexpr uint32_t rootConstantCount = 2;
+    uint32_t        rootConstants[rootConstantCount];
+    DrawIndexedArgs args;
+};
+
+static_assert(sizeof(IndirectDraw) == 28, "Invalid indirect draw record size.");
+
+// Command encoder which writes a packed stream of indirect draw records.
+// Only the root constants of a single root parameter can be set; each draw then
+// produces a record containing these constants. The records are written sequentially,
+// and are never read back, so the destination may reside in write-combined memory.
+class IndirectDrawWriter {
+public:
+    RULE_OF_ZERO(IndirectDrawWriter);
+    // Ctor; takes the destination of the records and the index of the root parameter
+    // holding the per-draw root constants as input.
+    explicit IndirectDrawWriter(IndirectDraw* draws, const uint32_t rootParam);
+    // Sets 'count' 32-bit root constants of the root parameter, starting at 'offset'.
+    void setRootConstants(const uint32_t param, const uint32_t count, const void* data,
+                          const uint32_t offset);
+    // Sets a single 32-bit root constant of the root parameter at 'offset'.
+    void setRootConstant(const uint32_t param, const uint32_t value, const uint32_t offset);
+    // Writes the record of the draw of 'indexCount' indices, starting with 'firstIndex'.
+    void drawIndexed(const uint32_t indexCount, const uint32_t firstIndex);
+    // Returns the number of written records.
+    size_t drawCount() const;
+private:
+    IndirectDraw* m_draws;
+    size_t        m_drawCount;
+    uint32_t      m_rootParam;
+    uint32_t      m_rootConstants[IndirectDraw::rootConstantCount];
+};
+
+// Writes the indirect draw records of the visible objects (sorted front to back)
+// within the range into 'draws', coalescing the draws in the same way as encodeDraws().
+// 'draws' must be large enough to hold a record per object within the range.
+// The root constants of the draws are assigned to the root parameter 'rootParam'.
+DrawCounts buildIndirectDraws(const DrawRange& range, const ObjectSortPair* objSortPairs,
+                              const DrawPacket* drawPackets, const uint32_t rootParam,
+                              IndirectDraw* draws);
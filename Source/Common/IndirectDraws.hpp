@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cassert>
+#include <cstring>
+#include "IndirectDraws.h"
+
+inline IndirectDrawWriter::IndirectDrawWriter(IndirectDraw* draws, const uint32_t rootParam)
+    : m_draws{draws}
+    , m_drawCount{0}
+    , m_rootParam{rootParam}
+    , m_rootConstants{} {
+    assert(draws);
+}
+
+inline void IndirectDrawWriter::setRootConstants(const uint32_t param, const uint32_t count,
+                                                 const void* data, const uint32_t offset) {
+    assert(param == m_rootParam && offset + count <= IndirectDraw::rootConstantCount);
+    memcpy(&m_rootConstants[offset], data, count * sizeof(uint32_t));
+}
+
+inline void IndirectDrawWriter::setRootConstant(const uint32_t param, const uint32_t value,
+                                                const uint32_t offset) {
+    assert(param == m_rootParam && offset < IndirectDraw::rootConstantCount);
+    m_rootConstants[offset] = value;
+}
+
+inline void IndirectDrawWriter::drawIndexed(const uint32_t indexCount,
+                                            const uint32_t firstIndex) {
+    // Assemble the record on the stack, and store it in one go.
+    const IndirectDraw draw = {
+        {m_rootConstants[0], m_rootConstants[1]},
+        {indexCount, 1, firstIndex, 0, 0}
+    };
+    m_draws[m_drawCount++] = draw;
+}
+
+inline size_t IndirectDrawWriter::drawCount() const {
+    return m_drawCount;
+}
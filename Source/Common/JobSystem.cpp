@@ -0,0 +1,280 @@
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#ifdef _WIN32
+    #include <objbase.h>
+#endif
+#include "JobSystem.h"
+
+struct Job {
+    std::function<void()>             task;
+    std::atomic<size_t>               blockCount;   // Incomplete dependencies (+1 during setup)
+    std::atomic<bool>                 isComplete;
+    std::mutex                        mutex;        // Guards 'successors' and 'isComplete' writes
+    std::vector<std::shared_ptr<Job>> successors;   // Jobs which depend on this job
+};
+
+struct JobSystem::State {
+    // Double-ended queue of jobs. The owner pushes and pops jobs at the back (LIFO),
+    // while other threads steal jobs from the front (FIFO).
+    struct WorkQueue {
+        std::mutex                       mutex;
+        std::deque<std::shared_ptr<Job>> jobs;
+    };
+    size_t                         workerCount;
+    std::unique_ptr<WorkQueue[]>   queues;          // Per worker, and 1 for other threads
+    std::unique_ptr<std::thread[]> workers;
+    std::atomic<size_t>            queuedJobCount;
+    std::atomic<bool>              isStopping;
+    std::mutex                     sleepMutex;      // Used by idle workers
+    std::condition_variable        wakeCondition;   // Signaled once a job is queued
+};
+
+// Perform static member initialization.
+std::unique_ptr<JobSystem::State> JobSystem::m_state;
+
+// Index of the queue of the calling thread. Threads which are not workers share a queue.
+static thread_local size_t t_queueIndex = SIZE_MAX;
+
+JobHandle::JobHandle(std::shared_ptr<Job> job)
+    : m_job{std::move(job)} {}
+
+bool JobHandle::isComplete() const {
+    return !m_job || m_job->isComplete.load(std::memory_order_acquire);
+}
+
+void JobSystem::start(const size_t workerCount) {
+    assert(!m_state);
+    m_state = std::make_unique<State>();
+    if (workerCount > 0) {
+        m_state->workerCount = workerCount;
+    } else {
+        // Leave one logical core for the calling thread.
+        const size_t coreCount = std::thread::hardware_concurrency();
+        m_state->workerCount   = std::max<size_t>(coreCount, 2) - 1;
+    }
+    const size_t n = m_state->workerCount;
+    m_state->queues         = std::make_unique<State::WorkQueue[]>(n + 1);
+    m_state->workers        = std::make_unique<std::thread[]>(n);
+    m_state->queuedJobCount = 0;
+    m_state->isStopping     = false;
+    for (size_t i = 0; i < n; ++i) {
+        m_state->workers[i] = std::thread{runWorker, i};
+    }
+}
+
+void JobSystem::stop() {
+    assert(m_state);
+    {
+        std::lock_guard<std::mutex> lock{m_state->sleepMutex};
+        m_state->isStopping = true;
+    }
+    m_state->wakeCondition.notify_all();
+    // The workers exit once all queues are empty.
+    for (size_t i = 0, n = m_state->workerCount; i < n; ++i) {
+        m_state->workers[i].join();
+    }
+    // Without workers, the jobs have to be executed by the calling thread.
+    while (tryExecuteJob()) {}
+    m_state.reset();
+}
+
+size_t JobSystem::workerCount() {
+    assert(m_state);
+    return m_state->workerCount;
+}
+
+size_t JobSystem::threadIndex() {
+    assert(m_state);
+    return std::min(t_queueIndex, m_state->workerCount);
+}
+
+JobHandle JobSystem::schedule(std::function<void()> task) {
+    return schedule(0, nullptr, std::move(task));
+}
+
+JobHandle JobSystem::schedule(const size_t depCount, const JobHandle* dependencies,
+                              std::function<void()> task) {
+    assert(m_state);
+    auto job = std::make_shared<Job>();
+    job->task       = std::move(task);
+    job->blockCount = 1;
+    job->isComplete = false;
+    // Register the job as a successor of each incomplete dependency.
+    for (size_t i = 0; i < depCount; ++i) {
+        const std::shared_ptr<Job>& dep = dependencies[i].m_job;
+        if (dep) {
+            std::lock_guard<std::mutex> lock{dep->mutex};
+            if (!dep->isComplete.load(std::memory_order_relaxed)) {
+                job->blockCount.fetch_add(1, std::memory_order_relaxed);
+                dep->successors.push_back(job);
+            }
+        }
+    }
+    // Remove the setup block.
+    if (1 == job->blockCount.fetch_sub(1, std::memory_order_acq_rel)) {
+        enqueue(job);
+    }
+    return JobHandle{std::move(job)};
+}
+
+void JobSystem::wait(const JobHandle& handle) {
+    wait(handle, nullptr);
+}
+
+void JobSystem::wait(const JobHandle& handle, const std::function<void()>& onIdle) {
+    assert(m_state);
+    while (!handle.isComplete()) {
+        if (!tryExecuteJob()) {
+            if (onIdle) onIdle();
+            std::this_thread::yield();
+        }
+    }
+}
+
+void JobSystem::parallelFor(const size_t count, const size_t grainSize,
+                            const std::function<void(size_t, size_t)>& body) {
+    assert(m_state && grainSize > 0);
+    const size_t chunkCount = (count + grainSize - 1) / grainSize;
+    if (chunkCount <= 1 || 0 == m_state->workerCount) {
+        if (count > 0) body(0, count);
+        return;
+    }
+    // Schedule all chunks except for the first one, which is processed by the calling thread.
+    std::vector<JobHandle> chunkJobs;
+    chunkJobs.reserve(chunkCount - 1);
+    for (size_t c = 1; c < chunkCount; ++c) {
+        const size_t begin = c * grainSize;
+        const size_t end   = std::min(begin + grainSize, count);
+        chunkJobs.push_back(schedule([&body, begin, end]() { body(begin, end); }));
+    }
+    body(0, grainSize);
+    for (const JobHandle& chunkJob : chunkJobs) {
+        wait(chunkJob);
+    }
+}
+
+void JobSystem::isolatedParallelFor(const size_t count, const size_t grainSize,
+                                    const std::function<void(size_t, size_t)>& body) {
+    assert(m_state && grainSize > 0);
+    const size_t chunkCount = (count + grainSize - 1) / grainSize;
+    if (chunkCount <= 1 || 0 == m_state->workerCount) {
+        if (count > 0) body(0, count);
+        return;
+    }
+    // The chunks are claimed by the calling thread and the helper jobs. Since the calling
+    // thread processes the chunks itself, it only has to wait for the ones in progress.
+    // The helpers may start after the loop is complete, so they share the ownership
+    // of the counters (and do not access the body then).
+    struct Counters {
+        std::atomic<size_t> nextChunk{0};
+        std::atomic<size_t> completeChunkCount{0};
+    };
+    const auto counters = std::make_shared<Counters>();
+    const auto process  = [counters, &body, count, grainSize, chunkCount]() {
+        size_t c;
+        while ((c = counters->nextChunk.fetch_add(1, std::memory_order_relaxed)) < chunkCount) {
+            const size_t begin = c * grainSize;
+            const size_t end   = std::min(begin + grainSize, count);
+            body(begin, end);
+            counters->completeChunkCount.fetch_add(1, std::memory_order_release);
+        }
+    };
+    const size_t helperCount = std::min(chunkCount - 1, m_state->workerCount);
+    for (size_t h = 0; h < helperCount; ++h) {
+        schedule(process);
+    }
+    process();
+    while (counters->completeChunkCount.load(std::memory_order_acquire) < chunkCount) {
+        std::this_thread::yield();
+    }
+}
+
+void JobSystem::runWorker(const size_t index) {
+    t_queueIndex = index;
+    #ifdef _WIN32
+        // Jobs may use COM-based APIs (e.g. WIC).
+        const HRESULT hr = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+    #endif
+    while (true) {
+        if (tryExecuteJob()) continue;
+        // Sleep until a job is queued.
+        std::unique_lock<std::mutex> lock{m_state->sleepMutex};
+        m_state->wakeCondition.wait(lock, []() {
+            return m_state->queuedJobCount.load() > 0 || m_state->isStopping.load();
+        });
+        if (m_state->isStopping.load() && 0 == m_state->queuedJobCount.load()) break;
+    }
+    #ifdef _WIN32
+        if (SUCCEEDED(hr)) {
+            CoUninitialize();
+        }
+    #endif
+}
+
+void JobSystem::enqueue(std::shared_ptr<Job> job) {
+    const size_t n = m_state->workerCount;
+    // Threads which are not workers use the last queue.
+    State::WorkQueue& queue = m_state->queues[std::min(t_queueIndex, n)];
+    {
+        std::lock_guard<std::mutex> lock{queue.mutex};
+        queue.jobs.push_back(std::move(job));
+    }
+    m_state->queuedJobCount.fetch_add(1);
+    // Acquire the mutex to avoid a lost wake-up of a worker which is about to sleep.
+    {
+        std::lock_guard<std::mutex> lock{m_state->sleepMutex};
+    }
+    m_state->wakeCondition.notify_one();
+}
+
+bool JobSystem::tryExecuteJob() {
+    const size_t n = m_state->workerCount;
+    const size_t q = std::min(t_queueIndex, n);
+    std::shared_ptr<Job> job;
+    // Pop the most recently queued job from the own queue.
+    {
+        State::WorkQueue& queue = m_state->queues[q];
+        std::lock_guard<std::mutex> lock{queue.mutex};
+        if (!queue.jobs.empty()) {
+            job = std::move(queue.jobs.back());
+            queue.jobs.pop_back();
+        }
+    }
+    // Steal the least recently queued job from another queue.
+    for (size_t i = 1; !job && i <= n; ++i) {
+        State::WorkQueue& queue = m_state->queues[(q + i) % (n + 1)];
+        std::lock_guard<std::mutex> lock{queue.mutex};
+        if (!queue.jobs.empty()) {
+            job = std::move(queue.jobs.front());
+            queue.jobs.pop_front();
+        }
+    }
+    if (!job) return false;
+    m_state->queuedJobCount.fetch_sub(1);
+    execute(job);
+    return true;
+}
+
+void JobSystem::execute(const std::shared_ptr<Job>& job) {
+    job->task();
+    // Release the resources captured by the task.
+    job->task = nullptr;
+    // Mark the job as complete, and unblock its successors.
+    std::vector<std::shared_ptr<Job>> successors;
+    {
+        std::lock_guard<std::mutex> lock{job->mutex};
+        job->isComplete.store(true, std::memory_order_release);
+        successors.swap(job->successors);
+    }
+    for (auto& successor : successors) {
+        if (1 == successor->blockCount.fetch_sub(1, std::memory_order_acq_rel)) {
+            enqueue(std::move(successor));
+        }
+    }
+}
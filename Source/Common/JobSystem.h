@@ -0,0 +1,75 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include "Definitions.h"
+
+struct Job;
+
+// Handle of a scheduled job. Can be waited on, or used as a dependency of other jobs.
+// A default-constructed handle refers to a job which has already completed.
+class JobHandle {
+public:
+    RULE_OF_ZERO(JobHandle);
+    JobHandle() = default;
+    // Returns 'true' if the job has completed.
+    bool isComplete() const;
+private:
+    explicit JobHandle(std::shared_ptr<Job> job);
+private:
+    std::shared_ptr<Job> m_job;
+    /* Accessors */
+    friend class JobSystem;
+};
+
+// Persistent pool of worker threads executing jobs.
+// Each worker owns a queue of jobs; idle workers steal jobs from the queues of other workers.
+// Threads which are not workers (e.g. the main thread) share a separate queue.
+// A job with dependencies is queued once all of its dependencies complete.
+class JobSystem {
+public:
+    STATIC_CLASS(JobSystem);
+    // Starts 'workerCount' worker threads.
+    // If 'workerCount' is 0, one worker per logical core (except for the calling thread) is used.
+    static void start(const size_t workerCount = 0);
+    // Waits for all scheduled jobs to complete, and stops the worker threads.
+    static void stop();
+    // Returns the number of worker threads.
+    static size_t workerCount();
+    // Returns the index of the calling thread: [0, workerCount) for workers,
+    // and workerCount for all other threads.
+    static size_t threadIndex();
+    // Schedules the job for execution. Returns the handle of the job.
+    static JobHandle schedule(std::function<void()> task);
+    // Schedules the job for execution after all 'depCount' dependencies complete.
+    // Returns the handle of the job.
+    static JobHandle schedule(const size_t depCount, const JobHandle* dependencies,
+                              std::function<void()> task);
+    // Blocks until the job completes. Meanwhile, the calling thread executes other jobs.
+    static void wait(const JobHandle& handle);
+    // Same as above, but calls 'onIdle()' whenever there are no jobs to execute
+    // (e.g. to keep processing window messages).
+    static void wait(const JobHandle& handle, const std::function<void()>& onIdle);
+    // Splits the range [0, count) into chunks of up to 'grainSize' indices, and invokes
+    // 'body(begin, end)' for each chunk in parallel. Blocks until all chunks are processed.
+    static void parallelFor(const size_t count, const size_t grainSize,
+                            const std::function<void(size_t, size_t)>& body);
+    // Same as above, but while waiting, the calling thread only processes the chunks of this
+    // loop, and never executes unrelated jobs. Use it while holding a resource other jobs
+    // may wait for (e.g. a reservation of the upload buffer).
+    static void isolatedParallelFor(const size_t count, const size_t grainSize,
+                                    const std::function<void(size_t, size_t)>& body);
+private:
+    struct State;
+    // Worker thread main loop.
+    static void runWorker(const size_t index);
+    // Queues the job whose dependencies have completed.
+    static void enqueue(std::shared_ptr<Job> job);
+    // Attempts to execute a single job: first from the own queue of the calling thread,
+    // then from the queues of other threads. Returns 'false' if no job has been found.
+    static bool tryExecuteJob();
+    // Executes the job, and queues its successors which are no longer blocked.
+    static void execute(const std::shared_ptr<Job>& job);
+private:
+    static std::unique_ptr<State> m_state;
+};
@@ -0,0 +1,81 @@
+#include <cassert>
+#include <cstring>
+#include "MaterialRegistry.hpp"
+#include "Utility.h"
+
+uint16_t MaterialRegistry::acquire(const Material& material) {
+    const auto it = m_lookup.find(material);
+    if (it != m_lookup.end()) {
+        return it->second;
+    }
+    // The IDs are 16-bit, and are also used in the sort keys and the draw packets.
+    if (m_materials.size() >= maxSize) {
+        printError("The number of unique materials exceeds the limit of %zu.", maxSize);
+        TERMINATE();
+    }
+    const uint16_t id = static_cast<uint16_t>(m_materials.size());
+    m_materials.push_back(material);
+    // Make sure the padding is initialized, since the entire record is uploaded.
+    memset(m_materials.back().pad, 0, sizeof(Material::pad));
+    m_isChanged.push_back(false);
+    m_lookup.emplace(material, id);
+    markChanged(id);
+    return id;
+}
+
+void MaterialRegistry::update(const uint16_t id, const Material& material) {
+    assert(id < m_materials.size());
+    // Only remove the old record from the lookup table if it refers to this ID.
+    const auto it = m_lookup.find(m_materials[id]);
+    if (it != m_lookup.end() && it->second == id) {
+        m_lookup.erase(it);
+    }
+    m_materials[id] = material;
+    memset(m_materials[id].pad, 0, sizeof(Material::pad));
+    m_lookup.emplace(material, id);
+    markChanged(id);
+}
+
+const Material& MaterialRegistry::operator[](const uint16_t id) const {
+    assert(id < m_materials.size());
+    return m_materials[id];
+}
+
+size_t MaterialRegistry::size() const {
+    return m_materials.size();
+}
+
+const Material* MaterialRegistry::data() const {
+    return m_materials.data();
+}
+
+void MaterialRegistry::clearChanges() {
+    for (const uint16_t id : m_changedIds) {
+        m_isChanged[id] = false;
+    }
+    m_changedIds.clear();
+}
+
+size_t MaterialRegistry::MaterialHash::operator()(const Material& material) const {
+    // FNV-1a over the texture indices.
+    const uint32_t texIds[] = {material.metalTexId, material.baseTexId, material.bumpTexId,
+                               material.maskTexId,  material.roughTexId};
+    uint64_t hash = 14695981039346656037ull;
+    for (const uint32_t texId : texIds) {
+        hash = (hash ^ texId) * 1099511628211ull;
+    }
+    return static_cast<size_t>(hash);
+}
+
+bool MaterialRegistry::MaterialEqual::operator()(const Material& a, const Material& b) const {
+    return a.metalTexId == b.metalTexId && a.baseTexId  == b.baseTexId &&
+           a.bumpTexId  == b.bumpTexId  && a.maskTexId  == b.maskTexId &&
+           a.roughTexId == b.roughTexId;
+}
+
+void MaterialRegistry::markChanged(const uint16_t id) {
+    if (!m_isChanged[id]) {
+        m_isChanged[id] = true;
+        m_changedIds.push_back(id);
+    }
+}
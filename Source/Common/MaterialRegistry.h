@@ -0,0 +1,60 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+#include "Definitions.h"
+
+// Contains texture array indices.
+struct Material {
+    uint32_t metalTexId;    // Metallicness map index
+    uint32_t baseTexId;     // Base color texture index
+    uint32_t bumpTexId;     // Bump map index
+    uint32_t maskTexId;     // Alpha mask index
+    uint32_t roughTexId;    // Roughness map index
+    byte_t   pad[12];       // 16 byte alignment
+};
+
+// Growable registry of unique materials.
+// Materials are identified by dense IDs, which are their indices within the material buffer.
+// Identical materials share the same ID. The registry tracks the materials added or changed
+// since the last upload, so that only they have to be uploaded to the GPU.
+// IDs are 16-bit, since the G-buffer stores them in a 16-bit render target.
+class MaterialRegistry {
+public:
+    // Maximal number of materials.
+    static constexpr size_t maxSize = 65536;
+    RULE_OF_ZERO_MOVE_ONLY(MaterialRegistry);
+    MaterialRegistry() = default;
+    // Returns the ID of the material. Adds the material to the registry
+    // unless an identical material is already present.
+    uint16_t acquire(const Material& material);
+    // Replaces the material with the specified ID (e.g. once its texture is replaced).
+    // Other IDs referring to identical materials remain unchanged.
+    void update(const uint16_t id, const Material& material);
+    // Returns the material with the specified ID.
+    const Material& operator[](const uint16_t id) const;
+    // Returns the number of materials.
+    size_t size() const;
+    // Returns the pointer to the array of all materials.
+    const Material* data() const;
+    // Invokes 'f(first, count)' for each range of consecutive materials added or changed
+    // since the last call, in the ascending order of IDs. Clears the changes afterwards.
+    template <typename F>
+    void flushChanges(F&& f);
+    // Clears the changes without processing them (e.g. once all materials are uploaded).
+    void clearChanges();
+private:
+    struct MaterialHash {
+        size_t operator()(const Material& material) const;
+    };
+    struct MaterialEqual {
+        bool operator()(const Material& a, const Material& b) const;
+    };
+    // Marks the material with the specified ID as changed.
+    void markChanged(const uint16_t id);
+private:
+    std::vector<Material>                                           m_materials;
+    std::unordered_map<Material, uint16_t, MaterialHash, MaterialEqual> m_lookup;
+    std::vector<uint16_t>                                           m_changedIds;
+    std::vector<bool>                                               m_isChanged;
+};
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <algorithm>
+#include "MaterialRegistry.h"
+
+template <typename F>
+inline void MaterialRegistry::flushChanges(F&& f) {
+    std::sort(m_changedIds.begin(), m_changedIds.end());
+    // Coalesce consecutive IDs into ranges.
+    for (size_t i = 0, n = m_changedIds.size(); i < n; ) {
+        const size_t first = m_changedIds[i];
+        size_t       count = 1;
+        for (++i; i < n && m_changedIds[i] == first + count; ++i) {
+            ++count;
+        }
+        f(first, count);
+    }
+    clearChanges();
+}
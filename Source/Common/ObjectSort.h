@@ -0,0 +1,17 @@
+#pragma once
+
+#include "Definitions.h"
+
+union ObjectSortKey {
+    float   depth;   // Always positive, therefore 'integer' is always positive
+    int32_t integer; // Used for sorting, slightly faster than using floating point values
+};
+
+struct ObjectSortPair {
+    bool operator<(const ObjectSortPair& other) const {
+        return key.integer < other.key.integer;
+    }
+public:
+    ObjectSortKey key;
+    uint32_t      index;
+};
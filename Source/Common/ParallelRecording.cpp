@@ -0,0 +1,34 @@
+#include <algorithm>
+#include <cassert>
+#include "JobSystem.h"
+#include "ParallelRecording.h"
+
+size_t computeCommandListCount(const size_t drawCount, const size_t threadCount,
+                               const size_t maxListCount, const size_t minDrawCount) {
+    assert(threadCount > 0 && maxListCount > 0 && minDrawCount > 0);
+    // Splitting a small number of draws is not worth the overhead of an extra command list.
+    const size_t listCount = std::min(std::min(threadCount, maxListCount),
+                                      drawCount / minDrawCount);
+    return std::max<size_t>(listCount, 1);
+}
+
+DrawRange computeDrawRange(const size_t drawCount, const size_t listCount,
+                           const size_t listIndex) {
+    assert(listIndex < listCount);
+    // The first 'remainder' lists receive one extra draw.
+    const size_t quotient  = drawCount / listCount;
+    const size_t remainder = drawCount % listCount;
+    const size_t begin     = listIndex * quotient + std::min(listIndex, remainder);
+    const size_t end       = begin + quotient + (listIndex < remainder ? 1 : 0);
+    return DrawRange{begin, end};
+}
+
+void recordDraws(const size_t drawCount, const size_t listCount,
+                 const std::function<void(size_t, DrawRange)>& recordRange) {
+    assert(listCount > 0);
+    JobSystem::parallelFor(listCount, 1, [&](size_t begin, size_t end) {
+        for (size_t k = begin; k < end; ++k) {
+            recordRange(k, computeDrawRange(drawCount, listCount, k));
+        }
+    });
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <functional>
+#include "Definitions.h"
+
+// Contiguous range [begin, end) of draws recorded into a single command list.
+struct DrawRange {
+    size_t begin, end;
+};
+
+// Chooses the number of command lists used to record 'drawCount' draws using 'threadCount'
+// threads. Uses at most 'maxListCount' lists, with at least 'minDrawCount' draws per list.
+// Always returns at least 1.
+size_t computeCommandListCount(const size_t drawCount, const size_t threadCount,
+                               const size_t maxListCount, const size_t minDrawCount);
+
+// Returns the range of draws of the command list with the specified index.
+// The draws are split into 'listCount' contiguous ranges of (nearly) equal size,
+// in ascending order. Therefore, submitting the lists in ascending order preserves
+// the order of draws.
+DrawRange computeDrawRange(const size_t drawCount, const size_t listCount,
+                           const size_t listIndex);
+
+// Records 'drawCount' draws into 'listCount' command lists in parallel (using the JobSystem).
+// Calls 'recordRange(listIndex, range)' exactly once for each command list.
+// Blocks until all command lists are recorded.
+void recordDraws(const size_t drawCount, const size_t listCount,
+                 const std::function<void(size_t, DrawRange)>& recordRange);
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include "Math.h"
 #include "Primitives.h"
 
@@ -242,3 +243,135 @@ bool Frustum::intersects(const Sphere& sphere, float* distance) const {
         return true;
     }
 }
+
+bool Frustum::intersectsExactly(const AABox& aaBox) const {
+    const XMVECTOR center   = aaBox.center();
+    const XMVECTOR extents  = 0.5f * (aaBox.maxPoint() - aaBox.minPoint());
+    const XMVECTOR centerX  = XMVectorSplatX(center);
+    const XMVECTOR centerY  = XMVectorSplatY(center);
+    const XMVECTOR centerZ  = XMVectorSplatZ(center);
+    const XMVECTOR extentsX = XMVectorSplatX(extents);
+    const XMVECTOR extentsY = XMVectorSplatY(extents);
+    const XMVECTOR extentsZ = XMVectorSplatZ(extents);
+    // Test 4 axes at a time.
+    XMVECTOR separatedTests = XMVectorFalseInt();
+    for (size_t g = 0; g < 5; ++g) {
+        const XMVECTOR axesX = XMLoadFloat4A(&m_tSepAxes[g][0]);
+        const XMVECTOR axesY = XMLoadFloat4A(&m_tSepAxes[g][1]);
+        const XMVECTOR axesZ = XMLoadFloat4A(&m_tSepAxes[g][2]);
+        // Project the box onto the axes.
+        const XMVECTOR projCenter = axesX * centerX + axesY * centerY + axesZ * centerZ;
+        const XMVECTOR projRadius = XMVectorAbs(axesX) * extentsX
+                                  + XMVectorAbs(axesY) * extentsY
+                                  + XMVectorAbs(axesZ) * extentsZ;
+        // Test the projection of the box against the projection of the frustum.
+        const XMVECTOR aboveTests = XMVectorGreater(projCenter - projRadius,
+                                                    XMLoadFloat4A(&m_sepAxisMaxs[g]));
+        const XMVECTOR belowTests = XMVectorLess(projCenter + projRadius,
+                                                 XMLoadFloat4A(&m_sepAxisMins[g]));
+        separatedTests = XMVectorOrInt(separatedTests, XMVectorOrInt(aboveTests, belowTests));
+    }
+    // Check if at least one of the 'separated' tests passed.
+    return XMVector4EqualInt(separatedTests, XMVectorFalseInt());
+}
+
+void Frustum::computeSeparatingAxes(const XMVECTOR (&corners)[4], FXMVECTOR apex) {
+    // The frustum is unbounded, so its edges are composed of 4 rays emanating from the
+    // corners, and the 4 edges of the far face (parallel to the X and Y axes of the camera).
+    const XMVECTOR edgeDirs[6] = {
+        corners[0] - apex, corners[1] - apex, corners[2] - apex, corners[3] - apex,
+        corners[1] - corners[0], corners[2] - corners[0]
+    };
+    // Compute the cross products of the edges of the box (aligned with X, Y and Z)
+    // and the edges of the frustum. There are 18 unique axes; pad the last group.
+    const XMVECTOR boxEdgeDirs[3] = {g_XMIdentityR0, g_XMIdentityR1, g_XMIdentityR2};
+    XMVECTOR axes[20];
+    for (size_t i = 0; i < 3; ++i) {
+        for (size_t j = 0; j < 6; ++j) {
+            axes[6 * i + j] = XMVector3Cross(boxEdgeDirs[i], edgeDirs[j]);
+        }
+    }
+    axes[18] = axes[16];
+    axes[19] = axes[17];
+    // Project the frustum onto the axes.
+    const auto dot = [](FXMVECTOR a, FXMVECTOR b) {
+        return XMVectorGetX(SSE4::XMVector3Dot(a, b));
+    };
+    for (size_t g = 0; g < 5; ++g) {
+        XMVECTOR mins = g_XMZero, maxs = g_XMZero;
+        for (size_t a = 0; a < 4; ++a) {
+            const XMVECTOR axis = axes[4 * g + a];
+            float projMin = INFINITY, projMax = -INFINITY;
+            for (size_t c = 0; c < 4; ++c) {
+                const float proj = dot(axis, corners[c]);
+                projMin = std::min(projMin, proj);
+                projMax = std::max(projMax, proj);
+            }
+            // The projection of the frustum is unbounded in the direction of the rays.
+            for (size_t r = 0; r < 4; ++r) {
+                const float proj = dot(axis, edgeDirs[r]);
+                if (proj < 0.f) projMin = -INFINITY;
+                if (proj > 0.f) projMax =  INFINITY;
+            }
+            mins = XMVectorSetByIndex(mins, projMin, a);
+            maxs = XMVectorSetByIndex(maxs, projMax, a);
+        }
+        // Transpose the axes of the group.
+        const XMMATRIX tAxes = XMMatrixTranspose(XMMATRIX{axes[4 * g + 0], axes[4 * g + 1],
+                                                          axes[4 * g + 2], axes[4 * g + 3]});
+        XMStoreFloat4A(&m_tSepAxes[g][0], tAxes.r[0]);
+        XMStoreFloat4A(&m_tSepAxes[g][1], tAxes.r[1]);
+        XMStoreFloat4A(&m_tSepAxes[g][2], tAxes.r[2]);
+        XMStoreFloat4A(&m_sepAxisMins[g], mins);
+        XMStoreFloat4A(&m_sepAxisMaxs[g], maxs);
+    }
+}
+
+float Frustum::computeMargin(const AABox& aaBox) const {
+    const XMVECTOR pMin = aaBox.minPoint();
+    const XMVECTOR pMax = aaBox.maxPoint();
+    const XMMATRIX tPlanes = XMLoadFloat4x4A(&m_tPlanes);
+    // Get the signs of the X, Y, Z components of all 4 plane normals.
+    const XMVECTOR normalComponentSigns[3] = {
+        XMLoadFloat4A(&m_tPlanesSgn[0]),
+        XMLoadFloat4A(&m_tPlanesSgn[1]),
+        XMLoadFloat4A(&m_tPlanesSgn[2])
+    };
+    // Find 4 points with largest signed distances along plane normals, transposed.
+    const XMVECTOR tLargestSignDistPoints[3] = {
+        XMVectorSelect(XMVectorSplatX(pMin), XMVectorSplatX(pMax), normalComponentSigns[0]),
+        XMVectorSelect(XMVectorSplatY(pMin), XMVectorSplatY(pMax), normalComponentSigns[1]),
+        XMVectorSelect(XMVectorSplatZ(pMin), XMVectorSplatZ(pMax), normalComponentSigns[2])
+    };
+    // Compute the signed distances to the left/right/top/bottom frustum planes.
+    const XMVECTOR upperPart = tPlanes.r[0] * tLargestSignDistPoints[0]
+                             + tPlanes.r[1] * tLargestSignDistPoints[1];
+    const XMVECTOR lowerPart = tPlanes.r[2] * tLargestSignDistPoints[2]
+                             + tPlanes.r[3];
+    const XMVECTOR signDists = upperPart + lowerPart;
+    // Compute the signed distance to the far plane.
+    const XMVECTOR signDist  = XMVectorReplicate(computeDistance(aaBox));
+    // Return the smallest of the 5 distances.
+    return XMVectorGetX(XMVectorMin(XMVector4Min(signDists), signDist));
+}
+
+float Frustum::computeDistance(const AABox& aaBox) const {
+    const XMVECTOR farPlane = XMLoadFloat4A(&m_farPlane);
+    // Find a point with the largest signed distance to the plane.
+    const XMVECTOR normalComponentSign  = XMLoadFloat4A(&m_farPlaneSgn);
+    XMVECTOR       largestSignDistPoint = XMVectorSelect(aaBox.minPoint(), aaBox.maxPoint(),
+                                                         normalComponentSign);
+    largestSignDistPoint = SSE4::XMVectorSetW(largestSignDistPoint, 1.f);
+    // Compute the signed distance to the far plane.
+    return XMVectorGetX(SSE4::XMVector4Dot(farPlane, largestSignDistPoint));
+}
+
+XMVECTOR Frustum::computePlane(const size_t index) const {
+    assert(index <= 4);
+    if (index < 4) {
+        const XMMATRIX planes = XMMatrixTranspose(XMLoadFloat4x4A(&m_tPlanes));
+        return planes.r[index];
+    } else {
+        return XMLoadFloat4A(&m_farPlane);
+    }
+}
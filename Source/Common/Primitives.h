@@ -72,12 +72,36 @@ public:
     // Returns 'true' if the sphere overlaps the frustum, 'false' otherwise.
     // In case there is an overlap, it also returns the largest distance (always positive).
     bool intersects(const Sphere& sphere, float* distance) const;
+    // Refines the result of intersects() for a box which has passed the test.
+    // Tests the axes formed by the cross products of the box and the frustum edges.
+    // Together with intersects(), it forms an exact separating axis test.
+    // Returns 'true' if the box overlaps the frustum, 'false' otherwise.
+    bool intersectsExactly(const AABox& aaBox) const;
+    // Returns the smallest of the 5 largest signed distances from the box to the planes.
+    // The value is positive if the box passes all plane tests, and non-positive otherwise.
+    // Its magnitude is the distance the planes have to move to change the outcome of the tests.
+    // The test against the bounding box of the frustum is not taken into account.
+    float computeMargin(const AABox& aaBox) const;
+    // Returns the largest signed distance from the box to the far plane.
+    // It corresponds to the distance returned by intersects().
+    float computeDistance(const AABox& aaBox) const;
+    // Returns the equation of the plane with the specified index:
+    // 0 - left, 1 - right, 2 - top, 3 - bottom, 4 - far.
+    DirectX::XMVECTOR computePlane(const size_t index) const;
+private:
+    // Computes the separating axes used by intersectsExactly(). Takes the 4 corners of
+    // the frustum lying on the far plane and the apex of the frustum as input.
+    void computeSeparatingAxes(const DirectX::XMVECTOR (&corners)[4], DirectX::FXMVECTOR apex);
 private:
     AABox                m_bBox;          // Bounding box of the frustum
     DirectX::XMFLOAT4X4A m_tPlanes;       // Transposed equations of left/right/top/bottom planes
     DirectX::XMFLOAT4A   m_tPlanesSgn[3]; // Signs of X, Y, Z components of 'm_tPlanes' (cmp >= 0)
     DirectX::XMFLOAT4A   m_farPlane;      // Equation of the far plane
     DirectX::XMFLOAT4A   m_farPlaneSgn;   // Signs of X, Y, Z components of 'm_farPlane' (cmp >= 0)
+    DirectX::XMFLOAT4A   m_tSepAxes[5][3]; // 20 separating axes, transposed in groups of 4
+    DirectX::XMFLOAT4A   m_sepAxisMins[5]; // Minima of projections of the frustum onto the axes
+    DirectX::XMFLOAT4A   m_sepAxisMaxs[5]; // Maxima of projections of the frustum onto the axes
     /* Accessors */
     friend class PerspectiveCamera;
+    friend class FrustumSet;
 };
@@ -0,0 +1,229 @@
+#include <algorithm>
+#include <cassert>
+#include "RenderGraph.h"
+
+using Barrier = RenderGraph::Barrier;
+
+auto RenderGraph::importResource(const uint32_t state)
+-> ResourceId {
+    m_resources.push_back(Resource{Kind::IMPORTED, state, 0, 0, 0, {}});
+    return static_cast<ResourceId>(m_resources.size() - 1);
+}
+
+auto RenderGraph::importLoopedResource()
+-> ResourceId {
+    m_resources.push_back(Resource{Kind::LOOPED, 0, 0, 0, 0, {}});
+    return static_cast<ResourceId>(m_resources.size() - 1);
+}
+
+auto RenderGraph::createTransient(const size_t size, const size_t alignment)
+-> ResourceId {
+    assert(size > 0 && alignment > 0 && 0 == (alignment & (alignment - 1)));
+    m_resources.push_back(Resource{Kind::TRANSIENT, 0, size, alignment, 0, {}});
+    return static_cast<ResourceId>(m_resources.size() - 1);
+}
+
+auto RenderGraph::addPass()
+-> PassId {
+    return static_cast<PassId>(m_passCount++);
+}
+
+void RenderGraph::read(const PassId pass, const ResourceId resource, const uint32_t state) {
+    addUse(pass, resource, state, false);
+}
+
+void RenderGraph::write(const PassId pass, const ResourceId resource, const uint32_t state) {
+    addUse(pass, resource, state, true);
+}
+
+void RenderGraph::addUse(const PassId pass, const ResourceId resource, const uint32_t state,
+                         const bool isWrite) {
+    assert(pass < m_passCount && resource < m_resources.size());
+    std::vector<Use>& uses = m_resources[resource].uses;
+    // Passes have to be declared in the order of execution.
+    assert(uses.empty() || uses.back().pass <= pass);
+    if (!uses.empty() && uses.back().pass == pass) {
+        // The pass uses the resource in several ways at once.
+        uses.back().state   |= state;
+        uses.back().isWrite |= isWrite;
+    } else {
+        uses.push_back(Use{pass, state, isWrite});
+    }
+}
+
+auto RenderGraph::computeSegments(const Resource& resource)
+-> std::vector<Segment> {
+    std::vector<Segment> segments;
+    bool isReadOnly = false;
+    for (const Use& use : resource.uses) {
+        if (!segments.empty()) {
+            Segment& last = segments.back();
+            // Consecutive reads are combined into a single state,
+            // and consecutive writes in the same state require no transitions.
+            const bool isSameRead  = isReadOnly && !use.isWrite;
+            const bool isSameWrite = !isReadOnly && use.isWrite && last.state == use.state;
+            if (isSameRead || isSameWrite) {
+                last.lastPass  = use.pass;
+                last.state    |= use.state;
+                continue;
+            }
+        }
+        segments.push_back(Segment{use.pass, use.pass, use.state});
+        isReadOnly = !use.isWrite;
+    }
+    return segments;
+}
+
+void RenderGraph::addTransition(const ResourceId resource, const uint32_t before,
+                                const uint32_t after, const size_t beginBatch,
+                                const size_t endBatch) {
+    assert(beginBatch <= endBatch && endBatch <= m_passCount);
+    if (before == after) return;
+    if (beginBatch == endBatch) {
+        m_batches[endBatch].push_back(Barrier{Barrier::Type::TRANSITION, Barrier::Split::NONE,
+                                              resource, before, after});
+    } else {
+        // Let the GPU perform the transition while the passes in between are executed.
+        m_batches[beginBatch].push_back(Barrier{Barrier::Type::TRANSITION, Barrier::Split::BEGIN,
+                                                resource, before, after});
+        m_batches[endBatch].push_back(Barrier{Barrier::Type::TRANSITION, Barrier::Split::END,
+                                              resource, before, after});
+    }
+}
+
+void RenderGraph::compile() {
+    m_batches.assign(m_passCount + 1, std::vector<Barrier>{});
+    m_initialBarriers.clear();
+    for (size_t i = 0, n = m_resources.size(); i < n; ++i) {
+        const ResourceId id       = static_cast<ResourceId>(i);
+        const Resource&  resource = m_resources[i];
+        const auto       segments = computeSegments(resource);
+        if (segments.empty()) continue;
+        const Segment&   first    = segments.front();
+        const Segment&   last     = segments.back();
+        // Transition into the state of the first use.
+        if (Kind::IMPORTED == resource.kind) {
+            addTransition(id, resource.state, first.state, 0, first.firstPass);
+        } else if (Kind::LOOPED == resource.kind && last.state != first.state) {
+            // The transition has begun during the previous execution.
+            m_batches[first.firstPass].push_back(Barrier{Barrier::Type::TRANSITION,
+                                                         Barrier::Split::END,
+                                                         id, last.state, first.state});
+        }
+        // Transient resources are created in the state of their first use.
+        // Transitions between the uses.
+        for (size_t s = 1, cnt = segments.size(); s < cnt; ++s) {
+            addTransition(id, segments[s - 1].state, segments[s].state,
+                          segments[s - 1].lastPass + 1, segments[s].firstPass);
+        }
+        // Transition after the last use.
+        if (Kind::IMPORTED == resource.kind) {
+            addTransition(id, last.state, resource.state, last.lastPass + 1, m_passCount);
+        } else if (Kind::LOOPED == resource.kind && last.state != first.state) {
+            // Begin the transition for the next execution.
+            const Barrier barrier = {Barrier::Type::TRANSITION, Barrier::Split::BEGIN,
+                                     id, last.state, first.state};
+            m_batches[m_passCount].push_back(barrier);
+            m_initialBarriers.push_back(barrier);
+        } else if (Kind::TRANSIENT == resource.kind) {
+            // Restore the state of the first use while the resource still owns the memory.
+            addTransition(id, last.state, first.state, last.lastPass + 1, last.lastPass + 1);
+        }
+    }
+    assignTransientMemory();
+}
+
+void RenderGraph::assignTransientMemory() {
+    struct Interval {
+        ResourceId resource;
+        PassId     firstPass, lastPass;
+        size_t     offset, size;
+    };
+    std::vector<Interval> intervals;
+    for (size_t i = 0, n = m_resources.size(); i < n; ++i) {
+        const Resource& resource = m_resources[i];
+        if (Kind::TRANSIENT != resource.kind || resource.uses.empty()) continue;
+        intervals.push_back(Interval{static_cast<ResourceId>(i), resource.uses.front().pass,
+                                     resource.uses.back().pass, 0, resource.size});
+    }
+    // Place larger resources first; they are the hardest to fit.
+    std::stable_sort(intervals.begin(), intervals.end(),
+                     [](const Interval& a, const Interval& b) { return a.size > b.size; });
+    const auto isLive = [](const Interval& a, const Interval& b) {
+        return a.firstPass <= b.lastPass && b.firstPass <= a.lastPass;
+    };
+    const auto isOverlapping = [](const Interval& a, const size_t offset, const size_t size) {
+        return a.offset < offset + size && offset < a.offset + a.size;
+    };
+    m_transientHeapSize = 0;
+    for (size_t i = 0, n = intervals.size(); i < n; ++i) {
+        Interval&    interval  = intervals[i];
+        const size_t alignment = m_resources[interval.resource].alignment;
+        // Candidate offsets: the beginning of the heap, and the ends of the placed resources
+        // which are live at the same time. Pick the lowest one which does not overlap them.
+        size_t bestOffset = SIZE_MAX;
+        for (size_t c = 0; c <= i; ++c) {
+            if (c < i && !isLive(intervals[c], interval)) continue;
+            const size_t end    = (c < i) ? intervals[c].offset + intervals[c].size : 0;
+            const size_t offset = (end + alignment - 1) & ~(alignment - 1);
+            if (offset >= bestOffset) continue;
+            bool isFree = true;
+            for (size_t p = 0; p < i && isFree; ++p) {
+                isFree = !isLive(intervals[p], interval) ||
+                         !isOverlapping(intervals[p], offset, interval.size);
+            }
+            if (isFree) bestOffset = offset;
+        }
+        interval.offset     = bestOffset;
+        m_transientHeapSize = std::max(m_transientHeapSize, bestOffset + interval.size);
+        m_resources[interval.resource].offset = bestOffset;
+    }
+    // The first use of a resource sharing memory with other resources requires an aliasing
+    // barrier. Since the graph may be executed repeatedly, the previous owner is unknown.
+    for (const Interval& interval : intervals) {
+        const bool isAliased = std::any_of(intervals.begin(), intervals.end(),
+                                           [&interval](const Interval& other) {
+            return other.resource != interval.resource &&
+                   other.offset < interval.offset + interval.size &&
+                   interval.offset < other.offset + other.size;
+        });
+        if (isAliased) {
+            m_batches[interval.firstPass].push_back(Barrier{Barrier::Type::ALIASING,
+                                                            Barrier::Split::NONE,
+                                                            interval.resource, 0, 0});
+        }
+    }
+}
+
+auto RenderGraph::barriers(const PassId pass) const
+-> const std::vector<Barrier>& {
+    assert(pass < m_passCount && m_batches.size() == m_passCount + 1);
+    return m_batches[pass];
+}
+
+auto RenderGraph::finalBarriers() const
+-> const std::vector<Barrier>& {
+    assert(m_batches.size() == m_passCount + 1);
+    return m_batches[m_passCount];
+}
+
+auto RenderGraph::initialBarriers() const
+-> const std::vector<Barrier>& {
+    return m_initialBarriers;
+}
+
+auto RenderGraph::transientOffset(const ResourceId resource) const
+-> size_t {
+    assert(resource < m_resources.size() && Kind::TRANSIENT == m_resources[resource].kind);
+    return m_resources[resource].offset;
+}
+
+auto RenderGraph::transientHeapSize() const
+-> size_t {
+    return m_transientHeapSize;
+}
+
+auto RenderGraph::passCount() const
+-> size_t {
+    return m_passCount;
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <vector>
+#include "Definitions.h"
+
+// Render graph compiler. Passes are executed in the order they are added, and declare
+// the resources they read and write, together with the required resource states.
+// The compiler computes the minimal set of state transitions, batches them per pass,
+// and splits the transitions spanning several passes (the transition begins right after
+// the last use of the previous state, and ends right before the first use of the next one).
+// It also assigns the memory of transient resources, so that the resources with disjoint
+// lifetimes share (alias) the memory. The compiler does not depend on the graphics API:
+// resource states are opaque bit masks (e.g. D3D12_RESOURCE_STATES), with the read-only
+// states of consecutive reads combined using bitwise OR.
+class RenderGraph {
+public:
+    using PassId     = uint32_t;
+    using ResourceId = uint32_t;
+    static constexpr ResourceId INVALID_RESOURCE = UINT32_MAX;
+    struct Barrier {
+        enum class Type  { TRANSITION, ALIASING };
+        enum class Split { NONE, BEGIN, END };
+        Type       type;
+        Split      split;
+        ResourceId resource;
+        uint32_t   before, after;           // States of the transition
+    };
+    RULE_OF_ZERO_MOVE_ONLY(RenderGraph);
+    RenderGraph() = default;
+    // Imports a persistent resource. It is in 'state' before the graph is executed,
+    // and it is transitioned back to 'state' afterwards.
+    ResourceId importResource(const uint32_t state);
+    // Imports a persistent resource used exclusively by the graph, which is executed
+    // repeatedly (e.g. once per frame). The transition from the state of its last use
+    // to the state of its first use is split across consecutive executions.
+    // The resource must be created in the state of its last use,
+    // and initialBarriers() have to be recorded before the first execution.
+    ResourceId importLoopedResource();
+    // Declares a transient resource of 'size' bytes with the specified alignment.
+    // Its memory may be shared with the transient resources not used at the same time,
+    // and its contents are undefined before the first use (which must initialize it,
+    // e.g. clear or discard it). It must be created in the state of its first use.
+    ResourceId createTransient(const size_t size, const size_t alignment);
+    // Adds a pass executed after the previously added passes.
+    PassId addPass();
+    // Declares that the pass reads the resource in the specified (read-only) state.
+    void read(const PassId pass, const ResourceId resource, const uint32_t state);
+    // Declares that the pass writes the resource in the specified state.
+    void write(const PassId pass, const ResourceId resource, const uint32_t state);
+    // Computes the barriers and the memory layout of transient resources.
+    // Must be called once all passes are declared.
+    void compile();
+    // Returns the barriers recorded before the pass is executed.
+    const std::vector<Barrier>& barriers(const PassId pass) const;
+    // Returns the barriers recorded after the last pass is executed.
+    const std::vector<Barrier>& finalBarriers() const;
+    // Returns the barriers recorded once, before the first execution of the graph.
+    const std::vector<Barrier>& initialBarriers() const;
+    // Returns the offset of the transient resource within the transient memory heap.
+    size_t transientOffset(const ResourceId resource) const;
+    // Returns the size of the transient memory heap.
+    size_t transientHeapSize() const;
+    // Returns the number of passes.
+    size_t passCount() const;
+private:
+    enum class Kind { IMPORTED, LOOPED, TRANSIENT };
+    struct Use {
+        PassId     pass;
+        uint32_t   state;
+        bool       isWrite;
+    };
+    struct Resource {
+        Kind             kind;
+        uint32_t         state;             // State of an imported resource
+        size_t           size, alignment;   // Memory requirements of a transient resource
+        size_t           offset;            // Offset of a transient resource
+        std::vector<Use> uses;              // Ordered by the pass
+    };
+    // Range of consecutive passes using the resource in the same state.
+    struct Segment {
+        PassId     firstPass, lastPass;
+        uint32_t   state;
+    };
+    // Declares the use of the resource by the pass.
+    void addUse(const PassId pass, const ResourceId resource, const uint32_t state,
+                const bool isWrite);
+    // Merges the uses of the resource into segments.
+    static std::vector<Segment> computeSegments(const Resource& resource);
+    // Adds a transition which can begin within the batch 'beginBatch' and has to end
+    // within the batch 'endBatch'. Batch 'i' precedes pass 'i', the last batch is final.
+    void addTransition(const ResourceId resource, const uint32_t before, const uint32_t after,
+                       const size_t beginBatch, const size_t endBatch);
+    // Assigns the offsets of transient resources. Adds the aliasing barriers.
+    void assignTransientMemory();
+private:
+    std::vector<Resource>             m_resources;
+    std::vector<std::vector<Barrier>> m_batches;        // Per pass, and the final batch
+    std::vector<Barrier>              m_initialBarriers;
+    size_t                            m_passCount = 0;
+    size_t                            m_transientHeapSize = 0;
+};
@@ -1,15 +1,22 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 #include "Definitions.h"
 
-// A linear allocator which uses N static, non-growing memory regions of the same size.
+// A linear allocator which uses N memory regions ("buffers").
 // It works as a ring buffer: switching from the buffer (N - 1) causes the buffer 0 to be used.
+// Each buffer consists of one or more chunks. If an allocation does not fit into the current
+// chunk, the next chunk is used, and allocated if necessary. The chunks are retained,
+// so once the buffers have grown sufficiently large, no further heap allocations occur.
 template <size_t N>
 class BufferedLinearAllocator {
 public:
     RULE_OF_ZERO_MOVE_ONLY(BufferedLinearAllocator);
-    // Ctor which allocates 'size' bytes per buffer.
+    // Ctor; performs zero-initialization. The allocator cannot be used.
+    BufferedLinearAllocator();
+    // Ctor which allocates a chunk of 'size' bytes per buffer.
+    // Chunks allocated later are at least as large.
     BufferedLinearAllocator(const size_t size);
     // Allocates 'size' bytes according to the specified alignment restriction.
     template <size_t alignment>
@@ -17,16 +24,33 @@ public:
     // Sets the internal pointer to the beginning of the next buffer.
     // Makes subsequent allocations occur within the next buffer.
     void switchToNextBuffer();
-    // Resets the allocator to its initial state.
+    // Resets the allocator to its initial state. The chunks are retained.
     void reset();
+    // Returns the amount of memory (in bytes) used within the current buffer,
+    // including the padding and the unused space at the end of the chunks.
+    size_t usedSize() const;
+    // Returns the maximal amount of memory (in bytes) used within a single buffer.
+    size_t highWaterMark() const;
+    // Returns the total size (in bytes) of all chunks.
+    size_t capacity() const;
 private:
-    // Returns the pointer to the end of the current buffer.
-    // It coincides with the beginning of the next buffer if wrap around does not occur.
-    const byte_t* computeBufferEnd() const;
+    struct Chunk {
+        std::unique_ptr<byte_t[]> memory;
+        size_t                    size;
+    };
+    // Switches to the beginning of the specified buffer.
+    void switchToBuffer(const size_t buffer);
+    // Switches to the next chunk of the current buffer, which is at least 'minSize' bytes large.
+    void switchToNextChunk(const size_t minSize);
 private:
-    size_t                    m_size;       // Size of each buffer
-    byte_t*                   m_current;    // Current (free) position within the heap region
-    std::unique_ptr<byte_t[]> m_heapRegion; // Heap region backing N buffers
+    size_t             m_chunkSize;     // Minimal size of a chunk
+    size_t             m_buffer;        // Index of the current buffer
+    size_t             m_chunk;         // Index of the current chunk within the buffer
+    byte_t*            m_current;       // Current (free) position within the chunk
+    byte_t*            m_chunkEnd;      // End of the current chunk
+    size_t             m_prevChunkSize; // Total size of the previous chunks of the buffer
+    size_t             m_highWaterMark; // As of the last buffer switch
+    std::vector<Chunk> m_chunks[N];     // Chunks of each buffer
 };
 
 using LinearAllocator = BufferedLinearAllocator<1>;
@@ -1,15 +1,30 @@
 #pragma once
 
+#include <algorithm>
 #include "Math.h"
 #include "Resources.h"
 
+template <size_t N>
+inline BufferedLinearAllocator<N>::BufferedLinearAllocator()
+    : m_chunkSize{0}
+    , m_buffer{0}
+    , m_chunk{0}
+    , m_current{nullptr}
+    , m_chunkEnd{nullptr}
+    , m_prevChunkSize{0}
+    , m_highWaterMark{0} {}
+
 template <size_t N>
 inline BufferedLinearAllocator<N>::BufferedLinearAllocator(const size_t size)
-    : m_size{size}
-    , m_heapRegion{std::make_unique<byte_t[]>(size * N)} {
+    : m_chunkSize{size}
+    , m_current{nullptr}
+    , m_highWaterMark{0} {
     static_assert(N >= 1, "BufferedLinearAllocator must have at least 1 buffer.");
     assert(size >= 64 && "The size of the buffer cannot be smaller than 64 bytes.");
-    m_current = m_heapRegion.get();
+    for (size_t b = 0; b < N; ++b) {
+        m_chunks[b].push_back(Chunk{std::make_unique<byte_t[]>(size), size});
+    }
+    switchToBuffer(0);
 }
 
 template<size_t N>
@@ -17,40 +32,78 @@ template<size_t alignment>
 inline auto BufferedLinearAllocator<N>::allocate(const size_t size)
 -> void* {
     byte_t* alignedPtr = align<alignment>(m_current);
-    byte_t* alignedEnd = alignedPtr + size;
-    // computeBufferEnd() assumes that 'm_current' does not coincide with the end of the buffer.
-    assert(alignedEnd < computeBufferEnd() &&
-           "This allocation would cause buffer overflow.");
-    m_current = alignedEnd;
+    if (alignedPtr + size > m_chunkEnd) {
+        // The allocation does not fit into the current chunk.
+        switchToNextChunk(size + alignment - 1);
+        alignedPtr = align<alignment>(m_current);
+    }
+    m_current = alignedPtr + size;
     return alignedPtr;
 }
 
-template<size_t N>
-inline auto BufferedLinearAllocator<N>::computeBufferEnd() const
--> const byte_t* {
-    // Compute the offset from the beginning of the heap region corresponding to 'm_current'.
-    const size_t offset = m_current - m_heapRegion.get();
-    // Compute the offset with respect to the beginning of the current buffer.
-    const size_t bufferOffset = offset % m_size;
-    // Compute the pointer to the beginning of the current buffer.
-    const byte_t* bufferBegin = m_current - bufferOffset;
-    // Offset the pointer by the size of the buffer.
-    return bufferBegin + m_size;
-}
-
 template <size_t N>
 inline void BufferedLinearAllocator<N>::switchToNextBuffer() {
-    byte_t*       heapBegin = m_heapRegion.get();
-    const byte_t* bufferEnd = computeBufferEnd();
-    // Transform it into an offset.
-    size_t offset = bufferEnd - heapBegin;
-    // Wrap around if necessary.
-    offset = offset % (m_size * N);
-    // Store the result.
-    m_current = heapBegin + offset;
+    switchToBuffer((m_buffer + 1) % N);
 }
 
 template <size_t N>
 inline void BufferedLinearAllocator<N>::reset() {
-    m_current = m_heapRegion.get();
+    switchToBuffer(0);
+}
+
+template <size_t N>
+inline auto BufferedLinearAllocator<N>::usedSize() const
+-> size_t {
+    const byte_t* chunkBegin = m_chunks[m_buffer][m_chunk].memory.get();
+    return m_prevChunkSize + static_cast<size_t>(m_current - chunkBegin);
+}
+
+template <size_t N>
+inline auto BufferedLinearAllocator<N>::highWaterMark() const
+-> size_t {
+    return std::max(m_highWaterMark, usedSize());
+}
+
+template <size_t N>
+inline auto BufferedLinearAllocator<N>::capacity() const
+-> size_t {
+    size_t totalSize = 0;
+    for (size_t b = 0; b < N; ++b) {
+        for (const Chunk& chunk : m_chunks[b]) {
+            totalSize += chunk.size;
+        }
+    }
+    return totalSize;
+}
+
+template <size_t N>
+inline void BufferedLinearAllocator<N>::switchToBuffer(const size_t buffer) {
+    // Update the statistics of the buffer which is no longer in use.
+    if (m_current) {
+        m_highWaterMark = highWaterMark();
+    }
+    const Chunk& chunk = m_chunks[buffer].front();
+    m_buffer        = buffer;
+    m_chunk         = 0;
+    m_current       = chunk.memory.get();
+    m_chunkEnd      = m_current + chunk.size;
+    m_prevChunkSize = 0;
+}
+
+template <size_t N>
+inline void BufferedLinearAllocator<N>::switchToNextChunk(const size_t minSize) {
+    std::vector<Chunk>& chunks = m_chunks[m_buffer];
+    // The unused space at the end of the current chunk is wasted.
+    m_prevChunkSize += chunks[m_chunk].size;
+    if (++m_chunk == chunks.size()) {
+        chunks.push_back(Chunk{nullptr, 0});
+    }
+    Chunk& chunk = chunks[m_chunk];
+    // Replace the chunk if it is too small.
+    if (chunk.size < minSize) {
+        chunk.size   = std::max(m_chunkSize, minSize);
+        chunk.memory = std::make_unique<byte_t[]>(chunk.size);
+    }
+    m_current  = chunk.memory.get();
+    m_chunkEnd = m_current + chunk.size;
 }
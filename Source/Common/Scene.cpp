@@ -1,21 +1,16 @@
+#include <algorithm>
 #include <DirectXTex\DirectXTex.h>
 #include <load_obj.h>
+#include "JobSystem.h"
+#include "MaterialRegistry.hpp"
 #include "Math.h"
 #include "Scene.h"
+#include "SceneGeometry.h"
 #include "Utility.h"
 #include "..\D3D12\Renderer.hpp"
 
 using namespace DirectX;
 
-struct IndexedObject {
-    bool operator<(const IndexedObject& other) const {
-        return material < other.material;
-    }
-public:
-    size_t                material;
-    std::vector<uint32_t> indices;
-};
-
 // Returns 'true' if the string (path or filename) has a '.tga' extension.
 static inline auto hasTgaExt(const std::string& str)
 -> bool {
@@ -37,96 +32,106 @@ static inline void convertToUtf8(const std::string& str, const size_t wideStrLen
     }
 }
 
-// Map where Key = texture name, Value = pair {texture : texture index}.
-using TextureMap = std::unordered_map<std::string, std::pair<D3D12::Texture, uint32_t>>;
+// Flips the image vertically in place.
+static inline void flipVertically(const Image& image) {
+    uint8_t* top    = image.pixels;
+    uint8_t* bottom = image.pixels + (image.height - 1) * image.rowPitch;
+    for (; top < bottom; top += image.rowPitch, bottom -= image.rowPitch) {
+        std::swap_ranges(top, top + image.rowPitch, bottom);
+    }
+}
+
+// Loads the .tga texture from the file, flips it vertically, and generates MIP maps
+// straight into the upload buffer of the renderer (unless the MIP chain is too large).
+// Returns the created texture.
+static inline D3D12::Texture loadTexture(const std::string& fileWithPath,
+                                         D3D12::Renderer& engine) {
+    wchar_t tgaFilePath[128];
+    convertToUtf8(fileWithPath, 128, tgaFilePath);
+    // Load the .tga texture.
+    ScratchImage img;
+    CHECK_CALL(LoadFromTGAFile(tgaFilePath, nullptr, img),
+               "Failed to load the .tga file.");
+    // Perform quick verification.
+    assert(1 == img.GetImageCount());
+    assert(TEX_DIMENSION_TEXTURE2D == img.GetMetadata().dimension);
+    const Image& image = *img.GetImages();
+    // Flip the image.
+    flipVertically(image);
+    // Compute the length of the full MIP chain.
+    uint32_t mipCount = 1;
+    for (size_t dim = std::max(image.width, image.height); dim > 1; dim >>= 1) {
+        ++mipCount;
+    }
+    // Describe the 2D texture.
+    const D3D12_SUBRESOURCE_FOOTPRINT footprint = {
+        /* Format */   image.format,
+        /* Width */    static_cast<uint32_t>(image.width),
+        /* Height */   static_cast<uint32_t>(image.height),
+        /* Depth */    1,
+        /* RowPitch */ 0    // Determined by the renderer
+    };
+    // Generate MIP maps within the upload buffer, using the layout required for copying.
+    const D3D12::TextureUpload upload = engine.reserveTextureUpload(footprint, mipCount);
+    ScratchImage mipChain;
+    if (!upload.chunk.address) {
+        // The MIP chain is too large to be reserved at once. Generate it in system memory,
+        // and upload it level by level.
+        CHECK_CALL(GenerateMipMaps(image, TEX_FILTER_DEFAULT, mipCount, mipChain),
+                   "Failed to generate MIP maps.");
+        D3D12_SUBRESOURCE_FOOTPRINT dataFootprint = footprint;
+        dataFootprint.RowPitch = static_cast<uint32_t>(mipChain.GetImages()->rowPitch);
+        return engine.createTexture2D(dataFootprint, mipCount, mipChain.GetPixels());
+    }
+    CHECK_CALL(mipChain.Initialize2DExternal(image.format, image.width, image.height, 1,
+                                             mipCount, upload.chunk.address, upload.size,
+                                             D3D12_TEXTURE_DATA_PITCH_ALIGNMENT,
+                                             D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT),
+               "Failed to place the MIP chain within the upload buffer.");
+    CHECK_CALL(GenerateMipMapsInto(image, TEX_FILTER_DEFAULT, mipChain),
+               "Failed to generate MIP maps.");
+    // Create a texture.
+    return engine.createTexture2D(upload);
+}
+
+// Map where Key = texture name, Value = texture slot (index into the array of names).
+using TextureMap = std::unordered_map<std::string, uint32_t>;
 
 Scene::Scene(const char* path, const char* objFileName, D3D12::Renderer& engine) {
     assert(path && objFileName);
     const std::string pathStr = path;
-    // Load the .obj file.
-    printInfo("Loading a scene from the file: %s", objFileName);
-    obj::File objFile;
-    if (!load_obj(pathStr + std::string{objFileName}, objFile)) {
-        printError("Failed to load the file: %s", objFileName);
-        TERMINATE();
-    }
-    // Populate the indexed object array and the vertex index map.
-    std::vector<IndexedObject> indexedObjects;
-    obj::IndexMap indexMap{2 * objFile.vertices.size()};
-    for (const auto& object : objFile.objects) {
-        for (const auto& group : object.groups) {
-            if (group.faces.empty()) continue;
-            // New group -> new object.
-            indexedObjects.emplace_back(IndexedObject{group.faces[0].material, {}});
-            IndexedObject* currObject = &indexedObjects.back();
-            for (const auto& face : group.faces) {
-                if (face.material != currObject->material) {
-                    // New material -> new object.
-                    indexedObjects.emplace_back(IndexedObject{face.material, {}});
-                    currObject = &indexedObjects.back();
-                }
-                for (size_t i = 0; i < face.index_count; ++i) {
-                    if (indexMap.find(face.indices[i]) == indexMap.end()) {
-                        // Insert a new Key-Value pair (vertex index : position in vertex buffer).
-                        indexMap.emplace(face.indices[i], static_cast<uint32_t>(indexMap.size()));
-                    }
-                }
-                // Create indexed triangle(s).
-                const uint32_t v0 = indexMap[face.indices[0]];
-                uint32_t       v1 = indexMap[face.indices[1]];
-                for (size_t i = 1, n = face.index_count - 1; i < n; ++i) {
-                    const uint32_t v2 = indexMap[face.indices[i + 1]];
-                    const uint32_t indices[3] = {v0, v1, v2};
-                    currObject->indices.insert(currObject->indices.end(), indices, indices + 3);
-                    v1 = v2;
-                }
-            }
-        }
-    }
-    /* TODO: implement mesh decimation. */
-    // Sort objects by material.
-    std::sort(indexedObjects.begin(), indexedObjects.end());
+    // Load the scene geometry.
+    const SceneGeometry geometry{path, objFileName};
     // Allocate memory.
-    objects.count           = indexedObjects.size();
-    objects.boundingBoxes   = std::make_unique<AABox[]>(objects.count);
+    objects.count           = geometry.objects.size();
     objects.materialIndices = std::make_unique<uint16_t[]>(objects.count);
-    objects.indexBuffers.allocate(objects.count);
+    objects.drawPackets     = std::make_unique<DrawPacket[]>(objects.count);
     vertexAttrBuffers.allocate(3);
-    matCount  = objFile.materials.size();
-    materials = std::make_unique<Material[]>(matCount);
+    const size_t matCount     = geometry.materials.size();
+    auto         objMaterials = std::make_unique<Material[]>(matCount);
+    // Compute bounding boxes in the background.
+    const JobHandle bBoxJob = JobSystem::schedule([this, &geometry]() {
+        objects.boundingBoxes = geometry.computeBoundingBoxes();
+    });
     // Create vertex attribute buffers.
-    const size_t numVertices = indexMap.size();
-    std::vector<XMFLOAT3> positions{numVertices};
-    std::vector<XMFLOAT3> normals{numVertices};
-    std::vector<XMFLOAT2> uvCoords{numVertices};
-    for (const auto& entry : indexMap) {
-        const size_t vertId = entry.second;
-        positions[vertId] = objFile.vertices[entry.first.v];
-        normals[vertId]   = objFile.normals[entry.first.n];
-        uvCoords[vertId]  = objFile.texcoords[entry.first.t];
-    }
-    vertexAttrBuffers.assign(0, engine.createVertexBuffer(numVertices, positions.data()));
-    vertexAttrBuffers.assign(1, engine.createVertexBuffer(numVertices, normals.data()));
-    vertexAttrBuffers.assign(2, engine.createVertexBuffer(numVertices, uvCoords.data()));
-    // Create index buffers.
-    for (size_t i = 0; i < objects.count; ++i) {
-        const auto& indices = indexedObjects[i].indices;
-        objects.indexBuffers.assign(i, engine.createIndexBuffer(indices.size(), indices.data()));
-    }
-    for (size_t i = 0; i < objects.count; ++i) {
-        // Store material indices.
-        objects.materialIndices[i] = static_cast<uint16_t>(indexedObjects[i].material);
-    }
-    // Copy scene geometry to the GPU.
-    engine.executeCopyCommands();
-    // Compute bounding boxes.
+    const size_t numVertices = geometry.positions.size();
+    vertexAttrBuffers.assign(0, engine.createVertexBuffer(numVertices, geometry.positions.data()));
+    vertexAttrBuffers.assign(1, engine.createVertexBuffer(numVertices, geometry.normals.data()));
+    vertexAttrBuffers.assign(2, engine.createVertexBuffer(numVertices, geometry.uvCoords.data()));
+    // Concatenate the indices of all objects, and create a single index buffer.
+    // Since the objects are sorted by material, the objects with the same material
+    // occupy a contiguous index range, which allows to coalesce their draws.
+    auto firstIndices = std::make_unique<uint32_t[]>(objects.count);
+    std::vector<uint32_t> indices;
     for (size_t i = 0; i < objects.count; ++i) {
-        const IndexedObject& io  = indexedObjects[i];
-        objects.boundingBoxes[i] = AABox{io.indices.size(), io.indices.data(), positions.data()};
+        const auto& objIndices = geometry.objects[i].indices;
+        firstIndices[i] = static_cast<uint32_t>(indices.size());
+        indices.insert(indices.end(), objIndices.begin(), objIndices.end());
     }
+    indexBuffer = engine.createIndexBuffer(indices.size(), indices.data());
     // Load the .mtl files referenced in the .obj file.
     obj::MaterialLib matLib;
-    for (const auto& matLibFileName: objFile.mtl_libs) {
+    for (const auto& matLibFileName: geometry.matLibs) {
         printInfo("Loading a material library from the file: %s", matLibFileName.c_str());
         if (!load_mtl(pathStr + matLibFileName, matLib)) {
             printError("Failed to load the file: %s", matLibFileName);
@@ -134,95 +139,114 @@ Scene::Scene(const char* path, const char* objFileName, D3D12::Renderer& engine)
         }
     }
     // Store textures in a map to avoid duplicates.
-    TextureMap texLib;
-    // Acquires the texture index by either looking it up in the texture library,
-    // or loading it from disk (and subsequently adding it to the library).
-    auto acquireTexureIndex = [&texLib, &pathStr, &engine](const std::string& texName) {
+    TextureMap               texLib;
+    std::vector<std::string> texNames;
+    // Acquires the texture slot by either looking it up in the texture library,
+    // or adding the texture to the library (to be loaded later).
+    auto acquireTextureSlot = [&texLib, &texNames](const std::string& texName) {
         if (texName.empty()) return UINT32_MAX;
         // Currently, only .tga textures are supported.
         assert(hasTgaExt(texName));
-        // Check whether we have to load the texture.
         const auto texIt = texLib.find(texName);
         if (texIt != texLib.end()) {
-            return texIt->second.second;
+            return texIt->second;
         } else {
-            // Combine the path and the filename.
-            wchar_t tgaFilePath[128];
-            convertToUtf8(pathStr + texName, 128, tgaFilePath);
-            // Load the .tga texture.
-            ScratchImage tmp;
-            CHECK_CALL(LoadFromTGAFile(tgaFilePath, nullptr, tmp),
-                       "Failed to load the .tga file.");
-            // Perform quick verification.
-            assert(1 == tmp.GetImageCount());
-            assert(TEX_DIMENSION_TEXTURE2D == tmp.GetMetadata().dimension);
-            // Flip the image.
-            ScratchImage img;
-            CHECK_CALL(FlipRotate(*tmp.GetImages(), TEX_FR_FLIP_VERTICAL, img),
-                       "Failed to perform a vertical image flip.");
-            // Generate MIP maps.
-            ScratchImage mipChain;
-            CHECK_CALL(GenerateMipMaps(*img.GetImages(), TEX_FILTER_DEFAULT, 0, mipChain),
-                       "Failed to generate MIP maps.");
-            const TexMetadata& info = mipChain.GetMetadata();
-            // Describe the 2D texture.
-            const D3D12_SUBRESOURCE_FOOTPRINT footprint = {
-                /* Format */   info.format,
-                /* Width */    static_cast<uint32_t>(info.width),
-                /* Height */   static_cast<uint32_t>(info.height),
-                /* Depth */    static_cast<uint32_t>(info.depth),
-                /* RowPitch */ static_cast<uint32_t>(mipChain.GetImages()->rowPitch)
-            };
-            const uint32_t mipCount = static_cast<uint32_t>(info.mipLevels);
-            // Create a texture.
-            D3D12::Texture texture  = engine.createTexture2D(footprint, mipCount,
-                                                             mipChain.GetPixels());
-            const uint32_t index    = static_cast<uint32_t>(engine.getTextureIndex(texture));
-            // Add the texture to the library.
-            texLib.emplace(texName, std::make_pair(std::move(texture), index));
-            return index;
+            const uint32_t slot = static_cast<uint32_t>(texNames.size());
+            texLib.emplace(texName, slot);
+            texNames.push_back(texName);
+            return slot;
         }
     };
-    // Load individual materials.
+    // Load individual materials. The texture slots are replaced by indices later.
     for (size_t i = 0; i < matCount; ++i) {
         // Locate the material within the library.
-        const auto& matName = objFile.materials[i];
+        const auto& matName = geometry.materials[i];
         const auto  matIt   = matLib.find(matName);
         if (matIt == matLib.end()) {
             printWarning("Material '%s' (index %zu) not found.", matName.c_str(), i);
             // Set all texture indices to 0xFFFFFFFF.
-            memset(&materials[i], 0xFF, sizeof(Material));
+            memset(&objMaterials[i], 0xFF, sizeof(Material));
         } else {
             const obj::Material& material = matIt->second;
             // Currently, only glossy and specular materials are supported.
             assert(2 == material.illum);
             // Metallicness map. TODO: get rid of constant color textures.
-            materials[i].metalTexId = acquireTexureIndex(material.map_ka);
+            objMaterials[i].metalTexId = acquireTextureSlot(material.map_ka);
             // Base color texture.
-            materials[i].baseTexId  = acquireTexureIndex(material.map_kd);
+            objMaterials[i].baseTexId  = acquireTextureSlot(material.map_kd);
             // Bump map (optional).
-            materials[i].bumpTexId  = acquireTexureIndex(material.map_bump);
+            objMaterials[i].bumpTexId  = acquireTextureSlot(material.map_bump);
             // Alpha mask (optional - opaque geometry doesn't need one).
-            materials[i].maskTexId  = acquireTexureIndex(material.map_d);
+            objMaterials[i].maskTexId  = acquireTextureSlot(material.map_d);
             // Roughness map.
-            materials[i].roughTexId = acquireTexureIndex(material.map_ns);
-            assert(materials[i].metalTexId != UINT32_MAX);
-            assert(materials[i].baseTexId  != UINT32_MAX);
-            assert(materials[i].roughTexId != UINT32_MAX);
-            // Copy textures to the GPU.
-            engine.executeCopyCommands();
+            objMaterials[i].roughTexId = acquireTextureSlot(material.map_ns);
+            assert(objMaterials[i].metalTexId != UINT32_MAX);
+            assert(objMaterials[i].baseTexId  != UINT32_MAX);
+            assert(objMaterials[i].roughTexId != UINT32_MAX);
         }
     }
-    // Copy materials to the GPU.
-    engine.setMaterials(matCount, materials.get());
-    engine.executeCopyCommands();
-    // Move textures into the array.
-    texCount = texLib.size();
-    textures.allocate(texCount);
-    size_t i = 0;
-    for (auto& entry : texLib) {
-        auto& texture = entry.second;
-        textures.assign(i++, std::move(texture.first));
+    texCount = texNames.size();
+    textures = std::make_unique<D3D12::Texture[]>(texCount);
+    auto texIndices = std::make_unique<uint32_t[]>(texCount);
+    // The lazy initialization of the WIC factory is not thread-safe, so perform it up front.
+    bool isWic2;
+    GetWICFactory(isWic2);
+    // Decode textures in parallel. Each texture is decoded straight into the upload buffer,
+    // which bounds the amount of memory used by the decoded MIP chains.
+    JobSystem::parallelFor(texCount, 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            D3D12::Texture texture = loadTexture(pathStr + texNames[i], engine);
+            texIndices[i]          = static_cast<uint32_t>(engine.getTextureIndex(texture));
+            textures[i]            = std::move(texture);
+        }
+    });
+    // Replace texture slots by texture indices.
+    auto slotToIndex = [&texIndices](uint32_t* texId) {
+        if (*texId != UINT32_MAX) *texId = texIndices[*texId];
+    };
+    for (size_t i = 0; i < matCount; ++i) {
+        slotToIndex(&objMaterials[i].metalTexId);
+        slotToIndex(&objMaterials[i].baseTexId);
+        slotToIndex(&objMaterials[i].bumpTexId);
+        slotToIndex(&objMaterials[i].maskTexId);
+        slotToIndex(&objMaterials[i].roughTexId);
+    }
+    // Register the materials. Identical materials are merged.
+    auto matIds = std::make_unique<uint16_t[]>(matCount);
+    for (size_t i = 0; i < matCount; ++i) {
+        matIds[i] = materials.acquire(objMaterials[i]);
+    }
+    printInfo("Registered %zu unique materials out of %zu.", materials.size(), matCount);
+    // Store material indices.
+    for (size_t i = 0; i < objects.count; ++i) {
+        objects.materialIndices[i] = matIds[geometry.objects[i].material];
+    }
+    // Construct draw packets.
+    for (size_t i = 0; i < objects.count; ++i) {
+        const uint16_t matId      = objects.materialIndices[i];
+        const uint32_t indexCount = static_cast<uint32_t>(geometry.objects[i].indices.size());
+        objects.drawPackets[i]    = makeDrawPacket(indexCount, firstIndices[i], matId,
+                                                   materials[matId].bumpTexId);
     }
+    // Copy materials to the GPU, and submit the remaining copies.
+    engine.updateMaterials(&materials);
+    engine.executeCopyCommands();
+    const D3D12::UploadStats& uploadStats = engine.getUploadStats();
+    printInfo("Uploaded %zu MiB in %zu copy batches with %zu stalls (%.1f ms).",
+              uploadStats.uploadedSize / 1048576, uploadStats.batchCount,
+              uploadStats.stallCount, uploadStats.stallTime);
+    const TlsfAllocator::Stats heapStats = engine.getHeapStats();
+    printInfo("Resource heaps: %zu MiB used out of %zu MiB, %.0f%% fragmentation.",
+              heapStats.usedSize / 1048576, heapStats.capacity / 1048576,
+              100.f * heapStats.fragmentation);
+    JobSystem::wait(bBoxJob);
     printInfo("Scene loaded successfully.");
 }
+
+void Scene::destroyTextures(D3D12::Renderer& engine) {
+    for (size_t i = 0; i < texCount; ++i) {
+        engine.destroyTexture(std::move(textures[i]));
+    }
+    textures.reset();
+    texCount = 0;
+}
@@ -0,0 +1,81 @@
+#include <load_obj.h>
+#include "JobSystem.h"
+#include "Primitives.h"
+#include "SceneGeometry.h"
+#include "Utility.h"
+
+using namespace DirectX;
+
+SceneGeometry::SceneGeometry(const char* path, const char* objFileName) {
+    assert(path && objFileName);
+    const std::string pathStr = path;
+    // Load the .obj file.
+    printInfo("Loading a scene from the file: %s", objFileName);
+    obj::File objFile;
+    if (!load_obj(pathStr + std::string{objFileName}, objFile)) {
+        printError("Failed to load the file: %s", objFileName);
+        TERMINATE();
+    }
+    // Populate the object array and the vertex index map.
+    obj::IndexMap indexMap{2 * objFile.vertices.size()};
+    for (const auto& object : objFile.objects) {
+        for (const auto& group : object.groups) {
+            if (group.faces.empty()) continue;
+            // New group -> new object.
+            objects.emplace_back(Object{group.faces[0].material, {}});
+            Object* currObject = &objects.back();
+            for (const auto& face : group.faces) {
+                if (face.material != currObject->material) {
+                    // New material -> new object.
+                    objects.emplace_back(Object{face.material, {}});
+                    currObject = &objects.back();
+                }
+                for (size_t i = 0; i < face.index_count; ++i) {
+                    if (indexMap.find(face.indices[i]) == indexMap.end()) {
+                        // Insert a new Key-Value pair (vertex index : position in vertex buffer).
+                        indexMap.emplace(face.indices[i], static_cast<uint32_t>(indexMap.size()));
+                    }
+                }
+                // Create indexed triangle(s).
+                const uint32_t v0 = indexMap[face.indices[0]];
+                uint32_t       v1 = indexMap[face.indices[1]];
+                for (size_t i = 1, n = face.index_count - 1; i < n; ++i) {
+                    const uint32_t v2 = indexMap[face.indices[i + 1]];
+                    const uint32_t indices[3] = {v0, v1, v2};
+                    currObject->indices.insert(currObject->indices.end(), indices, indices + 3);
+                    v1 = v2;
+                }
+            }
+        }
+    }
+    /* TODO: implement mesh decimation. */
+    // Sort objects by material.
+    std::sort(objects.begin(), objects.end());
+    // Create vertex attribute arrays.
+    const size_t numVertices = indexMap.size();
+    positions.resize(numVertices);
+    normals.resize(numVertices);
+    uvCoords.resize(numVertices);
+    for (const auto& entry : indexMap) {
+        const size_t vertId = entry.second;
+        positions[vertId] = objFile.vertices[entry.first.v];
+        normals[vertId]   = objFile.normals[entry.first.n];
+        uvCoords[vertId]  = objFile.texcoords[entry.first.t];
+    }
+    // Keep the material references.
+    materials = std::move(objFile.materials);
+    matLibs   = std::move(objFile.mtl_libs);
+}
+
+std::unique_ptr<AABox[]> SceneGeometry::computeBoundingBoxes() const {
+    const size_t count = objects.size();
+    auto boundingBoxes = std::make_unique<AABox[]>(count);
+    JobSystem::parallelFor(count, 64, [this, &boundingBoxes](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const Object& object = objects[i];
+            boundingBoxes[i] = AABox{object.indices.size(), object.indices.data(),
+                                     positions.data()};
+        }
+    });
+    return boundingBoxes;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <DirectXMathSSE4.h>
+#include "Definitions.h"
+
+class AABox;
+
+// Scene geometry imported from an .obj file.
+// Does not contain any Direct3D resources, and can be used without a renderer.
+struct SceneGeometry {
+    RULE_OF_ZERO_MOVE_ONLY(SceneGeometry);
+    // Ctor; takes the path and the .obj file name as input.
+    explicit SceneGeometry(const char* path, const char* objFileName);
+    // Computes the bounding box of each object. Uses the JobSystem.
+    std::unique_ptr<AABox[]> computeBoundingBoxes() const;
+public:
+    struct Object {
+        bool operator<(const Object& other) const {
+            return material < other.material;
+        }
+    public:
+        size_t                     material;    // Material index
+        std::vector<uint32_t>      indices;     // Triangle list
+    };
+    std::vector<Object>            objects;     // Sorted by material
+    std::vector<DirectX::XMFLOAT3> positions;   // Per vertex
+    std::vector<DirectX::XMFLOAT3> normals;     // Per vertex
+    std::vector<DirectX::XMFLOAT2> uvCoords;    // Per vertex
+    std::vector<std::string>       materials;   // Material names
+    std::vector<std::string>       matLibs;     // Material library file names
+};
@@ -0,0 +1,55 @@
+#include <cassert>
+#include "SlotAllocator.h"
+
+SlotAllocator::SlotAllocator()
+    : m_capacity{0}
+    , m_usedCount{0} {}
+
+SlotAllocator::SlotAllocator(const size_t capacity)
+    : m_capacity{capacity}
+    , m_usedCount{0}
+    , m_generations{std::make_unique<uint32_t[]>(capacity)} {
+    assert(capacity > 0 && capacity < UINT32_MAX);
+    m_freeList.reserve(capacity);
+}
+
+SlotHandle SlotAllocator::allocate() {
+    uint32_t index;
+    if (!m_freeList.empty()) {
+        // Reuse the most recently recycled slot.
+        index = m_freeList.back();
+        m_freeList.pop_back();
+    } else if (m_usedCount < m_capacity) {
+        index = static_cast<uint32_t>(m_usedCount++);
+    } else {
+        return SlotHandle{UINT32_MAX, 0};
+    }
+    return SlotHandle{index, m_generations[index]};
+}
+
+void SlotAllocator::free(const SlotHandle handle, const uint64_t fenceValue) {
+    assert(isValid(handle));
+    assert(m_pendingFrees.empty() || m_pendingFrees.back().fenceValue <= fenceValue);
+    // Invalidate the outstanding handles right away.
+    m_generations[handle.index]++;
+    m_pendingFrees.push_back(PendingFree{handle.index, fenceValue});
+}
+
+void SlotAllocator::reclaim(const uint64_t completedValue) {
+    while (!m_pendingFrees.empty() && m_pendingFrees.front().fenceValue <= completedValue) {
+        m_freeList.push_back(m_pendingFrees.front().index);
+        m_pendingFrees.pop_front();
+    }
+}
+
+bool SlotAllocator::isValid(const SlotHandle handle) const {
+    return handle.index < m_usedCount && handle.generation == m_generations[handle.index];
+}
+
+size_t SlotAllocator::size() const {
+    return m_usedCount - m_freeList.size();
+}
+
+size_t SlotAllocator::capacity() const {
+    return m_capacity;
+}
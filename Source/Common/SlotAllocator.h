@@ -0,0 +1,51 @@
+#pragma once
+
+#include <deque>
+#include <memory>
+#include <vector>
+#include "Definitions.h"
+
+// Generation-tagged handle of a slot. Once the slot is freed, the handle becomes stale.
+struct SlotHandle {
+    uint32_t index;                                 // UINT32_MAX if the allocation failed
+    uint32_t generation;
+};
+
+// Allocator of slots (e.g. descriptors) within a fixed-size table.
+// Freed slots are recycled via a free list, after the fence reaches the value
+// specified by the free() call, so that the GPU no longer uses the slot.
+// Each slot has a generation counter, which is incremented once the slot is freed,
+// allowing to detect the use of stale handles. Not thread-safe.
+class SlotAllocator {
+public:
+    RULE_OF_ZERO_MOVE_ONLY(SlotAllocator);
+    // Ctor; performs zero-initialization.
+    SlotAllocator();
+    // Ctor; takes the capacity (maximal number of slots) as input.
+    explicit SlotAllocator(const size_t capacity);
+    // Allocates a slot. Slots which have never been used are allocated in order.
+    // Returns a handle with the UINT32_MAX index if the table is full.
+    SlotHandle allocate();
+    // Frees the slot once the fence reaches 'fenceValue'.
+    // The fence values of consecutive calls must not decrease.
+    void free(const SlotHandle handle, const uint64_t fenceValue);
+    // Recycles the slots freed with fence values up to 'completedValue'.
+    void reclaim(const uint64_t completedValue);
+    // Returns 'true' if the handle refers to an allocated slot, 'false' if it is stale.
+    bool isValid(const SlotHandle handle) const;
+    // Returns the number of allocated slots (including the ones waiting for the fence).
+    size_t size() const;
+    // Returns the maximal number of slots.
+    size_t capacity() const;
+private:
+    struct PendingFree {
+        uint32_t index;
+        uint64_t fenceValue;
+    };
+private:
+    size_t                      m_capacity;
+    size_t                      m_usedCount;    // Number of slots used at least once
+    std::unique_ptr<uint32_t[]> m_generations;
+    std::vector<uint32_t>       m_freeList;     // LIFO
+    std::deque<PendingFree>     m_pendingFrees; // Ordered by the fence value
+};
@@ -0,0 +1,124 @@
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <immintrin.h>
+#include "Constants.h"
+#include "JobSystem.h"
+#include "StreamCopy.h"
+
+// Copies 'size' bytes without fencing the non-temporal stores.
+static inline auto copyWithoutFence(byte_t* dst, const byte_t* src, const size_t size)
+-> void {
+    // Copy the head using regular stores, so that the destination becomes 16 byte aligned.
+    const size_t headSize = std::min((16 - (reinterpret_cast<uintptr_t>(dst) & 15)) & 15, size);
+    memcpy(dst, src, headSize);
+    size_t i = headSize;
+    // Fill entire cache lines (write-combining buffers), one at a time.
+    for (; i + 64 <= size; i += 64) {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 16));
+        const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 32));
+        const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 48));
+        _mm_stream_si128(reinterpret_cast<__m128i*>(dst + i),      a);
+        _mm_stream_si128(reinterpret_cast<__m128i*>(dst + i + 16), b);
+        _mm_stream_si128(reinterpret_cast<__m128i*>(dst + i + 32), c);
+        _mm_stream_si128(reinterpret_cast<__m128i*>(dst + i + 48), d);
+    }
+    for (; i + 16 <= size; i += 16) {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        _mm_stream_si128(reinterpret_cast<__m128i*>(dst + i), a);
+    }
+    // Copy the tail using regular stores.
+    memcpy(dst + i, src + i, size - i);
+}
+
+// Copies the rows without fencing the non-temporal stores.
+static inline auto copyRowsWithoutFence(byte_t* dst, const size_t dstPitch, const byte_t* src,
+                                        const size_t srcPitch, const size_t rowSize,
+                                        const size_t rowCount)
+-> void {
+    for (size_t row = 0; row < rowCount; ++row) {
+        copyWithoutFence(dst + row * dstPitch, src + row * srcPitch, rowSize);
+    }
+}
+
+void streamCopy(void* dst, const void* src, const size_t size) {
+    copyWithoutFence(static_cast<byte_t*>(dst), static_cast<const byte_t*>(src), size);
+    // Make the non-temporal stores globally visible.
+    _mm_sfence();
+}
+
+void streamCopyRows(void* dst, const size_t dstPitch, const void* src, const size_t srcPitch,
+                    const size_t rowSize, const size_t rowCount) {
+    assert(rowSize <= dstPitch && rowSize <= srcPitch);
+    // Contiguous rows are copied at once.
+    if (dstPitch == rowSize && srcPitch == rowSize) {
+        streamCopy(dst, src, rowSize * rowCount);
+        return;
+    }
+    copyRowsWithoutFence(static_cast<byte_t*>(dst), dstPitch, static_cast<const byte_t*>(src),
+                         srcPitch, rowSize, rowCount);
+    _mm_sfence();
+}
+
+// Parallel loop: JobSystem::parallelFor() or JobSystem::isolatedParallelFor().
+using ParallelLoop = void (*)(const size_t, const size_t,
+                              const std::function<void(size_t, size_t)>&);
+
+// Splits the copy into chunks of COPY_CHUNK_SIZE bytes, and copies them using the loop.
+static inline auto copyInChunks(const ParallelLoop loop, void* dst, const void* src,
+                                const size_t size)
+-> void {
+    byte_t*       dstBytes = static_cast<byte_t*>(dst);
+    const byte_t* srcBytes = static_cast<const byte_t*>(src);
+    const size_t  chunkCount = (size + COPY_CHUNK_SIZE - 1) / COPY_CHUNK_SIZE;
+    loop(chunkCount, 1, [=](size_t begin, size_t end) {
+        const size_t offset = begin * COPY_CHUNK_SIZE;
+        const size_t count  = std::min(end * COPY_CHUNK_SIZE, size) - offset;
+        copyWithoutFence(dstBytes + offset, srcBytes + offset, count);
+        // Each thread has to fence its own stores.
+        _mm_sfence();
+    });
+}
+
+// Splits the rows into chunks of at least COPY_CHUNK_SIZE bytes, and copies them using the loop.
+static inline auto copyRowsInChunks(const ParallelLoop loop, void* dst, const size_t dstPitch,
+                                    const void* src, const size_t srcPitch,
+                                    const size_t rowSize, const size_t rowCount)
+-> void {
+    assert(rowSize <= dstPitch && rowSize <= srcPitch);
+    if (dstPitch == rowSize && srcPitch == rowSize) {
+        copyInChunks(loop, dst, src, rowSize * rowCount);
+        return;
+    }
+    byte_t*       dstBytes  = static_cast<byte_t*>(dst);
+    const byte_t* srcBytes  = static_cast<const byte_t*>(src);
+    // Each thread copies at least COPY_CHUNK_SIZE bytes (unless the rows are larger).
+    const size_t  chunkRows = size_t{COPY_CHUNK_SIZE} / std::max(rowSize, size_t{1});
+    const size_t  grainSize = std::max(chunkRows, size_t{1});
+    loop(rowCount, grainSize, [=](size_t begin, size_t end) {
+        copyRowsWithoutFence(dstBytes + begin * dstPitch, dstPitch,
+                             srcBytes + begin * srcPitch, srcPitch, rowSize, end - begin);
+        // Each thread has to fence its own stores.
+        _mm_sfence();
+    });
+}
+
+void parallelStreamCopy(void* dst, const void* src, const size_t size) {
+    copyInChunks(JobSystem::parallelFor, dst, src, size);
+}
+
+void parallelStreamCopyRows(void* dst, const size_t dstPitch, const void* src,
+                            const size_t srcPitch, const size_t rowSize, const size_t rowCount) {
+    copyRowsInChunks(JobSystem::parallelFor, dst, dstPitch, src, srcPitch, rowSize, rowCount);
+}
+
+void isolatedStreamCopy(void* dst, const void* src, const size_t size) {
+    copyInChunks(JobSystem::isolatedParallelFor, dst, src, size);
+}
+
+void isolatedStreamCopyRows(void* dst, const size_t dstPitch, const void* src,
+                            const size_t srcPitch, const size_t rowSize, const size_t rowCount) {
+    copyRowsInChunks(JobSystem::isolatedParallelFor, dst, dstPitch, src, srcPitch, rowSize,
+                     rowCount);
+}
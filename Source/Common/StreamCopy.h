@@ -0,0 +1,34 @@
+#pragma once
+
+#include "Definitions.h"
+
+// Copies 'size' bytes using non-temporal (streaming) stores, which bypass the cache.
+// Intended for write-combined memory (e.g. upload heaps) never read by the CPU.
+void streamCopy(void* dst, const void* src, const size_t size);
+
+// Copies 'rowCount' rows of 'rowSize' bytes using non-temporal stores.
+// Rows are 'srcPitch' bytes apart in the source, and 'dstPitch' bytes apart in the destination.
+void streamCopyRows(void* dst, const size_t dstPitch, const void* src, const size_t srcPitch,
+                    const size_t rowSize, const size_t rowCount);
+
+// Same as streamCopy(), but splits copies larger than COPY_CHUNK_SIZE across worker threads.
+// Blocks until the copy is complete. Meanwhile, the calling thread executes other jobs,
+// so it must not be called while holding a reservation (e.g. of the upload buffer)
+// other jobs may wait on. Use isolatedStreamCopy() instead.
+void parallelStreamCopy(void* dst, const void* src, const size_t size);
+
+// Same as streamCopyRows(), but splits copies larger than COPY_CHUNK_SIZE across worker threads.
+// Blocks until the copy is complete. Meanwhile, the calling thread executes other jobs,
+// so it must not be called while holding a reservation (e.g. of the upload buffer)
+// other jobs may wait on. Use isolatedStreamCopyRows() instead.
+void parallelStreamCopyRows(void* dst, const size_t dstPitch, const void* src,
+                            const size_t srcPitch, const size_t rowSize, const size_t rowCount);
+
+// Same as parallelStreamCopy(), but while waiting, the calling thread only copies
+// the chunks of this copy. Can be used to write into a reservation of the upload buffer.
+void isolatedStreamCopy(void* dst, const void* src, const size_t size);
+
+// Same as parallelStreamCopyRows(), but while waiting, the calling thread only copies
+// the chunks of this copy. Can be used to write into a reservation of the upload buffer.
+void isolatedStreamCopyRows(void* dst, const size_t dstPitch, const void* src,
+                            const size_t srcPitch, const size_t rowSize, const size_t rowCount);
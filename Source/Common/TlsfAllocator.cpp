@@ -0,0 +1,240 @@
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <immintrin.h>
+#ifdef _MSC_VER
+    #include <intrin.h>
+#endif
+#include "TlsfAllocator.h"
+
+// Returns the index of the most significant set bit. 'value' must not be 0.
+static inline auto findMsb(const uint64_t value)
+-> uint32_t {
+    assert(value != 0);
+    #ifdef _MSC_VER
+        unsigned long index;
+        _BitScanReverse64(&index, value);
+        return static_cast<uint32_t>(index);
+    #else
+        return 63 - static_cast<uint32_t>(__builtin_clzll(value));
+    #endif
+}
+
+TlsfAllocator::TlsfAllocator()
+    : m_capacity{0}
+    , m_granularity{0}
+    , m_usedSize{0}
+    , m_allocationCount{0}
+    , m_freeBlockCount{0}
+    , m_flBitmap{0}
+    , m_slBitmaps{}
+    , m_freeLists{} {}
+
+TlsfAllocator::TlsfAllocator(const size_t size, const size_t granularity)
+    : m_capacity{size & ~(granularity - 1)}
+    , m_granularity{granularity}
+    , m_usedSize{0}
+    , m_allocationCount{0}
+    , m_freeBlockCount{0}
+    , m_flBitmap{0}
+    , m_slBitmaps{} {
+    assert(granularity > 0 && 0 == (granularity & (granularity - 1)));
+    assert(m_capacity > 0);
+    memset(m_freeLists, 0xFF, sizeof(m_freeLists));
+    // The entire range is a single free block.
+    insertFreeBlock(createBlock(0, m_capacity));
+}
+
+auto TlsfAllocator::allocate(const size_t size, const size_t alignment)
+-> Allocation {
+    assert(size > 0 && 0 == (alignment & (alignment - 1)));
+    const size_t alignedSize = (size + m_granularity - 1) & ~(m_granularity - 1);
+    // Offsets are always aligned to the granularity. For larger alignments,
+    // reserve enough space to skip to the next aligned offset.
+    const size_t   blockAlignment = std::max(alignment, m_granularity);
+    const size_t   padding        = blockAlignment - m_granularity;
+    const uint32_t index          = findFreeBlock((alignedSize + padding) / m_granularity);
+    if (index == INVALID_BLOCK) {
+        return Allocation{0, 0, INVALID_BLOCK};
+    }
+    removeFreeBlock(index);
+    uint32_t block = index;
+    // Split off the padding at the beginning of the block as a separate free block.
+    const size_t offset    = m_blocks[block].offset;
+    const size_t frontSize = ((offset + padding) & ~(blockAlignment - 1)) - offset;
+    if (frontSize > 0) {
+        splitBlock(block, frontSize);
+        const uint32_t next = m_blocks[block].nextPhys;
+        // Keep the front block free, and allocate the next one.
+        removeFreeBlock(next);
+        insertFreeBlock(block);
+        block = next;
+    }
+    // Return the unused space at the end of the block to the free lists.
+    if (m_blocks[block].size > alignedSize) {
+        splitBlock(block, alignedSize);
+    }
+    m_blocks[block].isFree = false;
+    m_usedSize += alignedSize;
+    m_allocationCount++;
+    return Allocation{m_blocks[block].offset, alignedSize, block};
+}
+
+void TlsfAllocator::free(const Allocation& allocation) {
+    uint32_t index = allocation.block;
+    assert(index < m_blocks.size() && !m_blocks[index].isFree);
+    assert(m_blocks[index].offset == allocation.offset);
+    m_usedSize -= m_blocks[index].size;
+    m_allocationCount--;
+    // Merge with the previous block.
+    const uint32_t prev = m_blocks[index].prevPhys;
+    if (prev != INVALID_BLOCK && m_blocks[prev].isFree) {
+        removeFreeBlock(prev);
+        m_blocks[prev].size     += m_blocks[index].size;
+        m_blocks[prev].nextPhys  = m_blocks[index].nextPhys;
+        if (m_blocks[index].nextPhys != INVALID_BLOCK) {
+            m_blocks[m_blocks[index].nextPhys].prevPhys = prev;
+        }
+        m_unusedBlocks.push_back(index);
+        index = prev;
+    }
+    // Merge with the next block.
+    const uint32_t next = m_blocks[index].nextPhys;
+    if (next != INVALID_BLOCK && m_blocks[next].isFree) {
+        removeFreeBlock(next);
+        m_blocks[index].size     += m_blocks[next].size;
+        m_blocks[index].nextPhys  = m_blocks[next].nextPhys;
+        if (m_blocks[next].nextPhys != INVALID_BLOCK) {
+            m_blocks[m_blocks[next].nextPhys].prevPhys = index;
+        }
+        m_unusedBlocks.push_back(next);
+    }
+    insertFreeBlock(index);
+}
+
+auto TlsfAllocator::computeStats() const
+-> Stats {
+    Stats stats;
+    stats.capacity        = m_capacity;
+    stats.usedSize        = m_usedSize;
+    stats.freeSize        = m_capacity - m_usedSize;
+    stats.largestFreeSize = 0;
+    stats.allocationCount = m_allocationCount;
+    stats.freeBlockCount  = m_freeBlockCount;
+    if (m_flBitmap) {
+        // The blocks of the highest non-empty list are the largest ones.
+        const uint32_t fl = findMsb(m_flBitmap);
+        const uint32_t sl = findMsb(m_slBitmaps[fl]);
+        for (uint32_t i = m_freeLists[fl][sl]; i != INVALID_BLOCK; i = m_blocks[i].nextFree) {
+            stats.largestFreeSize = std::max(stats.largestFreeSize, m_blocks[i].size);
+        }
+    }
+    stats.fragmentation = (stats.freeSize > 0) ? 1.f - static_cast<float>(stats.largestFreeSize) /
+                                                       static_cast<float>(stats.freeSize)
+                                               : 0.f;
+    return stats;
+}
+
+void TlsfAllocator::mapSize(const size_t units, uint32_t* fl, uint32_t* sl) {
+    // Small blocks are kept in the linear lists of the first level 0.
+    if (units < SL_COUNT) {
+        *fl = 0;
+        *sl = static_cast<uint32_t>(units);
+    } else {
+        const uint32_t msb = findMsb(units);
+        *fl = msb - SL_LOG2 + 1;
+        *sl = static_cast<uint32_t>(units >> (msb - SL_LOG2)) - SL_COUNT;
+    }
+}
+
+uint32_t TlsfAllocator::findFreeBlock(const size_t units) const {
+    // Round the size up to the next class, so that any block of the list is large enough.
+    size_t roundedUnits = units;
+    if (units >= SL_COUNT) {
+        roundedUnits += (size_t{1} << (findMsb(units) - SL_LOG2)) - 1;
+    }
+    uint32_t fl, sl;
+    mapSize(roundedUnits, &fl, &sl);
+    if (fl >= FL_COUNT) return INVALID_BLOCK;
+    // Search the current first level list, and then the larger ones.
+    uint32_t slBitmap = m_slBitmaps[fl] & (~0u << sl);
+    if (!slBitmap) {
+        const uint64_t flBitmap = (fl + 1 < FL_COUNT) ? m_flBitmap & (~0ull << (fl + 1)) : 0;
+        if (!flBitmap) return INVALID_BLOCK;
+        fl       = static_cast<uint32_t>(_tzcnt_u64(flBitmap));
+        slBitmap = m_slBitmaps[fl];
+    }
+    sl = _tzcnt_u32(slBitmap);
+    return m_freeLists[fl][sl];
+}
+
+void TlsfAllocator::insertFreeBlock(const uint32_t index) {
+    Block& block = m_blocks[index];
+    uint32_t fl, sl;
+    mapSize(block.size / m_granularity, &fl, &sl);
+    const uint32_t head = m_freeLists[fl][sl];
+    block.isFree   = true;
+    block.prevFree = INVALID_BLOCK;
+    block.nextFree = head;
+    if (head != INVALID_BLOCK) {
+        m_blocks[head].prevFree = index;
+    }
+    m_freeLists[fl][sl] = index;
+    m_slBitmaps[fl]    |= 1u << sl;
+    m_flBitmap         |= 1ull << fl;
+    m_freeBlockCount++;
+}
+
+void TlsfAllocator::removeFreeBlock(const uint32_t index) {
+    Block& block = m_blocks[index];
+    assert(block.isFree);
+    if (block.prevFree != INVALID_BLOCK) {
+        m_blocks[block.prevFree].nextFree = block.nextFree;
+    } else {
+        uint32_t fl, sl;
+        mapSize(block.size / m_granularity, &fl, &sl);
+        m_freeLists[fl][sl] = block.nextFree;
+        // Update the bitmaps if the list becomes empty.
+        if (block.nextFree == INVALID_BLOCK) {
+            m_slBitmaps[fl] &= ~(1u << sl);
+            if (!m_slBitmaps[fl]) {
+                m_flBitmap &= ~(1ull << fl);
+            }
+        }
+    }
+    if (block.nextFree != INVALID_BLOCK) {
+        m_blocks[block.nextFree].prevFree = block.prevFree;
+    }
+    block.isFree = false;
+    m_freeBlockCount--;
+}
+
+void TlsfAllocator::splitBlock(const uint32_t index, const size_t size) {
+    assert(size < m_blocks[index].size);
+    const size_t   offset    = m_blocks[index].offset + size;
+    const size_t   remainder = m_blocks[index].size - size;
+    // Note: createBlock() may reallocate the storage, invalidating references.
+    const uint32_t next      = createBlock(offset, remainder);
+    const uint32_t nextPhys  = m_blocks[index].nextPhys;
+    m_blocks[next].prevPhys  = index;
+    m_blocks[next].nextPhys  = nextPhys;
+    if (nextPhys != INVALID_BLOCK) {
+        m_blocks[nextPhys].prevPhys = next;
+    }
+    m_blocks[index].size     = size;
+    m_blocks[index].nextPhys = next;
+    insertFreeBlock(next);
+}
+
+uint32_t TlsfAllocator::createBlock(const size_t offset, const size_t size) {
+    const Block block = {offset, size, INVALID_BLOCK, INVALID_BLOCK,
+                         INVALID_BLOCK, INVALID_BLOCK, false};
+    if (!m_unusedBlocks.empty()) {
+        const uint32_t index = m_unusedBlocks.back();
+        m_unusedBlocks.pop_back();
+        m_blocks[index] = block;
+        return index;
+    }
+    m_blocks.push_back(block);
+    return static_cast<uint32_t>(m_blocks.size() - 1);
+}
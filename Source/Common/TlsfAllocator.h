@@ -0,0 +1,78 @@
+#pragma once
+
+#include <vector>
+#include "Definitions.h"
+
+// Two-Level Segregated Fit allocator of address ranges, e.g. within a GPU heap.
+// It only manages offsets and does not access the memory, so it can suballocate any storage.
+// Free blocks are kept in segregated lists: the first level splits the sizes by powers of 2,
+// and the second level splits each power of 2 into 16 linear classes. Bitmaps of non-empty
+// lists allow to find a suitable block, to allocate and to free in constant time.
+// The offsets and the sizes of all blocks are multiples of the granularity.
+class TlsfAllocator {
+public:
+    // Allocated range.
+    struct Allocation {
+        size_t   offset;            // From the beginning of the managed range
+        size_t   size;              // Multiple of the granularity
+        uint32_t block;             // Internal index; INVALID_BLOCK if the allocation failed
+    };
+    // Statistics of the managed range.
+    struct Stats {
+        size_t   capacity;          // Bytes
+        size_t   usedSize;          // Bytes
+        size_t   freeSize;          // Bytes
+        size_t   largestFreeSize;   // Bytes
+        size_t   allocationCount;
+        size_t   freeBlockCount;
+        float    fragmentation;     // 1 - largestFreeSize / freeSize
+    };
+    static constexpr uint32_t INVALID_BLOCK = UINT32_MAX;
+    RULE_OF_ZERO_MOVE_ONLY(TlsfAllocator);
+    // Ctor; performs zero-initialization.
+    TlsfAllocator();
+    // Ctor; takes the size of the managed range and the granularity (a power of 2)
+    // in bytes as input. The size is rounded down to a multiple of the granularity.
+    explicit TlsfAllocator(const size_t size, const size_t granularity);
+    // Allocates 'size' bytes with the offset aligned to 'alignment' (a power of 2).
+    // Returns an allocation with the INVALID_BLOCK index if there is no large enough block.
+    Allocation allocate(const size_t size, const size_t alignment);
+    // Frees the allocation. Merges the resulting free block with its free neighbors.
+    void free(const Allocation& allocation);
+    // Computes the statistics. The largest free block is found in the highest non-empty list.
+    Stats computeStats() const;
+private:
+    struct Block {
+        size_t   offset;
+        size_t   size;
+        uint32_t prevPhys, nextPhys;    // Adjacent blocks in the address order
+        uint32_t prevFree, nextFree;    // Adjacent blocks within the free list
+        bool     isFree;
+    };
+    // Number of second level classes per power of 2 is 2^SL_LOG2.
+    static constexpr uint32_t SL_LOG2  = 4;
+    static constexpr uint32_t SL_COUNT = 1 << SL_LOG2;
+    static constexpr uint32_t FL_COUNT = 64;
+    // Computes the indices of the list of the blocks of 'units' granules.
+    static void mapSize(const size_t units, uint32_t* fl, uint32_t* sl);
+    // Finds a free block of at least 'units' granules. Returns INVALID_BLOCK on failure.
+    uint32_t findFreeBlock(const size_t units) const;
+    // Inserts the block into the free list, or removes it from the list.
+    void insertFreeBlock(const uint32_t index);
+    void removeFreeBlock(const uint32_t index);
+    // Splits the block, so that it is 'size' bytes large. The remainder becomes a free block.
+    void splitBlock(const uint32_t index, const size_t size);
+    // Creates a new block descriptor. Returns its index.
+    uint32_t createBlock(const size_t offset, const size_t size);
+private:
+    size_t                m_capacity;
+    size_t                m_granularity;
+    size_t                m_usedSize;
+    size_t                m_allocationCount;
+    size_t                m_freeBlockCount;
+    uint64_t              m_flBitmap;                   // Non-empty first level lists
+    uint32_t              m_slBitmaps[FL_COUNT];        // Non-empty second level lists
+    uint32_t              m_freeLists[FL_COUNT][SL_COUNT];
+    std::vector<Block>    m_blocks;
+    std::vector<uint32_t> m_unusedBlocks;               // Indices of recyclable descriptors
+};
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <memory>
+#include "Definitions.h"
+
+// Multi-producer ring buffer allocator for upload (staging) memory.
+// Allocations are reserved lock-free, and belong to the current segment of the buffer.
+// The consumer (e.g. the copy queue submission) closes the segment after each submission.
+// Once all allocations of a segment are committed, and the fence reaches the largest fence
+// value they were committed with, the segment is retired, and its memory can be reused.
+// Segments are retired in order. If the buffer is full, the producers have to wait
+// (see waitForSpace()) for the oldest segment to be retired.
+// 'Fence' must provide the 'uint64_t completedValue() const' and
+// 'void wait(const uint64_t value) const' member functions.
+template <typename Fence>
+class UploadRing {
+public:
+    // Chunk of memory reserved within the buffer.
+    struct Allocation {
+        byte_t*  address;       // nullptr if the reservation failed
+        size_t   offset;        // From the beginning of the buffer
+        uint64_t segment;       // Index of the segment
+    };
+    RULE_OF_ZERO_MOVE_ONLY(UploadRing);
+    // Ctor; performs zero-initialization.
+    UploadRing();
+    // Ctor; takes the memory region of 'capacity' bytes, the maximal number of segments
+    // in flight, and the fence signaled by the consumer as input.
+    explicit UploadRing(byte_t* begin, const size_t capacity, const size_t maxSegmentCount,
+                        Fence fence);
+    // Attempts to reserve 'size' bytes aligned to 'alignment' within the current segment.
+    // Retires the completed segments if necessary. Does not block.
+    // If the buffer is full, returns an allocation with the 'nullptr' address.
+    Allocation tryReserve(const size_t size, const size_t alignment);
+    // Commits the allocation once the commands using it are recorded.
+    // The memory is reused after the fence reaches 'fenceValue'.
+    void commit(const Allocation& allocation, const uint64_t fenceValue);
+    // Closes the current segment, and begins a new one. Called by the consumer
+    // after it submits the commands, the last of which signals 'submittedFenceValue'.
+    // If 'maxSegmentCount' segments are in flight, the current segment is not closed.
+    void closeSegment(const uint64_t submittedFenceValue);
+    // Blocks until the oldest closed segment is retired.
+    // Returns 'false' if there is nothing to wait for: the current segment has to be closed
+    // (after the pending commands are submitted) first.
+    bool waitForSpace();
+    // Returns the size of the buffer (in bytes).
+    size_t capacity() const;
+private:
+    struct Segment;
+    struct State;
+    // Returns the segment with the specified index.
+    Segment& segment(const uint64_t index) const;
+    // Retires the completed segments. Must be called with the retirement mutex locked.
+    // Returns 'true' if at least one segment has been retired.
+    bool retireCompletedSegments();
+private:
+    byte_t*                m_begin;
+    size_t                 m_capacity;
+    size_t                 m_maxSegmentCount;
+    Fence                  m_fence;
+    std::unique_ptr<State> m_state;
+};
@@ -0,0 +1,188 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <mutex>
+#include <thread>
+#include "UploadRing.h"
+
+// All offsets below are virtual: they grow monotonically, and the offset within the buffer
+// is computed modulo the capacity. Therefore, 'end - tail' is the amount of memory in use.
+template <typename Fence>
+struct UploadRing<Fence>::Segment {
+    std::atomic<size_t>   writerCount;      // Reserved, but not yet committed allocations
+    std::atomic<uint64_t> fenceValue;       // The largest fence value of the commits
+    uint64_t              begin;            // Head at the time the segment was opened
+};
+
+template <typename Fence>
+struct UploadRing<Fence>::State {
+    std::atomic<uint64_t>      head;        // End of the last reservation
+    std::atomic<uint64_t>      tail;        // Beginning of the oldest segment in use
+    std::atomic<uint64_t>      current;     // Index of the current (open) segment
+    std::mutex                 mutex;       // Guards the fields below, and segment retirement
+    uint64_t                   oldest;      // Index of the oldest segment in use
+    uint64_t                   submittedFenceValue;
+    std::unique_ptr<Segment[]> segments;    // Ring of 'maxSegmentCount' segments
+};
+
+template <typename Fence>
+inline UploadRing<Fence>::UploadRing()
+    : m_begin{nullptr}
+    , m_capacity{0}
+    , m_maxSegmentCount{0}
+    , m_fence{} {}
+
+template <typename Fence>
+inline UploadRing<Fence>::UploadRing(byte_t* begin, const size_t capacity,
+                                     const size_t maxSegmentCount, Fence fence)
+    : m_begin{begin}
+    , m_capacity{capacity}
+    , m_maxSegmentCount{maxSegmentCount}
+    , m_fence{fence}
+    , m_state{std::make_unique<State>()} {
+    assert(begin && capacity > 0 && maxSegmentCount >= 2);
+    m_state->head    = 0;
+    m_state->tail    = 0;
+    m_state->current = 0;
+    m_state->oldest  = 0;
+    m_state->submittedFenceValue = 0;
+    m_state->segments = std::make_unique<Segment[]>(maxSegmentCount);
+    for (size_t i = 0; i < maxSegmentCount; ++i) {
+        m_state->segments[i].writerCount = 0;
+        m_state->segments[i].fenceValue  = 0;
+        m_state->segments[i].begin       = 0;
+    }
+}
+
+template <typename Fence>
+inline auto UploadRing<Fence>::tryReserve(const size_t size, const size_t alignment)
+-> Allocation {
+    assert(size > 0 && size <= m_capacity);
+    assert(0 == (alignment & (alignment - 1)) && 0 == m_capacity % alignment);
+    assert(0 == reinterpret_cast<size_t>(m_begin) % alignment);
+    State& state = *m_state;
+    // Enter the current segment. Since the consumer may close it concurrently,
+    // make sure the segment is still current after the writer is registered.
+    uint64_t index;
+    while (true) {
+        index = state.current.load();
+        segment(index).writerCount.fetch_add(1);
+        if (index == state.current.load()) break;
+        segment(index).writerCount.fetch_sub(1);
+    }
+    // Reserve a contiguous chunk of memory.
+    uint64_t head = state.head.load();
+    uint64_t start;
+    while (true) {
+        start = (head + alignment - 1) & ~static_cast<uint64_t>(alignment - 1);
+        // Skip the end of the buffer if the chunk does not fit.
+        if (start % m_capacity + size > m_capacity) {
+            start = (start / m_capacity + 1) * m_capacity;
+        }
+        const uint64_t end = start + size;
+        if (end - state.tail.load() > m_capacity) {
+            // The buffer is full. Attempt to retire the completed segments without blocking.
+            bool isRetired = false;
+            if (state.mutex.try_lock()) {
+                isRetired = retireCompletedSegments();
+                state.mutex.unlock();
+            }
+            if (!isRetired) {
+                segment(index).writerCount.fetch_sub(1);
+                return Allocation{nullptr, 0, index};
+            }
+            head = state.head.load();
+        } else if (state.head.compare_exchange_weak(head, end)) {
+            break;
+        }
+    }
+    const size_t offset = static_cast<size_t>(start % m_capacity);
+    return Allocation{m_begin + offset, offset, index};
+}
+
+template <typename Fence>
+inline void UploadRing<Fence>::commit(const Allocation& allocation, const uint64_t fenceValue) {
+    assert(allocation.address);
+    Segment& seg = segment(allocation.segment);
+    // Atomically compute the maximum of the fence values.
+    uint64_t value = seg.fenceValue.load();
+    while (value < fenceValue && !seg.fenceValue.compare_exchange_weak(value, fenceValue)) {}
+    seg.writerCount.fetch_sub(1);
+}
+
+template <typename Fence>
+inline void UploadRing<Fence>::closeSegment(const uint64_t submittedFenceValue) {
+    State& state = *m_state;
+    std::lock_guard<std::mutex> lock{state.mutex};
+    state.submittedFenceValue = submittedFenceValue;
+    retireCompletedSegments();
+    const uint64_t index = state.current.load();
+    const uint64_t head  = state.head.load();
+    // Keep using the current segment if it is empty, or if there are no free segments.
+    if (head == segment(index).begin || index + 1 - state.oldest >= m_maxSegmentCount) return;
+    // The allocations which begin before 'head' belong to the closed segments.
+    Segment& next   = segment(index + 1);
+    next.fenceValue = 0;
+    next.begin      = head;
+    state.current.store(index + 1);
+}
+
+template <typename Fence>
+inline bool UploadRing<Fence>::waitForSpace() {
+    State&   state = *m_state;
+    uint64_t fenceValue;
+    bool     isWritten;
+    {
+        std::lock_guard<std::mutex> lock{state.mutex};
+        retireCompletedSegments();
+        const uint64_t index = state.oldest;
+        // The current segment cannot be retired.
+        if (index == state.current.load()) return false;
+        const Segment& seg = segment(index);
+        fenceValue = seg.fenceValue.load();
+        isWritten  = seg.writerCount.load() > 0;
+        // Commits made after the last submission refer to commands not yet submitted.
+        if (fenceValue > state.submittedFenceValue) return false;
+    }
+    if (isWritten) {
+        // Wait for the writers to commit their allocations.
+        std::this_thread::yield();
+    } else {
+        m_fence.wait(fenceValue);
+    }
+    std::lock_guard<std::mutex> lock{state.mutex};
+    retireCompletedSegments();
+    return true;
+}
+
+template <typename Fence>
+inline auto UploadRing<Fence>::capacity() const
+-> size_t {
+    return m_capacity;
+}
+
+template <typename Fence>
+inline auto UploadRing<Fence>::segment(const uint64_t index) const
+-> Segment& {
+    return m_state->segments[index % m_maxSegmentCount];
+}
+
+template <typename Fence>
+inline auto UploadRing<Fence>::retireCompletedSegments()
+-> bool {
+    State&         state          = *m_state;
+    const uint64_t completedValue = m_fence.completedValue();
+    const uint64_t current        = state.current.load();
+    uint64_t       index          = state.oldest;
+    while (index < current) {
+        const Segment& seg = segment(index);
+        if (seg.writerCount.load() > 0 || seg.fenceValue.load() > completedValue) break;
+        ++index;
+    }
+    if (index == state.oldest) return false;
+    state.oldest = index;
+    // The allocations which begin before the oldest segment are no longer in use.
+    state.tail.store(segment(index).begin);
+    return true;
+}
@@ -6,9 +6,21 @@
 #include <ctime>
 #include "Definitions.h"
 
+#ifndef _WIN32
+    // Counterparts of the bounds-checked functions of the Microsoft CRT.
+    static inline int localtime_s(struct tm* result, const time_t* time) {
+        return localtime_r(time, result) ? 0 : -1;
+    }
+
+    static inline int fopen_s(FILE** file, const char* fileName, const char* mode) {
+        *file = fopen(fileName, mode);
+        return *file ? 0 : -1;
+    }
+#endif
+
 // For internal use only!
 static inline void printInternal(FILE* stream, const char* prefix, const char* fmt,
-                                 const va_list args) {
+                                 va_list args) {
     // Print the time stamp.
     time_t rawTime;
     time(&rawTime);
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "HelperStructs.h"
+#include "..\Common\Constants.h"
+
+namespace D3D12 {
+    // Records commands into a Direct3D 12 graphics command list.
+    // Implements the set of commands of CommandStream (the null backend); resources,
+    // index buffers and textures are identified by their indices within the provided arrays.
+    class CommandEncoder {
+    public:
+        RULE_OF_ZERO(CommandEncoder);
+        // Ctor; takes the command list, the texture pool, the index buffer views
+        // and (optionally) the resources used by transition barriers as input.
+        explicit CommandEncoder(ID3D12GraphicsCommandList* commandList,
+                                CbvSrvUavPool<TEX_CNT>* texPool,
+                                const D3D12_INDEX_BUFFER_VIEW* indexBufferViews,
+                                ID3D12Resource* const* resources = nullptr);
+        // Transitions the resource with the specified index from 'stateBefore' to 'stateAfter'.
+        void transition(const uint32_t resource, const uint32_t stateBefore,
+                        const uint32_t stateAfter, const uint32_t flags = 0);
+        // Sets 'count' 32-bit root constants of the root parameter, starting at 'offset'.
+        void setRootConstants(const uint32_t param, const uint32_t count, const void* data,
+                              const uint32_t offset);
+        // Sets a single 32-bit root constant of the root parameter at 'offset'.
+        void setRootConstant(const uint32_t param, const uint32_t value, const uint32_t offset);
+        // Sets the descriptor table of the root parameter to start at the texture descriptor.
+        void setDescriptorTable(const uint32_t param, const uint32_t texIndex);
+        // Sets the index buffer with the specified index.
+        void setIndexBuffer(const uint32_t buffer);
+        // Draws 'indexCount' indices of the current index buffer, starting with 'firstIndex'.
+        void drawIndexed(const uint32_t indexCount, const uint32_t firstIndex);
+    private:
+        ID3D12GraphicsCommandList*     m_commandList;
+        CbvSrvUavPool<TEX_CNT>*        m_texPool;
+        const D3D12_INDEX_BUFFER_VIEW* m_indexBufferViews;
+        ID3D12Resource* const*         m_resources;
+    };
+} // namespace D3D12
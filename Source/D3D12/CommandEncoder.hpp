@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cassert>
+#include "CommandEncoder.h"
+#include "HelperStructs.hpp"
+
+namespace D3D12 {
+    inline CommandEncoder::CommandEncoder(ID3D12GraphicsCommandList* commandList,
+                                          CbvSrvUavPool<TEX_CNT>* texPool,
+                                          const D3D12_INDEX_BUFFER_VIEW* indexBufferViews,
+                                          ID3D12Resource* const* resources)
+        : m_commandList{commandList}
+        , m_texPool{texPool}
+        , m_indexBufferViews{indexBufferViews}
+        , m_resources{resources} {}
+
+    inline void CommandEncoder::transition(const uint32_t resource, const uint32_t stateBefore,
+                                           const uint32_t stateAfter, const uint32_t flags) {
+        assert(m_resources);
+        const D3D12_TRANSITION_BARRIER barrier{
+            m_resources[resource],
+            static_cast<D3D12_RESOURCE_STATES>(stateBefore),
+            static_cast<D3D12_RESOURCE_STATES>(stateAfter),
+            static_cast<D3D12_RESOURCE_BARRIER_FLAGS>(flags)
+        };
+        m_commandList->ResourceBarrier(1, &barrier);
+    }
+
+    inline void CommandEncoder::setRootConstants(const uint32_t param, const uint32_t count,
+                                                 const void* data, const uint32_t offset) {
+        m_commandList->SetGraphicsRoot32BitConstants(param, count, data, offset);
+    }
+
+    inline void CommandEncoder::setRootConstant(const uint32_t param, const uint32_t value,
+                                                const uint32_t offset) {
+        m_commandList->SetGraphicsRoot32BitConstant(param, value, offset);
+    }
+
+    inline void CommandEncoder::setDescriptorTable(const uint32_t param, const uint32_t texIndex) {
+        m_commandList->SetGraphicsRootDescriptorTable(param, m_texPool->gpuHandle(texIndex));
+    }
+
+    inline void CommandEncoder::setIndexBuffer(const uint32_t buffer) {
+        m_commandList->IASetIndexBuffer(&m_indexBufferViews[buffer]);
+    }
+
+    inline void CommandEncoder::drawIndexed(const uint32_t indexCount, const uint32_t firstIndex) {
+        m_commandList->DrawIndexedInstanced(indexCount, 1, firstIndex, 0, 0);
+    }
+} // namespace D3D12
@@ -6,6 +6,8 @@
 #include <utility>
 #include <wrl\client.h>
 #include "..\Common\Definitions.h"
+#include "..\Common\SlotAllocator.h"
+#include "..\Common\TlsfAllocator.h"
 
 namespace D3D12 {
     using Microsoft::WRL::ComPtr;
@@ -35,54 +37,73 @@ namespace D3D12 {
                                             const D3D12_RESOURCE_STATES after);
     };
 
-	// Segmented ("double buffered") upload ring buffer.
+    struct D3D12_ALIASING_BARRIER: public D3D12_RESOURCE_BARRIER {
+        // Activates the resource, which shares memory with other placed resources.
+        // If 'before' is null, any resource sharing the memory may have been active.
+        explicit D3D12_ALIASING_BARRIER(ID3D12Resource* before, ID3D12Resource* after);
+    };
+
+    // Persistently mapped upload buffer. Its memory is managed by an UploadRing.
     struct UploadRingBuffer {
         RULE_OF_FIVE_MOVE_ONLY(UploadRingBuffer);
         UploadRingBuffer();
-        // Returns the amount of unused space (in bytes) in the buffer.
-        // Effectively, computes the distance from 'offset' to 'prevSegStart'
-        // (or 'currSegStart' if the former is invalid) with respect to the wrap-around.
-        size_t remainingCapacity() const;
-        // Returns the size (in bytes) of the previous segment of the buffer.
-        size_t previousSegmentSize() const;
     public:
         ComPtr<ID3D12Resource>      resource;        // Memory buffer
         byte_t*                     begin;           // CPU virtual memory-mapped address
         uint32_t                    capacity;        // Buffer size (in bytes)
-        uint32_t                    offset;          // Offset from the beginning of the buffer
-        uint32_t                    prevSegStart;    // Offset to the beginning of the prev. segment
-        uint32_t                    currSegStart;    // Offset to the beginning of the curr. segment
+    };
+
+    // Fence of a command queue, as observed by the CPU. Used by the UploadRing.
+    struct QueueFence {
+        // Returns the value of the fence reached so far.
+        uint64_t completedValue() const;
+        // Stalls the execution of the current thread until the fence reaches the value.
+        void wait(const uint64_t value) const;
+    public:
+        ID3D12Fence*                fence;
+    };
+
+    // Memory of a placed resource.
+    struct HeapAllocation {
+        TlsfAllocator::Allocation   range;           // Range within the heap
+        uint32_t                    heap;            // Index of the heap; UINT32_MAX if committed
     };
 
     struct VertexBuffer {
         ComPtr<ID3D12Resource>      resource;        // Memory buffer
         D3D12_VERTEX_BUFFER_VIEW    view;            // Descriptor
+        HeapAllocation              memory;          // Memory of the resource
     };
 
     struct IndexBuffer {
         ComPtr<ID3D12Resource>      resource;        // Memory buffer
         D3D12_INDEX_BUFFER_VIEW     view;            // Descriptor
+        HeapAllocation              memory;          // Memory of the resource
     };
 
     // Ideally suited for uniform (convergent) access patterns.
     struct ConstantBuffer {
         ComPtr<ID3D12Resource>      resource;        // Memory buffer
         D3D12_GPU_VIRTUAL_ADDRESS   view;            // Descriptor (Constant Buffer View)
+        HeapAllocation              memory;          // Memory of the resource
     };
 
     // Ideally suited for non-uniform (divergent) access patterns.
     struct StructuredBuffer {
         ComPtr<ID3D12Resource>      resource;        // Memory buffer
         D3D12_GPU_VIRTUAL_ADDRESS   view;            // Descriptor (Shader Resource View)
+        HeapAllocation              memory;          // Memory of the resource
     };
 
     struct Texture {
         ComPtr<ID3D12Resource>      resource;        // Memory buffer
         D3D12_GPU_DESCRIPTOR_HANDLE view;            // Descriptor handle (Shader Resource View)
+        SlotHandle                  slot;            // Slot of the view within the texture pool
+        HeapAllocation              memory;          // Memory of the resource
     };
 
     // Stores objects of type T in the SoA layout.
-    // T must be composed of 2 members: 'resource' and 'view'.
+    // T must have 2 members: 'resource' and 'view'. Other members are not stored.
     template <typename T>
     struct ResourceViewSoA {
         // Allocates an SoA for 'count' elements.
@@ -115,8 +136,19 @@ namespace D3D12 {
     };
 
     // Wrapper for a descriptor heap of capacity N.
+    // Descriptor slots are allocated and recycled using a SlotAllocator. Not thread-safe.
     template <DescType T, size_t N>
     struct DescriptorPool {
+        // Allocates a descriptor slot. Terminates the application if the pool is full.
+        SlotHandle allocate();
+        // Frees the descriptor slot once the fence reaches 'fenceValue'.
+        void free(const SlotHandle slot, const uint64_t fenceValue);
+        // Recycles the descriptor slots freed with fence values up to 'completedValue'.
+        void reclaim(const uint64_t completedValue);
+        // Returns 'true' if the handle refers to an allocated slot, 'false' if it is stale.
+        bool isValid(const SlotHandle slot) const;
+        // Returns the number of allocated descriptors.
+        size_t size() const;
         // Returns the pointer to the underlying descriptor heap.
         ID3D12DescriptorHeap* descriptorHeap();
         // Returns the CPU handle of the descriptor stored at the 'index' position.
@@ -128,8 +160,8 @@ namespace D3D12 {
         size_t computeIndex(const D3D12_GPU_DESCRIPTOR_HANDLE handle) const;
     public:
         static constexpr size_t      capacity = N;   // Maximal descriptor count
-        uint32_t                     size;           // Current descriptor count
     private:
+        SlotAllocator                m_slots;        // Descriptor slot allocator
         uint32_t                     m_handleIncrSz; // Descriptor handle increment size
         D3D12_CPU_DESCRIPTOR_HANDLE  m_cpuBegin;     // CPU handle of the 1st descriptor of the pool
         D3D12_GPU_DESCRIPTOR_HANDLE  m_gpuBegin;     // GPU handle of the 1st descriptor of the pool
@@ -164,6 +196,14 @@ namespace D3D12 {
         // and inserts a fence into the command queue afterwards.
         // Returns the inserted fence and its value.
         std::pair<ID3D12Fence*, uint64_t> executeCommandLists();
+        // Closes 'count' command lists with the specified indices, submits them for execution
+        // in the specified order, and inserts a fence into the command queue afterwards.
+        // Returns the inserted fence and its value.
+        std::pair<ID3D12Fence*, uint64_t> executeCommandLists(const size_t count,
+                                                              const size_t* indices);
+        // Inserts a fence into the command queue without submitting any commands.
+        // Returns the inserted fence and its value.
+        std::pair<ID3D12Fence*, uint64_t> insertFence();
         // Stalls the execution of the current thread until
         // the fence with the specified value is reached.
         void syncThread(const uint64_t fenceValue);
@@ -187,6 +227,10 @@ namespace D3D12 {
         /* Accessors */
         ID3D12GraphicsCommandList*        commandList(const size_t index);
         const ID3D12GraphicsCommandList*  commandList(const size_t index) const;
+        // Returns the fence inserted after each submission.
+        QueueFence                        fence() const;
+        // Returns the value of the last inserted fence.
+        uint64_t                          fenceValue() const;
     public:
         static constexpr size_t           bufferCount      = N;
         static constexpr size_t           commandListCount = L;
@@ -113,35 +113,23 @@ namespace D3D12 {
                                         D3D12_RESOURCE_BARRIER_FLAG_END_ONLY};
     }
 
+    inline D3D12_ALIASING_BARRIER::D3D12_ALIASING_BARRIER(ID3D12Resource* before,
+                                                          ID3D12Resource* after) {
+        Type                     = D3D12_RESOURCE_BARRIER_TYPE_ALIASING;
+        Flags                    = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+        Aliasing.pResourceBefore = before;
+        Aliasing.pResourceAfter  = after;
+    }
+
     inline UploadRingBuffer::UploadRingBuffer()
         : resource{nullptr}
         , begin{nullptr}
-        , capacity{0}
-        , offset{0}
-        , prevSegStart{0}
-        , currSegStart{0} {}
-
-    inline auto UploadRingBuffer::remainingCapacity() const
-    -> size_t {
-        const sign_t dist = prevSegStart - offset;
-        // Account for the wrap-around.
-        return (prevSegStart <= offset) ? capacity + dist : dist;
-    }
-
-    inline auto UploadRingBuffer::previousSegmentSize() const
-    -> size_t {
-        const sign_t dist = currSegStart - prevSegStart;
-        // Account for the wrap-around.
-        return (prevSegStart <= currSegStart) ? dist : capacity + dist;
-    }
+        , capacity{0} {}
 
     inline UploadRingBuffer::UploadRingBuffer(UploadRingBuffer&& other) noexcept
         : resource{std::move(other.resource)}
         , begin{other.begin}
-        , capacity{other.capacity}
-        , offset{other.offset}
-        , prevSegStart{other.prevSegStart}
-        , currSegStart{other.currSegStart} {
+        , capacity{other.capacity} {
         // Mark as moved.
         other.resource = nullptr;
     }
@@ -151,12 +139,9 @@ namespace D3D12 {
             resource->Unmap(0, nullptr);
         }
         // Copy the data.
-        resource     = std::move(other.resource);
-        begin        = other.begin;
-        capacity     = other.capacity;
-        offset       = other.offset;
-        prevSegStart = other.prevSegStart;
-        currSegStart = other.currSegStart;
+        resource = std::move(other.resource);
+        begin    = other.begin;
+        capacity = other.capacity;
         // Mark as moved.
         other.resource = nullptr;
         return *this;
@@ -169,6 +154,20 @@ namespace D3D12 {
         }
     }
 
+    inline auto QueueFence::completedValue() const
+    -> uint64_t {
+        return fence->GetCompletedValue();
+    }
+
+    inline void QueueFence::wait(const uint64_t value) const {
+        if (fence->GetCompletedValue() < value) {
+            // Without an event handle, the call blocks until the fence reaches the value.
+            // Unlike a shared event, this is safe to do from multiple threads at once.
+            CHECK_CALL(fence->SetEventOnCompletion(value, nullptr),
+                       "Failed to wait for the fence.");
+        }
+    }
+
     template<typename T>
     inline void ResourceViewSoA<T>::allocate(const size_t count) {
         assert(!resources && !views);
@@ -188,6 +187,39 @@ namespace D3D12 {
         views[index]     = std::move(object.view);
     }
 
+    template<DescType T, size_t N>
+    inline auto DescriptorPool<T, N>::allocate()
+    -> SlotHandle {
+        const SlotHandle slot = m_slots.allocate();
+        if (slot.index == UINT32_MAX) {
+            printError("The descriptor pool of capacity %zu is full.", capacity);
+            TERMINATE();
+        }
+        return slot;
+    }
+
+    template<DescType T, size_t N>
+    inline void DescriptorPool<T, N>::free(const SlotHandle slot, const uint64_t fenceValue) {
+        m_slots.free(slot, fenceValue);
+    }
+
+    template<DescType T, size_t N>
+    inline void DescriptorPool<T, N>::reclaim(const uint64_t completedValue) {
+        m_slots.reclaim(completedValue);
+    }
+
+    template<DescType T, size_t N>
+    inline auto DescriptorPool<T, N>::isValid(const SlotHandle slot) const
+    -> bool {
+        return m_slots.isValid(slot);
+    }
+
+    template<DescType T, size_t N>
+    inline auto DescriptorPool<T, N>::size() const
+    -> size_t {
+        return m_slots.size();
+    }
+
     template<DescType T, size_t N>
     inline auto DescriptorPool<T, N>::descriptorHeap()
     -> ID3D12DescriptorHeap* {
@@ -260,6 +292,40 @@ namespace D3D12 {
         return {fence, value};
     }
 
+    template<CmdType T, size_t N, size_t L>
+    inline auto CommandContext<T, N, L>::executeCommandLists(const size_t count,
+                                                             const size_t* indices)
+    -> std::pair<ID3D12Fence*, uint64_t> {
+        assert(count <= L);
+        // Close command lists.
+        ID3D12CommandList* commandLists[L];
+        for (size_t i = 0; i < count; ++i) {
+            assert(indices[i] < L);
+            commandLists[i] = m_commandLists[indices[i]].Get();
+            CHECK_CALL(m_commandLists[indices[i]]->Close(), "Failed to close the command list.");
+        }
+        // Submit command lists for execution.
+        m_commandQueue->ExecuteCommandLists(static_cast<uint32_t>(count), commandLists);
+        // Insert a fence (with the updated value) into the command queue.
+        // Once we reach the fence in the queue, a signal will go off,
+        // which will set the internal value of the fence object to 'value'.
+        ID3D12Fence*   fence = m_fence.Get();
+        const uint64_t value = ++m_fenceValue;
+        CHECK_CALL(m_commandQueue->Signal(fence, value),
+                   "Failed to insert a fence into the command queue.");
+        return {fence, value};
+    }
+
+    template<CmdType T, size_t N, size_t L>
+    inline auto CommandContext<T, N, L>::insertFence()
+    -> std::pair<ID3D12Fence*, uint64_t> {
+        ID3D12Fence*   fence = m_fence.Get();
+        const uint64_t value = ++m_fenceValue;
+        CHECK_CALL(m_commandQueue->Signal(fence, value),
+                   "Failed to insert a fence into the command queue.");
+        return {fence, value};
+    }
+
     template<CmdType T, size_t N, size_t L>
     inline void CommandContext<T, N, L>::syncThread(const uint64_t fenceValue) {
         // fence->GetCompletedValue() returns the value of the fence reached so far.
@@ -365,6 +431,18 @@ namespace D3D12 {
         return m_commandLists[index].Get();
     }
 
+    template<CmdType T, size_t N, size_t L>
+    inline auto CommandContext<T, N, L>::fence() const
+    -> QueueFence {
+        return QueueFence{m_fence.Get()};
+    }
+
+    template<CmdType T, size_t N, size_t L>
+    inline auto CommandContext<T, N, L>::fenceValue() const
+    -> uint64_t {
+        return m_fenceValue;
+    }
+
     template<CmdType T, size_t N, size_t L>
     inline void ID3D12DeviceEx::createCommandContext(CommandContext<T, N, L>* commandContext,
                                                      const bool isHighPriority,
@@ -437,7 +515,7 @@ namespace D3D12 {
         CHECK_CALL(CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(&descriptorPool->m_heap)),
                    "Failed to create a descriptor heap.");
         // Query and store the heap properties.
-        descriptorPool->size = 0;
+        descriptorPool->m_slots    = SlotAllocator{N};
         descriptorPool->m_cpuBegin = descriptorPool->m_heap->GetCPUDescriptorHandleForHeapStart();
         descriptorPool->m_gpuBegin = descriptorPool->m_heap->GetGPUDescriptorHandleForHeapStart();
         descriptorPool->m_handleIncrSz = GetDescriptorHandleIncrementSize(heapType);
@@ -2,11 +2,16 @@
 #include <d3dcompiler.h>
 #include <d3dx12.h>
 #include <tuple>
+#include "CommandEncoder.hpp"
 #include "Renderer.hpp"
 #include "..\Common\Buffer.h"
 #include "..\Common\Camera.h"
+#include "..\Common\DrawEncoding.h"
+#include "..\Common\FrameArenas.hpp"
+#include "..\Common\IndirectDraws.hpp"
+#include "..\Common\JobSystem.h"
+#include "..\Common\MaterialRegistry.hpp"
 #include "..\Common\Math.h"
-#include "..\Common\Resources.hpp"
 #include "..\Common\Scene.h"
 #include "..\UI\Window.h"
 
@@ -64,7 +69,15 @@ static inline auto createHardwareDevice(IDXGIFactory4* factory)
 }
 
 Renderer::Renderer()
-    : m_tempAlloca{TEMP_DATA_SIZE} {
+    : m_texChainCount{0}
+    , m_gBufferListCount{1}
+    , m_materialCapacity{MAT_CNT}
+    , m_frameArenas{FRAME_CNT, JobSystem::workerCount() + 1, TEMP_DATA_SIZE}
+    , m_frames{}
+    , m_frameFence{nullptr}
+    , m_frameFenceValue{0}
+    , m_pendingCopySize{0}
+    , m_uploadStats{} {
     const uint32_t width  = Window::width();
     const uint32_t height = Window::height();
     // Configure the scissor rectangle used for clipping.
@@ -112,9 +125,12 @@ Renderer::Renderer()
     // Make sure the GPU time stamp counter does not stop ticking during idle periods.
     CHECK_CALL(m_device->SetStablePowerState(true),
                "Failed to enable the stable GPU power state.");
+    // Manage the memory of buffers and textures using large heaps.
+    m_resourceHeaps = ResourceHeapAllocator{m_device.Get(), HEAP_PAGE_SIZE};
     // Create command contexts.
     m_device->createCommandContext(&m_copyContext);
     m_device->createCommandContext(&m_graphicsContext);
+    m_frameFence = m_graphicsContext.fence().fence;
     // Create descriptor pools.
     m_device->createDescriptorPool(&m_rtvPool);
     m_device->createDescriptorPool(&m_dsvPool);
@@ -159,7 +175,7 @@ Renderer::Renderer()
         CHECK_CALL(m_swapChain->GetBuffer(i, IID_PPV_ARGS(&m_swapChainBuffers[i])),
                    "Failed to acquire a swap chain buffer.");
         m_device->CreateRenderTargetView(m_swapChainBuffers[i].Get(), &rtvDesc,
-                                         m_rtvPool.cpuHandle(m_rtvPool.size++));
+                                         m_rtvPool.cpuHandle(m_rtvPool.allocate().index));
     }
     // Configure render passes.
     configureGBufferPass();
@@ -167,11 +183,11 @@ Renderer::Renderer()
     // Set the initial command list states.
     m_copyContext.resetCommandList(0, nullptr);
     m_graphicsContext.resetCommandList(0, m_gBufferPass.pipelineState.Get());
-    m_graphicsContext.resetCommandList(1, m_shadingPass.pipelineState.Get());
+    m_graphicsContext.resetCommandList(shadingListIndex, m_shadingPass.pipelineState.Get());
     // Create the G-buffer resources.
     {
-        assert(m_dsvPool.size == 0);
-        assert(m_rtvPool.size == BUF_CNT);
+        assert(m_dsvPool.size() == 0);
+        assert(m_rtvPool.size() == BUF_CNT);
         // Create a depth buffer.
         m_gBuffer.depthBuffer   = createDepthBuffer(width, height, FORMAT_DSV);
         // Create a normal vector buffer.
@@ -183,6 +199,8 @@ Renderer::Renderer()
         // Create a material ID buffer.
         m_gBuffer.matIdBuffer   = createRenderBuffer(width, height, FORMAT_MAT_ID);
     }
+    // Describe the frame.
+    configureFrameGraph();
     // Create a persistently mapped buffer on the upload heap.
     {
         m_uploadBuffer.capacity   = UPLOAD_BUF_SIZE;
@@ -201,9 +219,12 @@ Renderer::Renderer()
         CHECK_CALL(m_uploadBuffer.resource->Map(0, &emptyReadRange,
                                                 reinterpret_cast<void**>(&m_uploadBuffer.begin)),
                    "Failed to map the upload buffer.");
+        // Manage the memory of the buffer using the copy queue fence.
+        m_uploadRing = UploadRing<QueueFence>{m_uploadBuffer.begin, m_uploadBuffer.capacity,
+                                              UPLOAD_SEG_CNT, m_copyContext.fence()};
     }
-    // Create a buffer for material indices.
-    m_materialBuffer = createStructuredBuffer(MAT_CNT * sizeof(Material));
+    // Create a buffer for material indices. It grows on demand.
+    m_materialBuffer = createStructuredBuffer(m_materialCapacity * sizeof(Material));
 }
 
 void D3D12::Renderer::configureGBufferPass() {
@@ -309,6 +330,25 @@ void D3D12::Renderer::configureGBufferPass() {
     CHECK_CALL(m_device->CreateGraphicsPipelineState(&pipelineStateDesc,
                                                      IID_PPV_ARGS(&pipelineState)),
                "Failed to create a graphics pipeline state object.");
+    // Each indirect draw sets the root constants of the material, and draws the object.
+    static_assert(sizeof(DrawIndexedArgs) == sizeof(D3D12_DRAW_INDEXED_ARGUMENTS),
+                  "The layouts of the draw arguments must match.");
+    D3D12_INDIRECT_ARGUMENT_DESC indirectArgDescs[2] = {};
+    indirectArgDescs[0].Type = D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT;
+    indirectArgDescs[0].Constant.RootParameterIndex      = 1;
+    indirectArgDescs[0].Constant.DestOffsetIn32BitValues = 0;
+    indirectArgDescs[0].Constant.Num32BitValuesToSet     = IndirectDraw::rootConstantCount;
+    indirectArgDescs[1].Type = D3D12_INDIRECT_ARGUMENT_TYPE_DRAW_INDEXED;
+    const D3D12_COMMAND_SIGNATURE_DESC commandSignatureDesc = {
+        /* ByteStride */            sizeof(IndirectDraw),
+        /* NumArgumentDescs */      _countof(indirectArgDescs),
+        /* pArgumentDescs */        indirectArgDescs,
+        /* NodeMask */              m_device->nodeMask
+    };
+    // Create a command signature for indirect draws.
+    CHECK_CALL(m_device->CreateCommandSignature(&commandSignatureDesc, rootSignature.Get(),
+                                                IID_PPV_ARGS(&m_gBufferPass.commandSignature)),
+               "Failed to create a command signature.");
 }
 
 void Renderer::configureShadingPass() {
@@ -364,6 +404,78 @@ void Renderer::configureShadingPass() {
                "Failed to create a graphics pipeline state object.");
 }
 
+void Renderer::configureFrameGraph() {
+    RenderGraph& graph = m_frameGraph.graph;
+    // The G-buffer is only used within the frame. Its resources are created in the state of
+    // their last use, and transitioned to the writable state between consecutive frames.
+    ID3D12Resource* gBufferResources[5] = {
+        m_gBuffer.depthBuffer.Get(),
+        m_gBuffer.normalBuffer.Get(),
+        m_gBuffer.uvCoordBuffer.Get(),
+        m_gBuffer.uvGradBuffer.Get(),
+        m_gBuffer.matIdBuffer.Get()
+    };
+    RenderGraph::ResourceId gBuffer[5];
+    for (size_t i = 0; i < 5; ++i) {
+        gBuffer[i] = graph.importLoopedResource();
+        m_frameGraph.resources.push_back(gBufferResources[i]);
+    }
+    // The back buffer is presented after the frame.
+    m_frameGraph.backBuffer = graph.importResource(D3D12_RESOURCE_STATE_PRESENT);
+    m_frameGraph.resources.push_back(m_swapChainBuffers[m_backBufferIndex].Get());
+    // The G-buffer pass writes the depth buffer and the render buffers.
+    m_frameGraph.gBufferPass = graph.addPass();
+    graph.write(m_frameGraph.gBufferPass, gBuffer[0], D3D12_RESOURCE_STATE_DEPTH_WRITE);
+    for (size_t i = 1; i < 5; ++i) {
+        graph.write(m_frameGraph.gBufferPass, gBuffer[i], D3D12_RESOURCE_STATE_RENDER_TARGET);
+    }
+    // The shading pass reads the G-buffer, and writes the back buffer.
+    m_frameGraph.shadingPass = graph.addPass();
+    for (size_t i = 0; i < 5; ++i) {
+        graph.read(m_frameGraph.shadingPass, gBuffer[i],
+                   D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    }
+    graph.write(m_frameGraph.shadingPass, m_frameGraph.backBuffer,
+                D3D12_RESOURCE_STATE_RENDER_TARGET);
+    graph.compile();
+    // Begin the transition of the G-buffer to the writable state before the first frame.
+    recordBarriers(m_graphicsContext.commandList(0), graph.initialBarriers());
+}
+
+void Renderer::recordBarriers(ID3D12GraphicsCommandList* graphicsCommandList,
+                              const std::vector<RenderGraph::Barrier>& barriers) const {
+    using Barrier = RenderGraph::Barrier;
+    // Translate the barriers, and submit them in batches.
+    D3D12_RESOURCE_BARRIER d3dBarriers[16];
+    uint32_t               count = 0;
+    for (const Barrier& barrier : barriers) {
+        ID3D12Resource* resource = m_frameGraph.resources[barrier.resource];
+        if (Barrier::Type::ALIASING == barrier.type) {
+            d3dBarriers[count++] = D3D12_ALIASING_BARRIER{nullptr, resource};
+        } else {
+            D3D12_RESOURCE_BARRIER_FLAGS flag = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+            if (Barrier::Split::BEGIN == barrier.split) {
+                flag = D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY;
+            } else if (Barrier::Split::END == barrier.split) {
+                flag = D3D12_RESOURCE_BARRIER_FLAG_END_ONLY;
+            }
+            d3dBarriers[count++] = D3D12_TRANSITION_BARRIER{
+                resource,
+                static_cast<D3D12_RESOURCE_STATES>(barrier.before),
+                static_cast<D3D12_RESOURCE_STATES>(barrier.after),
+                flag
+            };
+        }
+        if (16 == count) {
+            graphicsCommandList->ResourceBarrier(count, d3dBarriers);
+            count = 0;
+        }
+    }
+    if (count > 0) {
+        graphicsCommandList->ResourceBarrier(count, d3dBarriers);
+    }
+}
+
 ComPtr<ID3D12Resource> Renderer::createDepthBuffer(const uint32_t width, const uint32_t height,
                                                    const DXGI_FORMAT format) {
     const D3D12_RESOURCE_DESC resourceDesc = {
@@ -384,9 +496,11 @@ ComPtr<ID3D12Resource> Renderer::createDepthBuffer(const uint32_t width, const u
     };
     ComPtr<ID3D12Resource> depthStencilBuffer;
     // Allocate the depth buffer on the default heap.
+    // It is created in the state of its last use within the frame.
     const CD3DX12_HEAP_PROPERTIES heapProperties{D3D12_HEAP_TYPE_DEFAULT};
     CHECK_CALL(m_device->CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE,
-                                                 &resourceDesc, D3D12_RESOURCE_STATE_DEPTH_WRITE,
+                                                 &resourceDesc,
+                                                 D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
                                                  &clearValue, IID_PPV_ARGS(&depthStencilBuffer)),
                "Failed to allocate a depth buffer.");
     // Initialize the depth-stencil view.
@@ -397,11 +511,11 @@ ComPtr<ID3D12Resource> Renderer::createDepthBuffer(const uint32_t width, const u
         /* MipSlice */         0
     };
     m_device->CreateDepthStencilView(depthStencilBuffer.Get(), &dsvDesc,
-                                     m_dsvPool.cpuHandle(m_dsvPool.size++));
+                                     m_dsvPool.cpuHandle(m_dsvPool.allocate().index));
     // Initialize the shader resource view.
     const D3D12_TEX2D_SRV_DESC srvDesc{getDepthSrvFormat(format), 1};
     m_device->CreateShaderResourceView(depthStencilBuffer.Get(), &srvDesc,
-                                       m_texPool.cpuHandle(m_texPool.size++));
+                                       m_texPool.cpuHandle(m_texPool.allocate().index));
     return depthStencilBuffer;
 }
 
@@ -425,9 +539,11 @@ ComPtr<ID3D12Resource> Renderer::createRenderBuffer(const uint32_t width, const
     };
     ComPtr<ID3D12Resource> renderBuffer;
     // Allocate the render buffer on the default heap.
+    // It is created in the state of its last use within the frame.
     const auto heapProperties = CD3DX12_HEAP_PROPERTIES{D3D12_HEAP_TYPE_DEFAULT};
     CHECK_CALL(m_device->CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE,
-                                                 &resourceDesc, D3D12_RESOURCE_STATE_RENDER_TARGET,
+                                                 &resourceDesc,
+                                                 D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
                                                  &clearValue, IID_PPV_ARGS(&renderBuffer)),
                "Failed to allocate a render target.");
     // Initialize the render target view.
@@ -438,16 +554,16 @@ ComPtr<ID3D12Resource> Renderer::createRenderBuffer(const uint32_t width, const
         /* PlaneSlice */       0
     };
     m_device->CreateRenderTargetView(renderBuffer.Get(), &rtvDesc,
-                                     m_rtvPool.cpuHandle(m_rtvPool.size++));
+                                     m_rtvPool.cpuHandle(m_rtvPool.allocate().index));
     // Initialize the shader resource view.
     const D3D12_TEX2D_SRV_DESC srvDesc{format, 1};
     m_device->CreateShaderResourceView(renderBuffer.Get(), &srvDesc,
-                                       m_texPool.cpuHandle(m_texPool.size++));
+                                       m_texPool.cpuHandle(m_texPool.allocate().index));
     return renderBuffer;
 }
 
-Texture Renderer::createTexture2D(const D3D12_SUBRESOURCE_FOOTPRINT& footprint,
-                                  const uint32_t mipCount, const void* data) {
+Texture Renderer::createTexture(const D3D12_SUBRESOURCE_FOOTPRINT& footprint,
+                                const uint32_t mipCount) {
     const D3D12_RESOURCE_DESC resourceDesc = {
         /* Dimension */        D3D12_RESOURCE_DIMENSION_TEXTURE2D,
         /* Alignment */        0,   // Automatic
@@ -460,74 +576,225 @@ Texture Renderer::createTexture2D(const D3D12_SUBRESOURCE_FOOTPRINT& footprint,
         /* Layout */           D3D12_TEXTURE_LAYOUT_UNKNOWN,
         /* Flags */            D3D12_RESOURCE_FLAG_NONE
     };
-    const CD3DX12_CLEAR_VALUE clearValue = {
-        /* Format */           footprint.Format,
-        /* Color */            FLOAT4_ZERO
-    };
     Texture texture;
-    // Allocate the texture on the default heap.
-    const auto heapProperties = CD3DX12_HEAP_PROPERTIES{D3D12_HEAP_TYPE_DEFAULT};
-    CHECK_CALL(m_device->CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE,
-                                                 &resourceDesc, D3D12_RESOURCE_STATE_COMMON,
-                                                 nullptr, IID_PPV_ARGS(&texture.resource)),
-               "Failed to allocate a texture.");
+    // Place the texture within the resource heaps.
+    texture.resource = createResource(resourceDesc, D3D12_RESOURCE_STATE_COMMON,
+                                      &texture.memory);
     // Transition the state of the texture for the graphics/compute command queue type class.
     const D3D12_TRANSITION_BARRIER barrier{texture.resource.Get(),
                                            D3D12_RESOURCE_STATE_COMMON,
                                            D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE};
-    m_graphicsContext.commandList(0)->ResourceBarrier(1, &barrier);
-    if (data) {
-        assert(0 == footprint.RowPitch % D3D12_TEXTURE_DATA_PITCH_ALIGNMENT);
-        // Upload MIP levels one by one.
-        for (size_t i = 0; i < mipCount; ++i) {
-            const uint32_t width     = std::max(1u, footprint.Width >> i);
-            const uint32_t height    = std::max(1u, footprint.Height >> i);
-            const size_t   dataPitch = std::max(1u, footprint.RowPitch >> i);
-            const size_t   rowPitch  = align<D3D12_TEXTURE_DATA_PITCH_ALIGNMENT>(dataPitch);
-            const size_t   size      = rowPitch * height;
-            // Linear subresource copying must be aligned to 512 bytes.
-            constexpr size_t alignment = D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT;
-            size_t offset;
-            // Check whether pitched copying is required.
-            if (dataPitch == rowPitch) {
-                // Copy the entire MIP level at once.
-                offset = copyToUploadBuffer<alignment>(size, data);
-                // Advance the data pointer to the next MIP level.
-                data = static_cast<const byte_t*>(data) + size;
-            } else {
-                // Reserve a chunk of memory for the entire MIP level.
-                byte_t* address;
-                std::tie(address, offset) = reserveChunkOfUploadBuffer<alignment>(size);
-                // Copy the MIP level one row at a time.
-                for (size_t row = 0; row < height; ++row) {
-                    memcpy(address, data, dataPitch);
-                    address += rowPitch;
-                    data     = static_cast<const byte_t*>(data) + dataPitch;
-                }
-            }
-            // Copy the data from the upload buffer into the video memory texture.
-            const D3D12_PLACED_SUBRESOURCE_FOOTPRINT levelFootprint = {
-                /* Offset */   offset,
-                /* Format */   footprint.Format,
-                /* Width */    width,
-                /* Height */   height,
-                /* Depth */    footprint.Depth,
-                /* RowPitch */ static_cast<uint32_t>(rowPitch)
-            };
-            const uint32_t subResId = static_cast<uint32_t>(i);
-            const CD3DX12_TEXTURE_COPY_LOCATION src{m_uploadBuffer.resource.Get(), levelFootprint};
-            const CD3DX12_TEXTURE_COPY_LOCATION dst{texture.resource.Get(), subResId};
-            m_copyContext.commandList(0)->CopyTextureRegion(&dst, 0, 0, 0, &src, nullptr);
-        }
+    {
+        std::lock_guard<std::mutex> lock{m_initListMutex};
+        m_graphicsContext.commandList(0)->ResourceBarrier(1, &barrier);
     }
     // Initialize the shader resource view.
+    {
+        std::lock_guard<std::mutex> lock{m_heapMutex};
+        // Recycle the slots of the textures no longer used by the GPU.
+        releaseRetiredResources();
+        texture.slot = m_texPool.allocate();
+    }
     const D3D12_TEX2D_SRV_DESC srvDesc{footprint.Format, mipCount};
-    texture.view = m_texPool.gpuHandle(m_texPool.size);
+    texture.view = m_texPool.gpuHandle(texture.slot.index);
     m_device->CreateShaderResourceView(texture.resource.Get(), &srvDesc,
-                                       m_texPool.cpuHandle(m_texPool.size++));
+                                       m_texPool.cpuHandle(texture.slot.index));
+    return texture;
+}
+
+size_t Renderer::computeUploadLayouts(const D3D12_SUBRESOURCE_FOOTPRINT& footprint,
+                                      const uint32_t mipCount,
+                                      D3D12_PLACED_SUBRESOURCE_FOOTPRINT* layouts,
+                                      uint32_t* rowCounts) const {
+    assert(mipCount > 0 && mipCount <= D3D12_REQ_MIP_LEVELS);
+    const D3D12_RESOURCE_DESC resourceDesc = {
+        /* Dimension */        D3D12_RESOURCE_DIMENSION_TEXTURE2D,
+        /* Alignment */        0,   // Automatic
+        /* Width */            footprint.Width,
+        /* Height */           footprint.Height,
+        /* DepthOrArraySize */ static_cast<uint16_t>(footprint.Depth),
+        /* MipLevels */        static_cast<uint16_t>(mipCount),
+        /* Format */           footprint.Format,
+        /* SampleDesc */       SINGLE_SAMPLE,
+        /* Layout */           D3D12_TEXTURE_LAYOUT_UNKNOWN,
+        /* Flags */            D3D12_RESOURCE_FLAG_NONE
+    };
+    m_device->GetCopyableFootprints(&resourceDesc, 0, mipCount, 0, layouts, rowCounts,
+                                    nullptr, nullptr);
+    // The copy does not require padding after the last row, but the row pitch is kept,
+    // so that the MIP chain can be written row by row using the same pitch.
+    const D3D12_PLACED_SUBRESOURCE_FOOTPRINT& last = layouts[mipCount - 1];
+    return static_cast<size_t>(last.Offset) +
+           static_cast<size_t>(last.Footprint.RowPitch) * rowCounts[mipCount - 1];
+}
+
+TextureUpload Renderer::reserveTextureUpload(const D3D12_SUBRESOURCE_FOOTPRINT& footprint,
+                                             const uint32_t mipCount) {
+    D3D12_PLACED_SUBRESOURCE_FOOTPRINT layouts[D3D12_REQ_MIP_LEVELS];
+    uint32_t                           rowCounts[D3D12_REQ_MIP_LEVELS];
+    TextureUpload upload;
+    upload.footprint = footprint;
+    upload.mipCount  = mipCount;
+    upload.size      = computeUploadLayouts(footprint, mipCount, layouts, rowCounts);
+    upload.chunk     = UploadAllocation{};
+    if (upload.size > static_cast<size_t>(TEX_CHAIN_SIZE)) {
+        // The MIP chain would occupy too much of the upload buffer.
+        return upload;
+    }
+    // The reservation is held while the MIP chain is written, which prevents the segment
+    // from being retired. Limit the number of such reservations, so that other threads
+    // do not run out of space.
+    {
+        std::unique_lock<std::mutex> lock{m_texChainMutex};
+        m_texChainCond.wait(lock, [this]() {
+            return m_texChainCount < static_cast<size_t>(TEX_CHAIN_CNT);
+        });
+        m_texChainCount++;
+    }
+    // Linear subresource copying must be aligned to 512 bytes.
+    constexpr size_t alignment = D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT;
+    // Reserve a chunk of memory for the entire MIP chain.
+    upload.chunk = reserveChunkOfUploadBuffer<alignment>(upload.size);
+    return upload;
+}
+
+Texture Renderer::createTexture2D(const TextureUpload& upload) {
+    assert(upload.chunk.address);
+    D3D12_PLACED_SUBRESOURCE_FOOTPRINT layouts[D3D12_REQ_MIP_LEVELS];
+    uint32_t                           rowCounts[D3D12_REQ_MIP_LEVELS];
+    computeUploadLayouts(upload.footprint, upload.mipCount, layouts, rowCounts);
+    Texture texture = createTexture(upload.footprint, upload.mipCount);
+    // Copy the data from the upload buffer into the video memory texture.
+    {
+        std::lock_guard<std::mutex> lock{m_copyMutex};
+        for (uint32_t i = 0; i < upload.mipCount; ++i) {
+            D3D12_PLACED_SUBRESOURCE_FOOTPRINT levelFootprint = layouts[i];
+            levelFootprint.Offset += upload.chunk.offset;
+            const CD3DX12_TEXTURE_COPY_LOCATION src{m_uploadBuffer.resource.Get(),
+                                                    levelFootprint};
+            const CD3DX12_TEXTURE_COPY_LOCATION dst{texture.resource.Get(), i};
+            m_copyContext.commandList(0)->CopyTextureRegion(&dst, 0, 0, 0, &src, nullptr);
+        }
+        commitChunkOfUploadBuffer(upload.chunk, upload.size);
+    }
+    // End the reservation.
+    {
+        std::lock_guard<std::mutex> lock{m_texChainMutex};
+        m_texChainCount--;
+    }
+    m_texChainCond.notify_one();
+    return texture;
+}
+
+Texture Renderer::createTexture2D(const D3D12_SUBRESOURCE_FOOTPRINT& footprint,
+                                  const uint32_t mipCount, const void* data) {
+    if (!data) {
+        return createTexture(footprint, mipCount);
+    }
+    assert(0 == footprint.RowPitch % D3D12_TEXTURE_DATA_PITCH_ALIGNMENT);
+    D3D12_PLACED_SUBRESOURCE_FOOTPRINT layouts[D3D12_REQ_MIP_LEVELS];
+    uint32_t                           rowCounts[D3D12_REQ_MIP_LEVELS];
+    computeUploadLayouts(footprint, mipCount, layouts, rowCounts);
+    const TextureUpload upload = reserveTextureUpload(footprint, mipCount);
+    if (!upload.chunk.address) {
+        return createTexture2DByLevel(footprint, mipCount, data);
+    }
+    // Copy MIP levels one by one, converting the row pitch if necessary.
+    // The reservation is held, so the copy must not execute unrelated jobs.
+    for (size_t i = 0; i < mipCount; ++i) {
+        const size_t dataPitch = std::max(1u, footprint.RowPitch >> i);
+        const size_t rowPitch  = layouts[i].Footprint.RowPitch;
+        const size_t rowSize   = std::min(dataPitch, rowPitch);
+        const size_t rowCount  = rowCounts[i];
+        isolatedStreamCopyRows(upload.chunk.address + layouts[i].Offset, rowPitch,
+                               data, dataPitch, rowSize, rowCount);
+        // Advance the data pointer to the next MIP level.
+        data = static_cast<const byte_t*>(data) + dataPitch * rowCount;
+    }
+    return createTexture2D(upload);
+}
+
+Texture Renderer::createTexture2DByLevel(const D3D12_SUBRESOURCE_FOOTPRINT& footprint,
+                                         const uint32_t mipCount, const void* data) {
+    D3D12_PLACED_SUBRESOURCE_FOOTPRINT layouts[D3D12_REQ_MIP_LEVELS];
+    uint32_t                           rowCounts[D3D12_REQ_MIP_LEVELS];
+    computeUploadLayouts(footprint, mipCount, layouts, rowCounts);
+    Texture texture = createTexture(footprint, mipCount);
+    // Linear subresource copying must be aligned to 512 bytes.
+    constexpr size_t alignment = D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT;
+    // Upload MIP levels one by one.
+    for (uint32_t i = 0; i < mipCount; ++i) {
+        // Rows are copied as rows of texels, so block compression is not supported.
+        assert(layouts[i].Footprint.Height == rowCounts[i]);
+        const size_t dataPitch = std::max(1u, footprint.RowPitch >> i);
+        const size_t rowPitch  = layouts[i].Footprint.RowPitch;
+        const size_t rowSize   = std::min(dataPitch, rowPitch);
+        const size_t rowCount  = rowCounts[i];
+        // Split large MIP levels into batches of rows.
+        const size_t maxSize   = static_cast<size_t>(TEX_CHAIN_SIZE);
+        const size_t batchSize = std::max(size_t{1}, maxSize / rowPitch);
+        for (size_t row = 0; row < rowCount; row += batchSize) {
+            const size_t count = std::min(batchSize, rowCount - row);
+            const size_t size  = rowPitch * count;
+            // Reserve a chunk of memory for the batch of rows.
+            const UploadAllocation chunk = reserveChunkOfUploadBuffer<alignment>(size);
+            // Copy the rows, converting the row pitch if necessary.
+            // The chunk is reserved, so the copy must not execute unrelated jobs.
+            isolatedStreamCopyRows(chunk.address, rowPitch,
+                                   static_cast<const byte_t*>(data) + dataPitch * row,
+                                   dataPitch, rowSize, count);
+            // Copy the data from the upload buffer into the video memory texture.
+            D3D12_PLACED_SUBRESOURCE_FOOTPRINT batchFootprint = layouts[i];
+            batchFootprint.Offset           = chunk.offset;
+            batchFootprint.Footprint.Height = static_cast<uint32_t>(count);
+            const CD3DX12_TEXTURE_COPY_LOCATION src{m_uploadBuffer.resource.Get(),
+                                                    batchFootprint};
+            const CD3DX12_TEXTURE_COPY_LOCATION dst{texture.resource.Get(), i};
+            std::lock_guard<std::mutex> lock{m_copyMutex};
+            m_copyContext.commandList(0)->CopyTextureRegion(&dst, 0,
+                                                            static_cast<uint32_t>(row), 0,
+                                                            &src, nullptr);
+            commitChunkOfUploadBuffer(chunk, size);
+        }
+        // Advance the data pointer to the next MIP level.
+        data = static_cast<const byte_t*>(data) + dataPitch * rowCount;
+    }
     return texture;
 }
 
+void Renderer::destroyTexture(Texture&& texture) {
+    std::lock_guard<std::mutex> lock{m_heapMutex};
+    if (!m_texPool.isValid(texture.slot)) {
+        printError("Attempted to destroy a stale texture (slot %u, generation %u).",
+                   texture.slot.index, texture.slot.generation);
+        TERMINATE();
+    }
+    // The frame being recorded (if any) is the last one which may use the texture.
+    m_texPool.free(texture.slot, m_frameFenceValue + 1);
+    retireResource(std::move(texture.resource), texture.memory);
+    releaseRetiredResources();
+}
+
+void Renderer::retireResource(ComPtr<ID3D12Resource>&& resource, const HeapAllocation& memory) {
+    // The frames are submitted concurrently, so the fence value of the graphics queue
+    // is read from the atomic copy. If the frame is being submitted right now,
+    // it is the last submission which may use the resource.
+    const uint64_t fenceValue = m_frameFenceValue + 1;
+    m_retiredResources.push_back(RetiredResource{std::move(resource), memory, fenceValue});
+}
+
+void Renderer::releaseRetiredResources() {
+    const uint64_t completedValue = m_graphicsContext.fence().completedValue();
+    m_texPool.reclaim(completedValue);
+    while (!m_retiredResources.empty() &&
+           m_retiredResources.front().fenceValue <= completedValue) {
+        // Release the resource before its memory is reused.
+        m_retiredResources.front().resource.Reset();
+        m_resourceHeaps.free(m_retiredResources.front().memory);
+        m_retiredResources.pop_front();
+    }
+}
+
 size_t Renderer::getTextureIndex(const Texture& texture) const {
     return m_texPool.computeIndex(texture.view);
 }
@@ -535,13 +802,9 @@ size_t Renderer::getTextureIndex(const Texture& texture) const {
 ConstantBuffer Renderer::createConstantBuffer(const size_t size, const void* data) {
     assert(!data || size >= 4);
     ConstantBuffer buffer;
-    // Allocate the buffer on the default heap.
-    const auto heapProperties = CD3DX12_HEAP_PROPERTIES{D3D12_HEAP_TYPE_DEFAULT};
-    const auto resourceDesc   = CD3DX12_RESOURCE_DESC::Buffer(size);
-    CHECK_CALL(m_device->CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE,
-                                                 &resourceDesc, D3D12_RESOURCE_STATE_COMMON,
-                                                 nullptr, IID_PPV_ARGS(&buffer.resource)),
-               "Failed to allocate a constant buffer.");
+    // Place the buffer within the resource heaps.
+    const auto resourceDesc = CD3DX12_RESOURCE_DESC::Buffer(size);
+    buffer.resource = createResource(resourceDesc, D3D12_RESOURCE_STATE_COMMON, &buffer.memory);
     // Transition the state of the buffer for the graphics/compute command queue type class.
     const D3D12_TRANSITION_BARRIER barrier{buffer.resource.Get(),
                                            D3D12_RESOURCE_STATE_COMMON,
@@ -550,11 +813,13 @@ ConstantBuffer Renderer::createConstantBuffer(const size_t size, const void* dat
     if (data) {
         // Linear subresource copying must be aligned to 512 bytes.
         constexpr size_t alignment = D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT;
-        const     size_t offset    = copyToUploadBuffer<alignment>(size, data);
+        const     auto   chunk     = copyToUploadBuffer<alignment>(size, data);
         // Copy the data from the upload buffer into the video memory buffer.
+        std::lock_guard<std::mutex> lock{m_copyMutex};
         m_copyContext.commandList(0)->CopyBufferRegion(buffer.resource.Get(), 0,
-                                                       m_uploadBuffer.resource.Get(), offset,
-                                                       size);
+                                                       m_uploadBuffer.resource.Get(),
+                                                       chunk.offset, size);
+        commitChunkOfUploadBuffer(chunk, size);
     }
     // Initialize the constant buffer view.
     buffer.view = buffer.resource->GetGPUVirtualAddress();
@@ -564,13 +829,9 @@ ConstantBuffer Renderer::createConstantBuffer(const size_t size, const void* dat
 StructuredBuffer Renderer::createStructuredBuffer(const size_t size, const void* data) {
     assert(!data || size >= 4);
     StructuredBuffer buffer;
-    // Allocate the buffer on the default heap.
-    const auto heapProperties = CD3DX12_HEAP_PROPERTIES{D3D12_HEAP_TYPE_DEFAULT};
-    const auto resourceDesc   = CD3DX12_RESOURCE_DESC::Buffer(size);
-    CHECK_CALL(m_device->CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE,
-                                                 &resourceDesc, D3D12_RESOURCE_STATE_COMMON,
-                                                 nullptr, IID_PPV_ARGS(&buffer.resource)),
-               "Failed to allocate a structured buffer.");
+    // Place the buffer within the resource heaps.
+    const auto resourceDesc = CD3DX12_RESOURCE_DESC::Buffer(size);
+    buffer.resource = createResource(resourceDesc, D3D12_RESOURCE_STATE_COMMON, &buffer.memory);
     // Transition the state of the buffer for the graphics/compute command queue type class.
     const D3D12_TRANSITION_BARRIER barrier{buffer.resource.Get(),
                                            D3D12_RESOURCE_STATE_COMMON,
@@ -579,11 +840,13 @@ StructuredBuffer Renderer::createStructuredBuffer(const size_t size, const void*
     if (data) {
         // Linear subresource copying must be aligned to 512 bytes.
         constexpr size_t alignment = D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT;
-        const     size_t offset    = copyToUploadBuffer<alignment>(size, data);
+        const     auto   chunk     = copyToUploadBuffer<alignment>(size, data);
         // Copy the data from the upload buffer into the video memory buffer.
+        std::lock_guard<std::mutex> lock{m_copyMutex};
         m_copyContext.commandList(0)->CopyBufferRegion(buffer.resource.Get(), 0,
-                                                       m_uploadBuffer.resource.Get(), offset,
-                                                       size);
+                                                       m_uploadBuffer.resource.Get(),
+                                                       chunk.offset, size);
+        commitChunkOfUploadBuffer(chunk, size);
     }
     // Initialize the shader resource view.
     buffer.view = buffer.resource->GetGPUVirtualAddress();
@@ -594,13 +857,9 @@ IndexBuffer Renderer::createIndexBuffer(const size_t count, const uint32_t* indi
     assert(indices && count >= 3);
     const size_t size = count * sizeof(uint32_t);
     IndexBuffer buffer;
-    // Allocate the buffer on the default heap.
-    const auto heapProperties = CD3DX12_HEAP_PROPERTIES{D3D12_HEAP_TYPE_DEFAULT};
-    const auto resourceDesc   = CD3DX12_RESOURCE_DESC::Buffer(size);
-    CHECK_CALL(m_device->CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE,
-                                                 &resourceDesc, D3D12_RESOURCE_STATE_COMMON,
-                                                 nullptr, IID_PPV_ARGS(&buffer.resource)),
-               "Failed to allocate an index buffer.");
+    // Place the buffer within the resource heaps.
+    const auto resourceDesc = CD3DX12_RESOURCE_DESC::Buffer(size);
+    buffer.resource = createResource(resourceDesc, D3D12_RESOURCE_STATE_COMMON, &buffer.memory);
     // Transition the state of the buffer for the graphics/compute command queue type class.
     const D3D12_TRANSITION_BARRIER barrier{buffer.resource.Get(),
                                            D3D12_RESOURCE_STATE_COMMON,
@@ -608,11 +867,15 @@ IndexBuffer Renderer::createIndexBuffer(const size_t count, const uint32_t* indi
     m_graphicsContext.commandList(0)->ResourceBarrier(1, &barrier);
     // Linear subresource copying must be aligned to 512 bytes.
     constexpr size_t alignment = D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT;
-    const     size_t offset    = copyToUploadBuffer<alignment>(size, indices);
+    const     auto   chunk     = copyToUploadBuffer<alignment>(size, indices);
     // Copy the data from the upload buffer into the video memory buffer.
-    m_copyContext.commandList(0)->CopyBufferRegion(buffer.resource.Get(), 0,
-                                                   m_uploadBuffer.resource.Get(), offset,
-                                                   size);
+    {
+        std::lock_guard<std::mutex> lock{m_copyMutex};
+        m_copyContext.commandList(0)->CopyBufferRegion(buffer.resource.Get(), 0,
+                                                       m_uploadBuffer.resource.Get(),
+                                                       chunk.offset, size);
+        commitChunkOfUploadBuffer(chunk, size);
+    }
     // Initialize the index buffer view.
     buffer.view.BufferLocation = buffer.resource->GetGPUVirtualAddress(),
     buffer.view.SizeInBytes    = static_cast<uint32_t>(size);
@@ -620,196 +883,244 @@ IndexBuffer Renderer::createIndexBuffer(const size_t count, const uint32_t* indi
     return buffer;
 }
 
-void Renderer::setMaterials(const size_t count, const Material* materials) {
-    assert(count <= MAT_CNT);
+void Renderer::updateMaterials(MaterialRegistry* materials) {
+    assert(materials);
+    const size_t count = materials->size();
+    if (count > m_materialCapacity) {
+        // Grow the buffer geometrically.
+        size_t capacity = m_materialCapacity;
+        while (capacity < count) capacity *= 2;
+        capacity = std::min(capacity, size_t{MaterialRegistry::maxSize});
+        StructuredBuffer buffer = createStructuredBuffer(capacity * sizeof(Material));
+        {
+            // The frame being recorded (if any) may still use the old buffer.
+            std::lock_guard<std::mutex> lock{m_heapMutex};
+            retireResource(std::move(m_materialBuffer.resource), m_materialBuffer.memory);
+        }
+        m_materialBuffer   = std::move(buffer);
+        m_materialCapacity = capacity;
+        // Upload all materials.
+        uploadMaterials(*materials, 0, count);
+        materials->clearChanges();
+    } else {
+        // Only upload the materials which have changed.
+        materials->flushChanges([this, materials](size_t first, size_t rangeCount) {
+            uploadMaterials(*materials, first, rangeCount);
+        });
+    }
+}
+
+void Renderer::uploadMaterials(const MaterialRegistry& materials, const size_t first,
+                               const size_t count) {
     // Linear subresource copying must be aligned to 512 bytes.
     constexpr size_t alignment = D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT;
     const     size_t size      = count * sizeof(Material);
-    const     size_t offset    = copyToUploadBuffer<alignment>(size, materials);
+    const     auto   chunk     = copyToUploadBuffer<alignment>(size, materials.data() + first);
     // Copy the data from the upload buffer into the video memory buffer.
-    m_copyContext.commandList(0)->CopyBufferRegion(m_materialBuffer.resource.Get(), 0,
-                                                   m_uploadBuffer.resource.Get(), offset, size);
+    std::lock_guard<std::mutex> lock{m_copyMutex};
+    m_copyContext.commandList(0)->CopyBufferRegion(m_materialBuffer.resource.Get(),
+                                                   first * sizeof(Material),
+                                                   m_uploadBuffer.resource.Get(),
+                                                   chunk.offset, size);
+    commitChunkOfUploadBuffer(chunk, size);
+}
+
+void Renderer::commitChunkOfUploadBuffer(const UploadAllocation& chunk, const size_t size) {
+    // The chunk is in use until the next submission of the copy queue completes.
+    m_uploadRing.commit(chunk, m_copyContext.fenceValue() + 1);
+    m_pendingCopySize += size;
+    if (m_pendingCopySize >= COPY_BATCH_SIZE) {
+        submitCopyCommands();
+    }
+}
+
+void D3D12::Renderer::executeCopyCommands() {
+    std::lock_guard<std::mutex> lock{m_copyMutex};
+    submitCopyCommands();
+}
+
+const UploadStats& Renderer::getUploadStats() const {
+    return m_uploadStats;
+}
+
+TlsfAllocator::Stats Renderer::getHeapStats() const {
+    return m_resourceHeaps.computeStats();
+}
+
+ComPtr<ID3D12Resource> Renderer::createResource(const D3D12_RESOURCE_DESC& resourceDesc,
+                                                const D3D12_RESOURCE_STATES initialState,
+                                                HeapAllocation* allocation) {
+    std::lock_guard<std::mutex> lock{m_heapMutex};
+    return m_resourceHeaps.createResource(resourceDesc, initialState, allocation);
 }
 
-void D3D12::Renderer::executeCopyCommands(const bool immediateCopy) {
+void Renderer::submitCopyCommands() {
+    // The graphics queue reads the indirect arguments straight from the upload buffer.
+    // Make sure the frames which could have used the segment have completed before it is reused.
+    const uint64_t frameFenceValue = m_frameFenceValue;
+    if (frameFenceValue > 0) {
+        m_copyContext.syncCommandQueue(m_frameFence, frameFenceValue);
+    }
     // Finalize and execute the command list.
     ID3D12Fence* insertedFence;
     uint64_t     insertedValue;
     std::tie(insertedFence, insertedValue) = m_copyContext.executeCommandList(0);
     // Ensure synchronization between the graphics and the copy command queues.
     m_graphicsContext.syncCommandQueue(insertedFence, insertedValue);
-    if (immediateCopy) {
-        printWarning("Immediate copy requested. Thread stall imminent.");
-        m_copyContext.syncThread(insertedValue);
-    } else {
-        // For single- and double-buffered copy contexts, resetCommandAllocator() will
-        // take care of waiting until the previous copy command list has completed execution.
-        static_assert(decltype(m_copyContext)::bufferCount <= 2,
-                      "Unsupported copy context buffering mode.");
-    }
-    // Reset the command list allocator.
+    // Reset the command list allocator. Since the allocators are N-buffered,
+    // resetCommandAllocators() only blocks if the batch which has used the same allocator
+    // (N batches before the next one) has not completed execution yet.
+    constexpr uint64_t batchCount = decltype(m_copyContext)::bufferCount;
+    const bool isStalled = insertedValue >= batchCount &&
+                           m_copyContext.fence().completedValue() + batchCount <= insertedValue;
+    Stopwatch stopwatch;
     m_copyContext.resetCommandAllocators();
+    if (isStalled) {
+        m_uploadStats.stallCount++;
+        m_uploadStats.stallTime += stopwatch.lap();
+    }
+    m_uploadStats.uploadedSize += m_pendingCopySize;
+    m_uploadStats.batchCount++;
+    m_pendingCopySize = 0;
     // Reset the command list to its initial state.
     m_copyContext.resetCommandList(0, nullptr);
     // Begin a new segment of the upload buffer.
-    m_uploadBuffer.prevSegStart = immediateCopy ? m_uploadBuffer.offset
-                                                : m_uploadBuffer.currSegStart;
-    m_uploadBuffer.currSegStart = m_uploadBuffer.offset;
-}
-
-void Renderer::GBuffer::setWriteBarriers(D3D12_RESOURCE_BARRIER* barriers,                          
-                                         const D3D12_RESOURCE_BARRIER_FLAGS flag) {
-    barriers[0] = D3D12_TRANSITION_BARRIER{depthBuffer.Get(),
-                                           D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
-                                           D3D12_RESOURCE_STATE_DEPTH_WRITE,   flag};
-    barriers[1] = D3D12_TRANSITION_BARRIER{normalBuffer.Get(),
-                                           D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
-                                           D3D12_RESOURCE_STATE_RENDER_TARGET, flag};
-    barriers[2] = D3D12_TRANSITION_BARRIER{uvCoordBuffer.Get(),
-                                           D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
-                                           D3D12_RESOURCE_STATE_RENDER_TARGET, flag};
-    barriers[3] = D3D12_TRANSITION_BARRIER{uvGradBuffer.Get(),
-                                           D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
-                                           D3D12_RESOURCE_STATE_RENDER_TARGET, flag};
-    barriers[4] = D3D12_TRANSITION_BARRIER{matIdBuffer.Get(),
-                                           D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
-                                           D3D12_RESOURCE_STATE_RENDER_TARGET, flag};
-}
-
-void Renderer::GBuffer::setReadBarriers(D3D12_RESOURCE_BARRIER* barriers,                          
-                                        const D3D12_RESOURCE_BARRIER_FLAGS flag) {
-    barriers[0] = D3D12_TRANSITION_BARRIER{depthBuffer.Get(),
-                                           D3D12_RESOURCE_STATE_DEPTH_WRITE,
-                                           D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, flag};
-    barriers[1] = D3D12_TRANSITION_BARRIER{normalBuffer.Get(),
-                                           D3D12_RESOURCE_STATE_RENDER_TARGET,
-                                           D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, flag};
-    barriers[2] = D3D12_TRANSITION_BARRIER{uvCoordBuffer.Get(),
-                                           D3D12_RESOURCE_STATE_RENDER_TARGET,
-                                           D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, flag};
-    barriers[3] = D3D12_TRANSITION_BARRIER{uvGradBuffer.Get(),
-                                           D3D12_RESOURCE_STATE_RENDER_TARGET,
-                                           D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, flag};
-    barriers[4] = D3D12_TRANSITION_BARRIER{matIdBuffer.Get(),
-                                           D3D12_RESOURCE_STATE_RENDER_TARGET,
-                                           D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, flag};
-}
-
-union ObjectSortKey {
-    float   depth;   // Always positive, therefore 'integer' is always positive
-    int32_t integer; // Used for sorting, slightly faster than using floating point values
-};
-
-struct ObjectSortPair {
-    bool operator<(const ObjectSortPair& other) const {
-        return key.integer < other.key.integer;
-    }
-public:
-    ObjectSortKey key;
-    uint32_t      index;
-};
-
-void Renderer::recordGBufferPass(const PerspectiveCamera& pCam, const Scene& scene) {
-    const size_t n = scene.objects.count;
+    m_uploadRing.closeSegment(insertedValue);
+}
+
+void Renderer::cullObjects(const size_t frameIndex, const PerspectiveCamera& pCam,
+                           const Scene& scene) {
+    FrameData&   frame = m_frames[frameIndex % FRAME_CNT];
+    const size_t n     = scene.objects.count;
+    // The memory of the frame which has previously used the slot can now be reused.
+    m_frameArenas.beginFrame(frameIndex);
     // Allocate memory for depth sorting.
-    void* buffer = m_tempAlloca.allocate<16>(n * sizeof(ObjectSortPair));
+    void* buffer = m_frameArenas.allocate<16>(frameIndex, n * sizeof(ObjectSortPair));
     ObjectSortPair* objSortPairs = static_cast<ObjectSortPair*>(buffer);
-    // Compute the viewing frustum.
-    Frustum frustum = pCam.computeViewFrustum();
-    // Perform frustum culling.
-    size_t visObjCount = 0;
-    for (size_t i = 0; i < n; ++i) {
-        // Test the object for visibility.
-        float depth;
-        if (frustum.intersects(scene.objects.boundingBoxes[i], &depth)) {
-            ObjectSortKey key;
-            key.depth = depth;
-            objSortPairs[visObjCount++] = {key, static_cast<uint32_t>(i)};
-        }
+    // (Re)initialize the culling infrastructure for the current set of objects.
+    if (m_frustumCuller.objectCount() != n) {
+        m_frustumCuller = FrustumCuller{n};
+        m_visObjBounds  = std::make_unique<ScreenBounds[]>(n);
     }
+    Stopwatch stopwatch;
+    // Perform frustum culling.
+    size_t visObjCount = m_frustumCuller.cullObjects(pCam, scene.objects.boundingBoxes.get(),
+                                                     objSortPairs, INCR_CULLING, EXACT_CULLING);
+    frame.timings[FramePhase::CULLING] = stopwatch.lap();
     // Sort objects (front to back).
-    std::sort(&objSortPairs[0], &objSortPairs[visObjCount]);
-    ID3D12GraphicsCommandList* graphicsCommandList = m_graphicsContext.commandList(0);
-    // Set the necessary command list state.
-    graphicsCommandList->RSSetViewports(1, &m_viewport);
-    graphicsCommandList->RSSetScissorRects(1, &m_scissorRect);
-    graphicsCommandList->SetGraphicsRootSignature(m_gBufferPass.rootSignature.Get());
-    ID3D12DescriptorHeap* texHeap = m_texPool.descriptorHeap();
-    graphicsCommandList->SetDescriptorHeaps(1, &texHeap);
-    // Finish the transition of the G-buffer to the writable state.
-    D3D12_RESOURCE_BARRIER barriers[5];
-    m_gBuffer.setWriteBarriers(barriers, D3D12_RESOURCE_BARRIER_FLAG_END_ONLY);
-    graphicsCommandList->ResourceBarrier(5, barriers);
+    m_frustumCuller.sortObjects(objSortPairs);
+    frame.timings[FramePhase::SORTING] = stopwatch.lap();
+    // Discard the objects which are too small, and keep the screen-space bounds of the rest.
+    visObjCount = cullSmallObjects(pCam, scene.objects.boundingBoxes.get(), MIN_OBJ_AREA,
+                                   visObjCount, objSortPairs, m_visObjBounds.get());
+    frame.timings[FramePhase::CULLING] += stopwatch.lap();
+    frame.objSortPairs = objSortPairs;
+    frame.visObjCount  = visObjCount;
+}
+
+void Renderer::recordGBufferPass(const size_t frameIndex, const PerspectiveCamera& pCam,
+                                 const Scene& scene) {
+    FrameData&            frame        = m_frames[frameIndex % FRAME_CNT];
+    const ObjectSortPair* objSortPairs = frame.objSortPairs;
+    const size_t          visObjCount  = frame.visObjCount;
+    Stopwatch stopwatch;
     // Store columns 0, 1 and 3 of the view-projection matrix.
     const XMMATRIX tViewProj = XMMatrixTranspose(pCam.computeViewProjMatrix());
     XMFLOAT4A matCols[3];
     XMStoreFloat4A(&matCols[0], tViewProj.r[0]);
     XMStoreFloat4A(&matCols[1], tViewProj.r[1]);
     XMStoreFloat4A(&matCols[2], tViewProj.r[3]);
-    // Set the root arguments.
-    graphicsCommandList->SetGraphicsRoot32BitConstants(2, 12, matCols, 0);
-    // Set the RTVs and the DSV.
-    const D3D12_CPU_DESCRIPTOR_HANDLE rtvHandles[2] = {
-        m_rtvPool.cpuHandle(BUF_CNT),    // First G-buffer RTV    
-        m_rtvPool.cpuHandle(BUF_CNT + 3) // Material RTV
-    };
-    const D3D12_CPU_DESCRIPTOR_HANDLE dsvHandle = m_dsvPool.cpuHandle(0);
-    graphicsCommandList->OMSetRenderTargets(4, &rtvHandles[0], true, &dsvHandle);
-    // Only the material buffer needs to be cleared, the rest of the RTs can be discarded.
-    graphicsCommandList->DiscardResource(m_gBuffer.normalBuffer.Get(),  nullptr);
-    graphicsCommandList->DiscardResource(m_gBuffer.uvCoordBuffer.Get(), nullptr);
-    graphicsCommandList->DiscardResource(m_gBuffer.uvGradBuffer.Get(),  nullptr);
-    graphicsCommandList->ClearRenderTargetView(rtvHandles[1], FLOAT4_ZERO, 0, nullptr);
-    // Clear the DSV.
-    const D3D12_CLEAR_FLAGS clearFlags = D3D12_CLEAR_FLAG_DEPTH | D3D12_CLEAR_FLAG_STENCIL;
-    graphicsCommandList->ClearDepthStencilView(dsvHandle, clearFlags, 0, 0, 0, nullptr);
-    // Define the input geometry.
-    graphicsCommandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-    graphicsCommandList->IASetVertexBuffers(0, 3, scene.vertexAttrBuffers.views.get());
-    // Issue draw calls.
-    uint16_t matId = UINT16_MAX;
-    for (size_t i = 0; i < visObjCount; ++i) {
-        const size_t objId = objSortPairs[i].index;
-        if (matId != scene.objects.materialIndices[objId]) {
-            matId = scene.objects.materialIndices[objId];
-            // Check whether the material has a valid bump map.
-            uint32_t bumpMapFlag = 0;
-            const uint32_t texId = scene.materials[matId].bumpTexId;
-            if (texId < UINT32_MAX) {
-                bumpMapFlag = 1u << 31;
-                const D3D12_GPU_DESCRIPTOR_HANDLE texHandle = m_texPool.gpuHandle(texId);
-                graphicsCommandList->SetGraphicsRootDescriptorTable(0, texHandle);
-            }
-            // Set the bump map flag and the material index.
-            graphicsCommandList->SetGraphicsRoot32BitConstant(1, bumpMapFlag | matId, 0);
+    // Split the draws into contiguous chunks, and record each chunk into its own command list.
+    const size_t threadCount = JobSystem::workerCount() + 1;
+    m_gBufferListCount = computeCommandListCount(visObjCount, threadCount,
+                                                 MAX_GBUF_LISTS, MIN_LIST_DRAWS);
+    DrawCounts listDrawCounts[MAX_GBUF_LISTS] = {};
+    // Reserve space for the indirect arguments (a record per visible object) in the upload buffer.
+    // Each command list writes the records of its range of objects.
+    IndirectDraw* indirectDraws = nullptr;
+    size_t        indirectArgsOffset = 0;
+    if (INDIRECT_DRAWS && visObjCount > 0) {
+        frame.indirectArgs = reserveChunkOfUploadBuffer<alignof(IndirectDraw)>(visObjCount *
+                                                                             sizeof(IndirectDraw));
+        indirectDraws      = reinterpret_cast<IndirectDraw*>(frame.indirectArgs.address);
+        indirectArgsOffset = frame.indirectArgs.offset;
+    }
+    recordDraws(visObjCount, m_gBufferListCount, [&](size_t listIndex, DrawRange range) {
+        // The first command list is always open, since it also records resource transitions.
+        if (listIndex > 0) {
+            m_graphicsContext.resetCommandList(listIndex, m_gBufferPass.pipelineState.Get());
+        }
+        ID3D12GraphicsCommandList* graphicsCommandList = m_graphicsContext.commandList(listIndex);
+        CommandEncoder encoder{graphicsCommandList, &m_texPool, &scene.indexBuffer.view};
+        // Set the necessary command list state.
+        graphicsCommandList->RSSetViewports(1, &m_viewport);
+        graphicsCommandList->RSSetScissorRects(1, &m_scissorRect);
+        graphicsCommandList->SetGraphicsRootSignature(m_gBufferPass.rootSignature.Get());
+        ID3D12DescriptorHeap* texHeap = m_texPool.descriptorHeap();
+        graphicsCommandList->SetDescriptorHeaps(1, &texHeap);
+        // Set the root arguments.
+        encoder.setDescriptorTable(0, 0);   // SRVs of all textures
+        encoder.setRootConstants(2, 12, matCols, 0);
+        // Set the RTVs and the DSV.
+        const D3D12_CPU_DESCRIPTOR_HANDLE rtvHandles[2] = {
+            m_rtvPool.cpuHandle(BUF_CNT),    // First G-buffer RTV
+            m_rtvPool.cpuHandle(BUF_CNT + 3) // Material RTV
+        };
+        const D3D12_CPU_DESCRIPTOR_HANDLE dsvHandle = m_dsvPool.cpuHandle(0);
+        graphicsCommandList->OMSetRenderTargets(4, &rtvHandles[0], true, &dsvHandle);
+        if (0 == listIndex) {
+            // Finish the transition of the G-buffer to the writable state.
+            recordBarriers(graphicsCommandList,
+                           m_frameGraph.graph.barriers(m_frameGraph.gBufferPass));
+            // Only the material buffer needs to be cleared, the rest of the RTs can be discarded.
+            graphicsCommandList->DiscardResource(m_gBuffer.normalBuffer.Get(),  nullptr);
+            graphicsCommandList->DiscardResource(m_gBuffer.uvCoordBuffer.Get(), nullptr);
+            graphicsCommandList->DiscardResource(m_gBuffer.uvGradBuffer.Get(),  nullptr);
+            graphicsCommandList->ClearRenderTargetView(rtvHandles[1], FLOAT4_ZERO, 0, nullptr);
+            // Clear the DSV.
+            const D3D12_CLEAR_FLAGS clearFlags = D3D12_CLEAR_FLAG_DEPTH | D3D12_CLEAR_FLAG_STENCIL;
+            graphicsCommandList->ClearDepthStencilView(dsvHandle, clearFlags, 0, 0, 0, nullptr);
         }
-        // Set the index buffer.
-        const D3D12_INDEX_BUFFER_VIEW ibv = scene.objects.indexBuffers.views[objId];
-        graphicsCommandList->IASetIndexBuffer(&scene.objects.indexBuffers.views[objId]);
-        // Draw the object.
-        const uint32_t count = ibv.SizeInBytes / sizeof(uint32_t);
-        graphicsCommandList->DrawIndexedInstanced(count, 1, 0, 0, 0);
+        // Define the input geometry.
+        graphicsCommandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+        graphicsCommandList->IASetVertexBuffers(0, 3, scene.vertexAttrBuffers.views.get());
+        encoder.setIndexBuffer(0);
+        // Issue draw calls.
+        if (!INDIRECT_DRAWS) {
+            listDrawCounts[listIndex] = encodeDraws(encoder, range, objSortPairs,
+                                                    scene.objects.drawPackets.get());
+        } else if (range.begin < range.end) {
+            // Write the indirect arguments of the range, and issue them with a single call.
+            listDrawCounts[listIndex] = buildIndirectDraws(range, objSortPairs,
+                                                           scene.objects.drawPackets.get(), 1,
+                                                           &indirectDraws[range.begin]);
+            const uint32_t drawCount = static_cast<uint32_t>(listDrawCounts[listIndex].drawCount);
+            const size_t   offset    = indirectArgsOffset + range.begin * sizeof(IndirectDraw);
+            graphicsCommandList->ExecuteIndirect(m_gBufferPass.commandSignature.Get(), drawCount,
+                                                 m_uploadBuffer.resource.Get(), offset,
+                                                 nullptr, 0);
+        }
+    });
+    // Accumulate the draw counts of all command lists.
+    frame.drawCounts = DrawCounts{};
+    for (size_t i = 0; i < m_gBufferListCount; ++i) {
+        frame.drawCounts.objDrawCount   += listDrawCounts[i].objDrawCount;
+        frame.drawCounts.drawCount      += listDrawCounts[i].drawCount;
+        frame.drawCounts.matChangeCount += listDrawCounts[i].matChangeCount;
     }
-    // Reset the allocator to reuse the memory.
-    m_tempAlloca.reset();
+    frame.timings[FramePhase::RECORDING] = stopwatch.lap();
 }
 
 void Renderer::recordShadingPass(const PerspectiveCamera& pCam) {
-    ID3D12GraphicsCommandList* graphicsCommandList = m_graphicsContext.commandList(1);
+    auto graphicsCommandList = m_graphicsContext.commandList(shadingListIndex);
     // Set the necessary command list state.
     graphicsCommandList->RSSetViewports(1, &m_viewport);
     graphicsCommandList->RSSetScissorRects(1, &m_scissorRect);
     graphicsCommandList->SetGraphicsRootSignature(m_shadingPass.rootSignature.Get());
     ID3D12DescriptorHeap* texHeap = m_texPool.descriptorHeap();
     graphicsCommandList->SetDescriptorHeaps(1, &texHeap);
-    // Transition the G-buffer to the readable state.
-    D3D12_RESOURCE_BARRIER barriers[6];
-    m_gBuffer.setReadBarriers(barriers, D3D12_RESOURCE_BARRIER_FLAG_NONE);
-    // Transition the state of the back buffer: Presenting -> Render Target.
-    ID3D12Resource* backBuffer = m_swapChainBuffers[m_backBufferIndex].Get();
-    barriers[5] = D3D12_TRANSITION_BARRIER{backBuffer, D3D12_RESOURCE_STATE_PRESENT,
-                                                       D3D12_RESOURCE_STATE_RENDER_TARGET};
-    graphicsCommandList->ResourceBarrier(6, barriers);
+    // Transition the G-buffer to the readable state, and the back buffer to the writable one.
+    recordBarriers(graphicsCommandList, m_frameGraph.graph.barriers(m_frameGraph.shadingPass));
     // Store the 3x3 part of the raster-to-view-direction matrix.
     XMFLOAT3X3 rasterToViewDir;
     XMStoreFloat3x3(&rasterToViewDir, pCam.computeRasterToViewDirMatrix());
@@ -824,29 +1135,55 @@ void Renderer::recordShadingPass(const PerspectiveCamera& pCam) {
     const D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle = m_rtvPool.cpuHandle(m_backBufferIndex);
     graphicsCommandList->OMSetRenderTargets(1, &rtvHandle, false, nullptr);
     // The back buffer will be completely overwritten, so discarding it is sufficient.
-    graphicsCommandList->DiscardResource(backBuffer, nullptr);
+    graphicsCommandList->DiscardResource(m_swapChainBuffers[m_backBufferIndex].Get(), nullptr);
     // Perform the screen space pass using a single triangle.
     graphicsCommandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
     graphicsCommandList->DrawInstanced(3, 1, 0, 0);
-    // Start the transition of the G-buffer to the writable state.
-    m_gBuffer.setWriteBarriers(barriers, D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY);
-    // Transition the state of the back buffer: Render Target -> Presenting.
-    barriers[5] = D3D12_TRANSITION_BARRIER{backBuffer, D3D12_RESOURCE_STATE_RENDER_TARGET,
-                                                       D3D12_RESOURCE_STATE_PRESENT};
-    graphicsCommandList->ResourceBarrier(6, barriers);
+    // Start the transition of the G-buffer to the writable state (for the next frame),
+    // and transition the back buffer to the presenting state.
+    recordBarriers(graphicsCommandList, m_frameGraph.graph.finalBarriers());
 }
 
-void Renderer::renderFrame() {
-    // Finalize and execute command lists.
-    m_graphicsContext.executeCommandLists();
+void Renderer::renderFrame(const size_t frameIndex) {
+    FrameData& frame = m_frames[frameIndex % FRAME_CNT];
+    Stopwatch  stopwatch;
+    // Finalize and execute the command lists used during the frame, in order.
+    size_t listIndices[MAX_GBUF_LISTS + 1];
+    for (size_t i = 0; i < m_gBufferListCount; ++i) {
+        listIndices[i] = i;
+    }
+    listIndices[m_gBufferListCount] = shadingListIndex;
+    // Loader threads read the fence value concurrently.
+    m_frameFenceValue = m_graphicsContext.executeCommandLists(m_gBufferListCount + 1,
+                                                              listIndices).second;
+    {
+        // The next copy queue submission waits for the frame, so the indirect arguments
+        // can be committed as if they were used by the copy queue.
+        std::lock_guard<std::mutex> lock{m_copyMutex};
+        if (frame.indirectArgs.address) {
+            commitChunkOfUploadBuffer(frame.indirectArgs, 0);
+            frame.indirectArgs = UploadAllocation{};
+        }
+        // Close the segment of the upload buffer once per frame, so that it is retired
+        // as soon as the frame completes (rather than once the buffer is full).
+        if (m_pendingCopySize > 0) {
+            submitCopyCommands();
+        } else {
+            // There is nothing to copy. Signal the copy queue fence after the frame.
+            m_copyContext.syncCommandQueue(m_frameFence, m_frameFenceValue);
+            m_uploadRing.closeSegment(m_copyContext.insertFence().second);
+        }
+    }
     // Present the frame, and update the index of the render (back) buffer.
     CHECK_CALL(m_swapChain->Present(VSYNC_INTERVAL, 0), "Failed to display the frame buffer.");
+    frame.timings[FramePhase::SUBMISSION] = stopwatch.lap();
     m_backBufferIndex = m_swapChain->GetCurrentBackBufferIndex();
+    m_frameGraph.resources[m_frameGraph.backBuffer] = m_swapChainBuffers[m_backBufferIndex].Get();
     // Reset the graphics command (frame) allocator.
     m_graphicsContext.resetCommandAllocators();
     // Reset command lists to their initial states.
     m_graphicsContext.resetCommandList(0, m_gBufferPass.pipelineState.Get());
-    m_graphicsContext.resetCommandList(1, m_shadingPass.pipelineState.Get());
+    m_graphicsContext.resetCommandList(shadingListIndex, m_shadingPass.pipelineState.Get());
     // Block the thread until the swap chain is ready accept a new frame.
     // Otherwise, Present() may block the thread, increasing the input lag.
     WaitForSingleObject(m_swapChainWaitableObject, INFINITE);
@@ -856,7 +1193,26 @@ std::pair<uint64_t, uint64_t> Renderer::getTime() const {
     return m_graphicsContext.getTime();
 }
 
+const FrameTimings& Renderer::getFrameTimings(const size_t frameIndex) const {
+    return m_frames[frameIndex % FRAME_CNT].timings;
+}
+
+const DrawCounts& Renderer::getDrawCounts(const size_t frameIndex) const {
+    return m_frames[frameIndex % FRAME_CNT].drawCounts;
+}
+
+const FrameArenas& Renderer::getFrameArenas() const {
+    return m_frameArenas;
+}
+
 void Renderer::stop() {
     m_copyContext.destroy();
     m_graphicsContext.destroy();
+    // The GPU is idle, so all retired resources can be released.
+    std::lock_guard<std::mutex> lock{m_heapMutex};
+    for (RetiredResource& retired : m_retiredResources) {
+        retired.resource.Reset();
+        m_resourceHeaps.free(retired.memory);
+    }
+    m_retiredResources.clear();
 }
@@ -1,25 +1,70 @@
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
 #include <DirectXMathSSE4.h>
 #include "HelperStructs.h"
+#include "ResourceHeaps.h"
 #include "..\Common\Constants.h"
-#include "..\Common\Resources.h"
+#include "..\Common\Culling.h"
+#include "..\Common\DrawEncoding.h"
+#include "..\Common\FrameArenas.h"
+#include "..\Common\FrameStats.h"
+#include "..\Common\ParallelRecording.h"
+#include "..\Common\RenderGraph.h"
+#include "..\Common\UploadRing.h"
 
-struct Material;
+class  MaterialRegistry;
 class  PerspectiveCamera;
 class  Scene;
 
 namespace D3D12 {
+    // Statistics of the uploads performed via the copy queue.
+    struct UploadStats {
+        size_t uploadedSize;    // Bytes
+        size_t batchCount;      // Number of submitted copy batches
+        size_t stallCount;      // Number of times a thread had to wait for the copy queue
+        float  stallTime;       // Total time (in milliseconds) spent waiting
+    };
+
+    // MIP chain of a 2D texture placed within the upload buffer. The layout is the one
+    // required for copying: row pitches are aligned to 256 bytes, and MIP levels to 512 bytes.
+    struct TextureUpload {
+        D3D12_SUBRESOURCE_FOOTPRINT        footprint;   // Of the base MIP image
+        uint32_t                           mipCount;
+        size_t                             size;        // Of the entire MIP chain (in bytes)
+        UploadRing<QueueFence>::Allocation chunk;       // Of the upload buffer
+    };
+
     class Renderer {
     public:
         RULE_OF_ZERO_MOVE_ONLY(Renderer);
         Renderer();
         // Creates a 2D texture according to the provided description of the base MIP image.
         // Multi-sample textures and texture arrays are not supported.
+        // Thread-safe with respect to other texture creation calls during scene loading only:
+        // it must not be called while frames are recorded (see 'm_initListMutex').
         Texture createTexture2D(const D3D12_SUBRESOURCE_FOOTPRINT& footprint,
                                 const uint32_t mipCount, const void* data);
+        // Reserves memory within the upload buffer for the MIP chain of a 2D texture
+        // (the row pitch of the footprint is ignored), so that it can be written in place.
+        // Blocks while TEX_CHAIN_CNT reservations are outstanding. Thread-safe.
+        // If the MIP chain is larger than TEX_CHAIN_SIZE, nothing is reserved, and the chunk
+        // address is 'nullptr': the texture has to be created from the data instead.
+        TextureUpload reserveTextureUpload(const D3D12_SUBRESOURCE_FOOTPRINT& footprint,
+                                           const uint32_t mipCount);
+        // Creates a 2D texture from the MIP chain written into the reserved upload memory,
+        // and releases the memory once the copy is complete. Ends the reservation.
+        // Thread-safe with respect to other texture creation calls during scene loading only.
+        Texture createTexture2D(const TextureUpload& upload);
         // Returns the index of the SRV within the texture pool.
         size_t getTextureIndex(const Texture& texture) const;
+        // Destroys the texture once the GPU no longer uses it. The texture must not be used
+        // by the frames recorded after the call, and its upload must be complete.
+        // The slot of the SRV is recycled, and the index of the texture becomes invalid.
+        void destroyTexture(Texture&& texture);
         // Creates a constant buffer for the data of the specified size (in bytes).
         ConstantBuffer createConstantBuffer(const size_t size, const void* data = nullptr);
         // Creates a structured buffer for the data of the specified size (in bytes).
@@ -29,81 +74,188 @@ namespace D3D12 {
         // Creates a vertex attribute buffer for the vertex array of 'count' elements.
         template <typename T>
         VertexBuffer createVertexBuffer(const size_t count, const T* elements);
-        // Sets materials (represented by texture indices) in shaders.
-        void setMaterials(const size_t count, const Material* materials);
+        // Uploads the materials (represented by texture indices) added or changed since
+        // the last call, and makes them available to shaders. Grows the material buffer
+        // if necessary. Must not be called while the shading pass is being recorded.
+        void updateMaterials(MaterialRegistry* materials);
         // Submits all pending copy commands for execution, and begins a new segment
-        // of the upload buffer. As a result, the previous segment of the buffer becomes
-        // available for writing. 'immediateCopy' flag ensures that all copies from the
-        // current segment are also completed during this call (at the cost of blocking
-        // the thread), therefore making the entire buffer free and available for writing.
-        void executeCopyCommands(const bool immediateCopy = false);
+        // of the upload buffer. Once the copies complete, the memory of the segment
+        // becomes available for writing. Copies are also submitted automatically, at the end
+        // of each frame, and in batches of COPY_BATCH_SIZE bytes. Up to COPY_BATCH_CNT batches
+        // can be in flight; the thread only blocks if the oldest of them has to complete first.
+        void executeCopyCommands();
+        // Returns the upload statistics. Call it once the uploads are complete.
+        const UploadStats& getUploadStats() const;
+        // Returns the statistics of the heaps which buffers and textures are placed in.
+        // Call it once the resources are created.
+        TlsfAllocator::Stats getHeapStats() const;
+        // The following functions take the index of the frame as input.
+        // Up to FRAME_CNT consecutive frames can be processed at the same time: e.g. the objects
+        // of the next frame can be culled while the current frame is being recorded.
+        // For each frame, the functions must be called in order, and each function must be
+        // called for consecutive frames in order. Recording of a frame must begin
+        // after the submission of the previous frame.
+        // Performs culling and front-to-back sorting of opaque scene objects.
+        void cullObjects(const size_t frameIndex, const PerspectiveCamera& pCam,
+                         const Scene& scene);
         // Records commands within the G-buffer generation pass.
-        // Input: the camera and opaque scene objects.
-        void recordGBufferPass(const PerspectiveCamera& pCam, const Scene& scene);
+        // Input: the camera and opaque scene objects (culled by cullObjects()).
+        void recordGBufferPass(const size_t frameIndex, const PerspectiveCamera& pCam,
+                               const Scene& scene);
         // Records commands within the shading pass.
         void recordShadingPass(const PerspectiveCamera& pCam);
         // Starts the frame rendering process.
-        void renderFrame();
+        void renderFrame(const size_t frameIndex);
         // Returns the current time of the CPU thread and the GPU queue in microseconds.
         std::pair<uint64_t, uint64_t> getTime() const;
+        // Returns the timings of the CPU phases of the frame.
+        // The frame times (CPU_FRAME and GPU_FRAME) are not measured by the renderer.
+        const FrameTimings& getFrameTimings(const size_t frameIndex) const;
+        // Returns the numbers of G-buffer draws (before and after coalescing) of the frame.
+        const DrawCounts& getDrawCounts(const size_t frameIndex) const;
+        // Returns the frame arenas used for temporary per-frame data.
+        const FrameArenas& getFrameArenas() const;
         // Terminates the rendering process.
         void stop();
     private:
         struct GBuffer {
             ComPtr<ID3D12Resource> depthBuffer; 
             ComPtr<ID3D12Resource> normalBuffer, uvCoordBuffer, uvGradBuffer, matIdBuffer;
-            // Sets transition barriers to the write-only (RTV or DSV) states.
-            void setWriteBarriers(D3D12_RESOURCE_BARRIER* barriers,
-                                  const D3D12_RESOURCE_BARRIER_FLAGS flag);
-            // Sets transition barriers to the read-only (SRV) state.
-            void setReadBarriers(D3D12_RESOURCE_BARRIER* barriers,
-                                 const D3D12_RESOURCE_BARRIER_FLAGS flag);
+        };
+        // Passes of the frame, and the resources they access.
+        struct FrameGraph {
+            RenderGraph                  graph;
+            RenderGraph::PassId          gBufferPass, shadingPass;
+            RenderGraph::ResourceId      backBuffer;
+            std::vector<ID3D12Resource*> resources;     // Indexed by the resource ID
+        };
+        // Data of a frame in flight.
+        using UploadAllocation = UploadRing<QueueFence>::Allocation;
+        struct FrameData {
+            const ObjectSortPair* objSortPairs;     // Visible objects, sorted front to back
+            size_t                visObjCount;
+            UploadAllocation      indirectArgs;     // Committed once the frame is submitted
+            FrameTimings          timings;
+            DrawCounts            drawCounts;
+        };
+        // Destroyed resource waiting for the GPU.
+        struct RetiredResource {
+            ComPtr<ID3D12Resource> resource;
+            HeapAllocation         memory;
+            uint64_t               fenceValue;      // Of the graphics queue
         };
         struct RenderPassConfig {
-            ComPtr<ID3D12RootSignature> rootSignature;
-            ComPtr<ID3D12PipelineState> pipelineState;
+            ComPtr<ID3D12RootSignature>    rootSignature;
+            ComPtr<ID3D12PipelineState>    pipelineState;
+            ComPtr<ID3D12CommandSignature> commandSignature; // Used by indirect draws
         };
         // Configures the G-buffer generation pass.
         void configureGBufferPass();
         // Configures the shading pass.
         void configureShadingPass();
+        // Declares the passes of the frame, and compiles the frame graph.
+        // Records the initial barriers. Must be called once the G-buffer is created.
+        void configureFrameGraph();
+        // Records the barriers of the frame graph into the command list.
+        void recordBarriers(ID3D12GraphicsCommandList* graphicsCommandList,
+                            const std::vector<RenderGraph::Barrier>& barriers) const;
         // Creates a depth buffer with descriptors in both DSV and texture pools.
         ComPtr<ID3D12Resource> createDepthBuffer(const uint32_t width, const uint32_t height,
                                                  const DXGI_FORMAT format);
+        // Creates a 2D texture, and uploads the data level by level, in chunks of at most
+        // TEX_CHAIN_SIZE bytes. Used for MIP chains which are too large to be reserved at once.
+        Texture createTexture2DByLevel(const D3D12_SUBRESOURCE_FOOTPRINT& footprint,
+                                       const uint32_t mipCount, const void* data);
+        // Creates a 2D texture without data, with a descriptor in the texture pool.
+        // Thread-safe with respect to other texture creation calls during scene loading only.
+        Texture createTexture(const D3D12_SUBRESOURCE_FOOTPRINT& footprint,
+                              const uint32_t mipCount);
+        // Computes the layouts of the MIP levels of a 2D texture within the upload buffer.
+        // Returns the size of the entire MIP chain.
+        size_t computeUploadLayouts(const D3D12_SUBRESOURCE_FOOTPRINT& footprint,
+                                    const uint32_t mipCount,
+                                    D3D12_PLACED_SUBRESOURCE_FOOTPRINT* layouts,
+                                    uint32_t* rowCounts) const;
         // Creates a render buffer with descriptors in both RTV and texture pools.
         ComPtr<ID3D12Resource> createRenderBuffer(const uint32_t width, const uint32_t height,
                                                   const DXGI_FORMAT format);
+        // Creates a buffer or a texture within the resource heaps. Thread-safe.
+        // Optionally, returns the allocated memory.
+        ComPtr<ID3D12Resource> createResource(const D3D12_RESOURCE_DESC& resourceDesc,
+                                              const D3D12_RESOURCE_STATES initialState,
+                                              HeapAllocation* allocation = nullptr);
+        // Releases the resource once the frame being recorded (if any) completes.
+        // Must be called with 'm_heapMutex' locked.
+        void retireResource(ComPtr<ID3D12Resource>&& resource, const HeapAllocation& memory);
+        // Releases the retired resources no longer used by the GPU, and recycles
+        // the SRV slots of the destroyed textures. Must be called with 'm_heapMutex' locked.
+        void releaseRetiredResources();
+        // Copies the range of 'count' materials beginning with 'first' into the material buffer.
+        void uploadMaterials(const MaterialRegistry& materials, const size_t first,
+                             const size_t count);
         // Copies the data of the specified size (in bytes) and alignment into the upload buffer.
-        // Returns the offset into the upload buffer which corresponds to the location of the data.
+        // Returns the chunk of the upload buffer which holds the data.
         template<size_t alignment>
-        size_t copyToUploadBuffer(const size_t size, const void* data);
+        UploadAllocation copyToUploadBuffer(const size_t size, const void* data);
         // Reserves a contiguous chunk of memory of the specified size within the upload buffer.
-        // The reservation is guaranteed to be valid only until any other member function call.
-        // Returns the address of and the offset to the beginning of the chunk of the upload buffer.
+        // Thread-safe. If the buffer is full, submits the pending copies, and blocks the thread
+        // until enough memory is available. The chunk remains valid until it is committed.
         template<size_t alignment>
-        std::pair<byte_t*, size_t> reserveChunkOfUploadBuffer(const size_t size);
+        UploadAllocation reserveChunkOfUploadBuffer(const size_t size);
+        // Commits the chunk of the upload buffer of the specified size (in bytes) once
+        // the copy commands using it are recorded. Submits the batch of copies if it is full.
+        // Must be called with 'm_copyMutex' locked.
+        void commitChunkOfUploadBuffer(const UploadAllocation& chunk, const size_t size);
+        // Submits the pending copy commands. Must be called with 'm_copyMutex' locked.
+        void submitCopyCommands();
     private:
-        ComPtr<ID3D12DeviceEx>        m_device;
+        ComPtr<ID3D12DeviceEx>          m_device;
         // Swap chain infrastructure.
-        ComPtr<IDXGISwapChain3>       m_swapChain;
-        HANDLE                        m_swapChainWaitableObject;
-        ComPtr<ID3D12Resource>        m_swapChainBuffers[BUF_CNT];
-        size_t                        m_backBufferIndex;
+        ComPtr<IDXGISwapChain3>         m_swapChain;
+        HANDLE                          m_swapChainWaitableObject;
+        ComPtr<ID3D12Resource>          m_swapChainBuffers[BUF_CNT];
+        size_t                          m_backBufferIndex;
         // Descriptor pools.
-        RtvPool<RTV_CNT>              m_rtvPool;
-        DsvPool<1>                    m_dsvPool;
-        CbvSrvUavPool<TEX_CNT>        m_texPool;
+        RtvPool<RTV_CNT>                m_rtvPool;
+        DsvPool<1>                      m_dsvPool;
+        CbvSrvUavPool<TEX_CNT>          m_texPool;
+        // Memory of buffers and textures.
+        std::mutex                      m_heapMutex;        // Guards the fields below
+        ResourceHeapAllocator           m_resourceHeaps;
+        std::deque<RetiredResource>     m_retiredResources; // Ordered by the fence value
+        // Serializes the texture transitions recorded into graphics command list 0
+        // by concurrent texture creation calls. It is not taken by the other users of the list
+        // (buffer creation and frame recording), so textures may only be created concurrently
+        // while the scene is loaded, before the first frame is recorded.
+        std::mutex                      m_initListMutex;
+        std::mutex                      m_texChainMutex;    // Guards the count below
+        std::condition_variable         m_texChainCond;     // Signaled once a chain is copied
+        size_t                          m_texChainCount;    // Outstanding chain reservations
         // Rendering infrastructure.
-        GraphicsContext<FRAME_CNT, 2> m_graphicsContext;
-        D3D12_VIEWPORT                m_viewport;
-        D3D12_RECT                    m_scissorRect;
-        GBuffer                       m_gBuffer;
-        StructuredBuffer              m_materialBuffer;
-        LinearAllocator               m_tempAlloca;
-        RenderPassConfig              m_gBufferPass;
-        RenderPassConfig              m_shadingPass;
+        // The G-buffer pass command lists are followed by the shading pass command list.
+        static constexpr size_t         shadingListIndex = MAX_GBUF_LISTS;
+        GraphicsContext<FRAME_CNT, shadingListIndex + 1> m_graphicsContext;
+        size_t                          m_gBufferListCount; // Used during the current frame
+        D3D12_VIEWPORT                  m_viewport;
+        D3D12_RECT                      m_scissorRect;
+        GBuffer                         m_gBuffer;
+        FrameGraph                      m_frameGraph;
+        StructuredBuffer                m_materialBuffer;
+        size_t                          m_materialCapacity; // Number of materials
+        FrameArenas                     m_frameArenas;      // Temporary per-frame data
+        FrustumCuller                   m_frustumCuller;
+        std::unique_ptr<ScreenBounds[]> m_visObjBounds;
+        FrameData                       m_frames[FRAME_CNT]; // Per frame in flight
+        RenderPassConfig                m_gBufferPass;
+        RenderPassConfig                m_shadingPass;
+        ID3D12Fence*                    m_frameFence;       // Signaled after each frame
+        std::atomic<uint64_t>           m_frameFenceValue;  // Of the last submitted frame
         // Copying infrastructure.
-        CopyContext<2, 1>             m_copyContext;
-        UploadRingBuffer              m_uploadBuffer;
+        CopyContext<COPY_BATCH_CNT, 1>  m_copyContext;
+        std::mutex                      m_copyMutex;        // Guards the fields below
+        size_t                          m_pendingCopySize;  // Recorded, but not submitted
+        UploadStats                     m_uploadStats;
+        UploadRingBuffer                m_uploadBuffer;     // Also holds indirect arguments
+        UploadRing<QueueFence>          m_uploadRing;       // Manages the upload buffer
     };
 } // namespace D3D12
@@ -0,0 +1,113 @@
+#include <algorithm>
+#include <cassert>
+#include <d3dx12.h>
+#include "ResourceHeaps.h"
+#include "..\Common\Utility.h"
+
+using namespace D3D12;
+
+ResourceHeapAllocator::ResourceHeapAllocator()
+    : m_device{nullptr}
+    , m_heapSize{0} {}
+
+ResourceHeapAllocator::ResourceHeapAllocator(ID3D12Device* device, const size_t heapSize)
+    : m_device{device}
+    , m_heapSize{heapSize} {
+    assert(device && 0 == heapSize % D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT);
+}
+
+ComPtr<ID3D12Resource> ResourceHeapAllocator::createResource(
+                                              const D3D12_RESOURCE_DESC& desc,
+                                              const D3D12_RESOURCE_STATES initialState,
+                                              HeapAllocation* allocation) {
+    assert(!(desc.Flags & (D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET |
+                           D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL)));
+    const HeapClass heapClass = (desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+                              ? HeapClass::BUFFER : HeapClass::TEXTURE;
+    D3D12_RESOURCE_DESC placedDesc = desc;
+    D3D12_RESOURCE_ALLOCATION_INFO allocInfo = {};
+    // Attempt to use the small (4 KiB) alignment class for textures.
+    if (heapClass == HeapClass::TEXTURE) {
+        placedDesc.Alignment = D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT;
+        allocInfo = m_device->GetResourceAllocationInfo(0, 1, &placedDesc);
+    }
+    // The device rejects the small alignment by returning a larger one.
+    if (heapClass == HeapClass::BUFFER ||
+        allocInfo.Alignment != D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT) {
+        placedDesc.Alignment = 0;   // Automatic (64 KiB)
+        allocInfo = m_device->GetResourceAllocationInfo(0, 1, &placedDesc);
+    }
+    ComPtr<ID3D12Resource> resource;
+    HeapAllocation heapAlloc = {TlsfAllocator::Allocation{0, 0, TlsfAllocator::INVALID_BLOCK},
+                                UINT32_MAX};
+    if (allocInfo.SizeInBytes <= m_heapSize) {
+        heapAlloc = allocate(heapClass, allocInfo.SizeInBytes, allocInfo.Alignment);
+        CHECK_CALL(m_device->CreatePlacedResource(m_heaps[heapAlloc.heap].heap.Get(),
+                                                  heapAlloc.range.offset, &placedDesc,
+                                                  initialState, nullptr,
+                                                  IID_PPV_ARGS(&resource)),
+                   "Failed to create a placed resource.");
+    } else {
+        // The resource does not fit into a heap.
+        const auto heapProperties = CD3DX12_HEAP_PROPERTIES{D3D12_HEAP_TYPE_DEFAULT};
+        CHECK_CALL(m_device->CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE,
+                                                     &desc, initialState, nullptr,
+                                                     IID_PPV_ARGS(&resource)),
+                   "Failed to allocate a committed resource.");
+    }
+    if (allocation) {
+        *allocation = heapAlloc;
+    }
+    return resource;
+}
+
+void ResourceHeapAllocator::free(const HeapAllocation& allocation) {
+    // The memory of committed resources is freed once they are released.
+    if (allocation.heap != UINT32_MAX) {
+        m_heaps[allocation.heap].allocator.free(allocation.range);
+    }
+}
+
+TlsfAllocator::Stats ResourceHeapAllocator::computeStats() const {
+    TlsfAllocator::Stats stats = {};
+    for (const Heap& heap : m_heaps) {
+        const TlsfAllocator::Stats heapStats = heap.allocator.computeStats();
+        stats.capacity        += heapStats.capacity;
+        stats.usedSize        += heapStats.usedSize;
+        stats.freeSize        += heapStats.freeSize;
+        stats.largestFreeSize  = std::max(stats.largestFreeSize, heapStats.largestFreeSize);
+        stats.allocationCount += heapStats.allocationCount;
+        stats.freeBlockCount  += heapStats.freeBlockCount;
+    }
+    stats.fragmentation = (stats.freeSize > 0) ? 1.f - static_cast<float>(stats.largestFreeSize) /
+                                                       static_cast<float>(stats.freeSize)
+                                               : 0.f;
+    return stats;
+}
+
+HeapAllocation ResourceHeapAllocator::allocate(const HeapClass heapClass, const size_t size,
+                                               const size_t alignment) {
+    // Use the first heap of the class with a large enough free block.
+    for (size_t i = 0, n = m_heaps.size(); i < n; ++i) {
+        if (m_heaps[i].heapClass != heapClass) continue;
+        const TlsfAllocator::Allocation range = m_heaps[i].allocator.allocate(size, alignment);
+        if (range.block != TlsfAllocator::INVALID_BLOCK) {
+            return HeapAllocation{range, static_cast<uint32_t>(i)};
+        }
+    }
+    // Allocate a new heap.
+    const D3D12_HEAP_FLAGS flags = (heapClass == HeapClass::BUFFER)
+                                 ? D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS
+                                 : D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES;
+    const CD3DX12_HEAP_DESC heapDesc{m_heapSize, D3D12_HEAP_TYPE_DEFAULT,
+                                     D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT, flags};
+    Heap heap;
+    CHECK_CALL(m_device->CreateHeap(&heapDesc, IID_PPV_ARGS(&heap.heap)),
+               "Failed to allocate a resource heap.");
+    heap.allocator = TlsfAllocator{m_heapSize, D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT};
+    heap.heapClass = heapClass;
+    m_heaps.push_back(std::move(heap));
+    const TlsfAllocator::Allocation range = m_heaps.back().allocator.allocate(size, alignment);
+    assert(range.block != TlsfAllocator::INVALID_BLOCK);
+    return HeapAllocation{range, static_cast<uint32_t>(m_heaps.size() - 1)};
+}
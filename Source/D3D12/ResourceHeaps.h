@@ -0,0 +1,47 @@
+#pragma once
+
+#include <vector>
+#include "HelperStructs.h"
+#include "..\Common\TlsfAllocator.h"
+
+namespace D3D12 {
+    // Suballocates placed resources from large default heaps.
+    // Heaps are allocated on demand, HEAP_PAGE_SIZE bytes at a time. Buffers and textures
+    // are kept in separate heaps (as required by resource heap tier 1). Buffers are aligned
+    // to 64 KiB; small textures use the 4 KiB alignment class if the device allows it.
+    // Resources larger than a heap are committed. Not thread-safe.
+    class ResourceHeapAllocator {
+    public:
+        RULE_OF_ZERO_MOVE_ONLY(ResourceHeapAllocator);
+        // Ctor; performs zero-initialization.
+        ResourceHeapAllocator();
+        // Ctor; takes the device and the size of a heap (in bytes) as input.
+        explicit ResourceHeapAllocator(ID3D12Device* device, const size_t heapSize);
+        // Creates a resource on the default heap. Render targets and depth buffers
+        // are not supported. Optionally, returns the allocated memory.
+        ComPtr<ID3D12Resource> createResource(const D3D12_RESOURCE_DESC& desc,
+                                              const D3D12_RESOURCE_STATES initialState,
+                                              HeapAllocation* allocation = nullptr);
+        // Frees the memory of the resource. The resource must be released,
+        // and must not be in use by the GPU.
+        void free(const HeapAllocation& allocation);
+        // Computes the statistics of all heaps. The largest free block is the largest one
+        // across the heaps, so the fragmentation is computed with respect to a single heap.
+        TlsfAllocator::Stats computeStats() const;
+    private:
+        // Heaps can only hold either buffers or non-RT/DS textures.
+        enum class HeapClass { BUFFER, TEXTURE };
+        struct Heap {
+            ComPtr<ID3D12Heap>     heap;
+            TlsfAllocator          allocator;
+            HeapClass              heapClass;
+        };
+        // Allocates memory within an existing or a new heap of the specified class.
+        HeapAllocation allocate(const HeapClass heapClass, const size_t size,
+                                const size_t alignment);
+    private:
+        ID3D12Device*              m_device;
+        size_t                     m_heapSize;
+        std::vector<Heap>          m_heaps;
+    };
+} // namespace D3D12
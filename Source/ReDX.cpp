@@ -1,5 +1,14 @@
-#include <future>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <tuple>
+#include <vector>
 #include "Common\Camera.h"
+#include "Common\CameraPath.h"
+#include "Common\FramePipeline.h"
+#include "Common\FrameStats.h"
+#include "Common\JobSystem.h"
 #include "Common\Scene.h"
 #include "D3D12\Renderer.hpp"
 #include "UI\Window.h"
@@ -16,25 +25,69 @@ struct KeyPressStatus {
     uint32_t e : 1;
 };
 
+// Stages of the frame pipeline.
+enum FrameStage : size_t {
+    UPDATE_STAGE,       // Camera update
+    CULLING_STAGE,      // Culling and sorting of objects
+    RECORDING_STAGE,    // Command list recording
+    SUBMISSION_STAGE,   // Submission and presentation
+    STAGE_COUNT
+};
+
+// Data of a frame in flight.
+struct FrameContext {
+    KeyPressStatus    keyPressStatus;   // Input status at the time the frame is scheduled
+    PerspectiveCamera camera;           // Updated camera
+    float             cpuFrameTime;     // Milliseconds
+    float             gpuFrameTime;     // Milliseconds
+};
+
 int __cdecl main(const int argc, const char* argv[]) {
     // Parse command line arguments.
-	if (argc > 1) {
-		printWarning("The following command line arguments have been ignored:");
-        for (int i = 1; i < argc; ++i) {
-            printWarning("%s", argv[i]);
+    const char* scenePath        = "..\\..\\Assets\\Sponza\\";  // Scene directory
+    const char* sceneFileName    = "sponza.obj";              // Scene .obj file
+    const char* recPathFileName  = nullptr;                   // Camera path recording destination
+    const char* playPathFileName = nullptr;                   // Camera path playback source
+    const char* statsFileName    = nullptr;                   // Statistics destination (no ext.)
+    size_t      maxFrameCount    = SIZE_MAX;                  // Number of measured frames
+    size_t      warmupFrameCount = 0;                         // Number of unmeasured frames
+    for (int i = 1; i < argc; ++i) {
+        if (0 == strcmp(argv[i], "-scene") && i + 2 < argc) {
+            scenePath     = argv[++i];
+            sceneFileName = argv[++i];
+        } else if (0 == strcmp(argv[i], "-record") && i + 1 < argc) {
+            recPathFileName = argv[++i];
+        } else if (0 == strcmp(argv[i], "-play") && i + 1 < argc) {
+            playPathFileName = argv[++i];
+        } else if (0 == strcmp(argv[i], "-frames") && i + 1 < argc) {
+            maxFrameCount = strtoull(argv[++i], nullptr, 10);
+        } else if (0 == strcmp(argv[i], "-warmup") && i + 1 < argc) {
+            warmupFrameCount = strtoull(argv[++i], nullptr, 10);
+        } else if (0 == strcmp(argv[i], "-stats") && i + 1 < argc) {
+            statsFileName = argv[++i];
+        } else {
+            printWarning("The following command line argument has been ignored: %s", argv[i]);
         }
-	}
+    }
     // Verify SSE4.1 support for the DirectXMath library.
     if (!SSE4::XMVerifySSE4Support()) {
         printError("The CPU doesn't support SSE4.1. Aborting.");
         return -1;
     }
+    // Load the camera path for playback.
+    const CameraPath playPath = playPathFileName ? CameraPath{playPathFileName} : CameraPath{};
+    if (playPathFileName && 0 == playPath.poseCount()) {
+        printError("The camera path is empty: %s", playPathFileName);
+        return -1;
+    }
     // Create a window for rendering output.
     Window::open(RES_X, RES_Y);
-    // Initialize the renderer (internally uses the Window).
+    // Start the worker threads.
+    JobSystem::start();
+    // Initialize the renderer (internally uses the Window and the JobSystem).
     D3D12::Renderer engine;
     // Provide the scene description.
-    Scene scene{"..\\..\\Assets\\Sponza\\", "sponza.obj", engine};
+    Scene scene{scenePath, sceneFileName, engine};
     // Set up the camera.
     PerspectiveCamera pCam{static_cast<float>(Window::width()),
                            static_cast<float>(Window::height()),
@@ -42,15 +95,91 @@ int __cdecl main(const int argc, const char* argv[]) {
                            /* pos */ {300.f, 200.f, -35.f},
                            /* dir */ {-1.f, 0.f, 0.f},
                            /* up  */ {0.f, 1.f, 0.f}};
+    CameraPath recPath;
+    float      recTime = 0.f;
+    // Collect the frame statistics past the warm-up.
+    FrameStats frameStats{FRAME_STATS_CNT};
+    size_t     measuredFrameCount = 0;
+    DrawCounts totalDrawCounts{};
     // Initialize the input status (no pressed keys).
     KeyPressStatus keyPressStatus{};
     // Initialize the timings.
-    float  timeDelta = 0.f;
+    Stopwatch updateStopwatch;
     uint64_t cpuTime0, gpuTime0;
     std::tie(cpuTime0, gpuTime0) = engine.getTime();
-    // Main loop.
-    while (true) {
-        // Drain the message queue.
+    // Set up the frame pipeline. The stages of consecutive frames overlap:
+    // e.g. the camera of the next frame is updated, and the objects are culled,
+    // while the current frame is being recorded and submitted.
+    FramePipeline pipeline{STAGE_COUNT, FRAME_CNT};
+    // Per-frame data of the frames in flight, indexed by the frame slot.
+    std::vector<FrameContext> frameContexts(FRAME_CNT, FrameContext{{}, pCam, 0.f, 0.f});
+    pipeline.setStage(UPDATE_STAGE, [&](size_t frameIndex) {
+        FrameContext& frame = frameContexts[pipeline.frameSlot(frameIndex)];
+        // Convert the time step from milliseconds to seconds.
+        const float timeDelta = 1e-3f * updateStopwatch.lap();
+        if (playPathFileName) {
+            // Advance the playback by a fixed time step, independently of the frame time.
+            playPath.applyPose(static_cast<float>(frameIndex) * PLAYBACK_STEP, &pCam);
+        } else {
+            // Compute the camera movement parameters.
+            const float dist  = CAM_SPEED     * timeDelta;
+            const float angle = CAM_ANG_SPEED * timeDelta;
+            float totalDist   = 0.f;
+            float totalPitch  = 0.f;
+            float totalYaw    = 0.f;
+            // Process keyboard input.
+            const KeyPressStatus& keys = frame.keyPressStatus;
+            if (keys.w) totalDist  += dist;
+            if (keys.s) totalDist  -= dist;
+            if (keys.q) totalPitch += angle;
+            if (keys.e) totalPitch -= angle;
+            if (keys.d) totalYaw   += angle;
+            if (keys.a) totalYaw   -= angle;
+            pCam.rotateAndMoveForward(totalPitch, totalYaw, totalDist);
+        }
+        if (recPathFileName) {
+            recPath.record(pCam, recTime);
+            recTime += timeDelta;
+        }
+        frame.camera = pCam;
+    });
+    pipeline.setStage(CULLING_STAGE, [&](size_t frameIndex) {
+        const FrameContext& frame = frameContexts[pipeline.frameSlot(frameIndex)];
+        engine.cullObjects(frameIndex, frame.camera, scene);
+    });
+    // Recording reuses the command lists, so it has to wait for the previous submission.
+    pipeline.setStage(RECORDING_STAGE, [&](size_t frameIndex) {
+        const FrameContext& frame = frameContexts[pipeline.frameSlot(frameIndex)];
+        const PerspectiveCamera& cam = frame.camera;
+        // --> Fork engine tasks.
+        const JobHandle recJob = JobSystem::schedule([&engine, &cam](){
+            engine.recordShadingPass(cam);
+        });
+        engine.recordGBufferPass(frameIndex, cam, scene);
+        // <-- Join engine tasks.
+        JobSystem::wait(recJob);
+    }, SUBMISSION_STAGE);
+    pipeline.setStage(SUBMISSION_STAGE, [&](size_t frameIndex) {
+        FrameContext& frame = frameContexts[pipeline.frameSlot(frameIndex)];
+        engine.renderFrame(frameIndex);
+        // Update the timings.
+        uint64_t cpuTime1, gpuTime1;
+        std::tie(cpuTime1, gpuTime1) = engine.getTime();
+        const uint64_t cpuFrameTime  = cpuTime1 - cpuTime0;
+        const uint64_t gpuFrameTime  = gpuTime1 - gpuTime0;
+        // Convert the frame times from microseconds to milliseconds.
+        frame.cpuFrameTime = cpuFrameTime * 1e-3f;
+        frame.gpuFrameTime = gpuFrameTime * 1e-3f;
+        cpuTime0 = cpuTime1;
+        gpuTime0 = gpuTime1;
+    });
+    // Set once WM_QUIT is received.
+    bool isQuitting = false;
+    int  exitCode   = 0;
+    // Drains the message queue, and processes the keyboard input.
+    // Presentation takes place on a worker thread, and DXGI may have to send messages
+    // to the window (e.g. on mode changes), so the queue must also be drained while waiting.
+    const auto processMessages = [&]() {
         MSG msg;
         while (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE)) {
             // Forward the message to the window.
@@ -73,52 +202,83 @@ int __cdecl main(const int argc, const char* argv[]) {
                     }
                     break;
                 case WM_QUIT:
-                    engine.stop();
-                    // Return this part of the WM_QUIT message to Windows.
-                    return static_cast<int>(msg.wParam);
+                    isQuitting = true;
+                    exitCode   = static_cast<int>(msg.wParam);
+                    break;
             }
         }
-        // Compute the camera movement parameters.
-        {
-            const float dist  = CAM_SPEED     * timeDelta;
-            const float angle = CAM_ANG_SPEED * timeDelta;
-            float totalDist   = 0.f;
-            float totalPitch  = 0.f;
-            float totalYaw    = 0.f;
-            // Process keyboard input.
-            if (keyPressStatus.w) totalDist  += dist;
-            if (keyPressStatus.s) totalDist  -= dist;
-            if (keyPressStatus.q) totalPitch += angle;
-            if (keyPressStatus.e) totalPitch -= angle;
-            if (keyPressStatus.d) totalYaw   += angle;
-            if (keyPressStatus.a) totalYaw   -= angle;
-            pCam.rotateAndMoveForward(totalPitch, totalYaw, totalDist);
+    };
+    // Waits for the oldest frame in flight, and processes its statistics.
+    size_t retiredFrameCount = 0;
+    const auto retireFrame = [&]() {
+        const size_t frameIndex = retiredFrameCount++;
+        pipeline.waitForFrame(frameIndex, processMessages);
+        const FrameContext& frame = frameContexts[pipeline.frameSlot(frameIndex)];
+        Window::displayInfo(frame.cpuFrameTime, frame.gpuFrameTime);
+        // Collect the statistics past the warm-up.
+        if (frameIndex >= warmupFrameCount) {
+            FrameTimings frameTimings = engine.getFrameTimings(frameIndex);
+            frameTimings[FramePhase::CPU_FRAME] = frame.cpuFrameTime;
+            frameTimings[FramePhase::GPU_FRAME] = frame.gpuFrameTime;
+            frameStats.addFrame(frameTimings);
+            ++measuredFrameCount;
+            totalDrawCounts.objDrawCount += engine.getDrawCounts(frameIndex).objDrawCount;
+            totalDrawCounts.drawCount    += engine.getDrawCounts(frameIndex).drawCount;
+            // Stop after the requested number of measured frames.
+            if (measuredFrameCount == maxFrameCount) {
+                PostQuitMessage(0);
+            }
         }
-        // --> Fork engine tasks.
-        auto asyncRec0 = std::async(std::launch::async, [&engine, &pCam, &scene](){
-            // Thread 1.
-            engine.recordGBufferPass(pCam, scene);
-        });
-        auto asyncRec1 = std::async(std::launch::async, [&engine, &pCam](){
-            // Thread 2.
-            engine.recordShadingPass(pCam);
-        });
-        // <-- Join engine tasks.
-        asyncRec0.wait();
-        asyncRec1.wait();
-        engine.renderFrame();
-        // Update the timings.
-        {
-            uint64_t cpuTime1, gpuTime1;
-            std::tie(cpuTime1, gpuTime1) = engine.getTime();
-            const uint64_t cpuFrameTime  = cpuTime1 - cpuTime0;
-            const uint64_t gpuFrameTime  = gpuTime1 - gpuTime0;
-            // Convert the frame times from microseconds to milliseconds.
-            Window::displayInfo(cpuFrameTime * 1e-3f, gpuFrameTime * 1e-3f);
-            // Convert the frame time from microseconds to seconds.
-            timeDelta = static_cast<float>(cpuFrameTime * 1e-6);
-            cpuTime0  = cpuTime1;
-            gpuTime0  = gpuTime1;
+    };
+    // Main loop.
+    while (true) {
+        processMessages();
+        if (isQuitting) {
+            // Complete the frames in flight.
+            while (retiredFrameCount < pipeline.frameCount()) {
+                retireFrame();
+            }
+            JobSystem::stop();
+            // Recycle the memory and the descriptors of the textures.
+            scene.destroyTextures(engine);
+            engine.stop();
+            if (recPathFileName) {
+                recPath.save(recPathFileName);
+            }
+            if (statsFileName) {
+                const std::string fileName{statsFileName};
+                frameStats.writeJson((fileName + ".json").c_str());
+                frameStats.writeCsv((fileName + ".csv").c_str());
+                // Report the effect of draw call coalescing.
+                const double frameCount   = static_cast<double>(
+                                            std::max<size_t>(measuredFrameCount, 1));
+                const double objDrawCount = static_cast<double>(totalDrawCounts.objDrawCount);
+                const double drawCount    = static_cast<double>(totalDrawCounts.drawCount);
+                printInfo("Draws per frame: %.1f before coalescing, %.1f after.",
+                          objDrawCount / frameCount, drawCount / frameCount);
+                // Report the memory usage of the frame arenas.
+                const FrameArenas& frameArenas = engine.getFrameArenas();
+                printInfo("Frame arenas: %zu KiB high-water mark, %zu KiB reserved.",
+                          frameArenas.highWaterMark() / 1024, frameArenas.capacity() / 1024);
+            }
+            // Return this part of the WM_QUIT message to Windows.
+            return exitCode;
+        }
+        const size_t frameIndex = pipeline.frameCount();
+        const float  frameTime  = static_cast<float>(frameIndex) * PLAYBACK_STEP;
+        // Stop once the playback is complete.
+        if (playPathFileName && frameTime > playPath.duration()) {
+            PostQuitMessage(0);
+            continue;
+        }
+        // Retire the oldest frame in flight to make its slot available.
+        if (frameIndex >= FRAME_CNT) {
+            retireFrame();
+            // Do not schedule more frames once WM_QUIT has been received.
+            if (isQuitting) continue;
         }
+        // Provide the input to the next frame, and schedule it.
+        frameContexts[pipeline.frameSlot(frameIndex)].keyPressStatus = keyPressStatus;
+        pipeline.scheduleFrame();
     }
 }
@@ -1,12 +1,13 @@
 #include "GBufferRS.hlsl"
 #include "ShaderMath.hlsl"
 
-Texture2D<float> bumpMap : register(t0);
+Texture2D<float> textures[] : register(t0);
 
-SamplerState     af4Samp : register(s0);
+SamplerState     af4Samp     : register(s0);
 
 cbuffer MaterialId : register(b0) {
     uint matId;
+    uint bumpTexId;
 }
 
 struct InputPS {
@@ -37,8 +38,8 @@ OutputPS main(const InputPS input) {
     // Check whether the bump map flag is raised.
     if (matId & 0x80000000) {
         // Sample the bump map.
-        const float height = bumpMap.SampleGrad(af4Samp, output.uvCoord,
-                                                output.uvGrad.xy, output.uvGrad.zw);
+        const float height = textures[bumpTexId].SampleGrad(af4Samp, output.uvCoord,
+                                                            output.uvGrad.xy, output.uvGrad.zw);
         // Apply the bump map.
         normal = perturbNormal(normal, input.localPos, height);
     }
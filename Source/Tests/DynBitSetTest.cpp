@@ -0,0 +1,121 @@
+#include <random>
+#include <vector>
+#include "Test.h"
+#include "../Common/DynBitSet.hpp"
+
+// Per-bit reference implementation.
+using RefBitSet = std::vector<bool>;
+
+static inline auto generateBitSet(std::mt19937& rng, const size_t size, const double density)
+-> RefBitSet {
+    std::bernoulli_distribution bitDistr{density};
+    RefBitSet bits(size);
+    for (size_t i = 0; i < size; ++i) {
+        bits[i] = bitDistr(rng);
+    }
+    return bits;
+}
+
+static inline auto makeBitSet(const RefBitSet& ref)
+-> DynBitSet {
+    DynBitSet bitSet{ref.size()};
+    for (size_t i = 0; i < ref.size(); ++i) {
+        if (ref[i]) bitSet.setBit(i);
+    }
+    return bitSet;
+}
+
+// Compares all queries of the bit set against the reference.
+static inline void checkBitSet(const DynBitSet& bitSet, const RefBitSet& ref) {
+    CHECK(bitSet.size() == ref.size());
+    size_t refCount = 0;
+    for (size_t i = 0; i < ref.size(); ++i) {
+        CHECK(bitSet.testBit(i) == ref[i]);
+        refCount += ref[i];
+    }
+    CHECK(bitSet.popCount() == refCount);
+    CHECK(bitSet.any()      == (refCount > 0));
+    CHECK(bitSet.none()     == (refCount == 0));
+    // The indices must be visited in the ascending order, and only once.
+    std::vector<size_t> indices;
+    bitSet.forEachSetBit([&indices](const size_t index) {
+        indices.push_back(index);
+    });
+    CHECK(indices.size() == refCount);
+    for (size_t i = 0; i < indices.size(); ++i) {
+        CHECK(indices[i] < ref.size() && ref[indices[i]]);
+        CHECK(0 == i || indices[i - 1] < indices[i]);
+    }
+}
+
+// Checks single bit operations and resets.
+static inline void testBitOps(const size_t size) {
+    DynBitSet bitSet{size};
+    RefBitSet ref(size);
+    checkBitSet(bitSet, ref);
+    // Set the first and the last bit, and the bits next to the dword boundaries.
+    for (size_t i = 0; i < size; ++i) {
+        if (0 == i || size - 1 == i || i % 32 == 0 || i % 32 == 31) {
+            bitSet.setBit(i);
+            ref[i] = true;
+        }
+    }
+    checkBitSet(bitSet, ref);
+    bitSet.toggleBit(size - 1);
+    ref[size - 1] = !ref[size - 1];
+    bitSet.clearBit(0);
+    ref[0] = false;
+    checkBitSet(bitSet, ref);
+    // The padding bits must remain 0, or the population count would exceed the size.
+    bitSet.reset(true);
+    checkBitSet(bitSet, RefBitSet(size, true));
+    bitSet.reset(false);
+    checkBitSet(bitSet, RefBitSet(size, false));
+    // Inverting all bits using XOR must not touch the padding.
+    DynBitSet ones{size};
+    ones.reset(true);
+    bitSet ^= ones;
+    checkBitSet(bitSet, RefBitSet(size, true));
+    bitSet ^= ones;
+    checkBitSet(bitSet, RefBitSet(size, false));
+}
+
+// Checks bulk operations on random sets against the per-bit reference.
+static inline void testBulkOps(std::mt19937& rng, const size_t size) {
+    const double densities[] = {0.0, 0.05, 0.5, 0.95, 1.0};
+    for (const double densA : densities) {
+        for (const double densB : densities) {
+            const RefBitSet refA = generateBitSet(rng, size, densA);
+            const RefBitSet refB = generateBitSet(rng, size, densB);
+            const DynBitSet a    = makeBitSet(refA);
+            const DynBitSet b    = makeBitSet(refB);
+            checkBitSet(a, refA);
+            RefBitSet refAnd(size), refOr(size), refXor(size), refAndNot(size);
+            for (size_t i = 0; i < size; ++i) {
+                refAnd[i]    = refA[i] && refB[i];
+                refOr[i]     = refA[i] || refB[i];
+                refXor[i]    = refA[i] != refB[i];
+                refAndNot[i] = refA[i] && !refB[i];
+            }
+            DynBitSet c{a};
+            checkBitSet(c &= b, refAnd);
+            c = a;
+            checkBitSet(c |= b, refOr);
+            c = a;
+            checkBitSet(c ^= b, refXor);
+            c = a;
+            checkBitSet(c.andNot(b), refAndNot);
+        }
+    }
+}
+
+int main() {
+    std::mt19937 rng{12345};
+    // Sizes around the dword, the qword and the SSE register boundaries.
+    const size_t sizes[] = {1, 31, 32, 33, 63, 64, 65, 127, 128, 129, 1000};
+    for (const size_t size : sizes) {
+        testBitOps(size);
+        testBulkOps(rng, size);
+    }
+    return finishTest("DynBitSetTest");
+}
@@ -0,0 +1,119 @@
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "Test.h"
+#include "../Common/DynBitSet.hpp"
+#include "../Common/HierBitSet.hpp"
+
+// Generates a sparse set: most 4096-bit blocks are empty, and the rest have the given density.
+static inline auto generateIndices(std::mt19937& rng, const size_t size, const double density)
+-> std::vector<size_t> {
+    std::bernoulli_distribution blockDistr{0.25};
+    std::bernoulli_distribution bitDistr{density};
+    std::vector<size_t> indices;
+    for (size_t block = 0; block < size; block += 4096) {
+        if (!blockDistr(rng)) continue;
+        for (size_t i = block; i < std::min(size, block + 4096); ++i) {
+            if (bitDistr(rng)) indices.push_back(i);
+        }
+    }
+    return indices;
+}
+
+// Compares all queries of the set against the reference.
+static inline void checkBitSet(const HierBitSet& bitSet, const DynBitSet& ref) {
+    CHECK(bitSet.size()     == ref.size());
+    CHECK(bitSet.popCount() == ref.popCount());
+    CHECK(bitSet.any()      == ref.any());
+    CHECK(bitSet.none()     == ref.none());
+    for (size_t i = 0; i < ref.size(); ++i) {
+        CHECK(bitSet.testBit(i) == ref.testBit(i));
+    }
+    // The summary must cover every non-empty word, so that iteration visits every index
+    // in the ascending order, and only once.
+    std::vector<size_t> indices, refIndices;
+    bitSet.forEachSetBit([&indices](const size_t index) {
+        indices.push_back(index);
+    });
+    ref.forEachSetBit([&refIndices](const size_t index) {
+        refIndices.push_back(index);
+    });
+    CHECK(indices == refIndices);
+}
+
+// Checks single bit operations and clearing.
+static inline void testBitOps(std::mt19937& rng, const size_t size) {
+    HierBitSet bitSet{size};
+    DynBitSet  ref{size};
+    checkBitSet(bitSet, ref);
+    for (const size_t index : generateIndices(rng, size, 0.01)) {
+        bitSet.setBit(index);
+        ref.setBit(index);
+    }
+    checkBitSet(bitSet, ref);
+    // Clear a half of the bits. Words which become empty must be removed from the summary.
+    for (const size_t index : generateIndices(rng, size, 0.5)) {
+        bitSet.clearBit(index);
+        ref.clearBit(index);
+    }
+    checkBitSet(bitSet, ref);
+    bitSet.setBit(size - 1);
+    ref.setBit(size - 1);
+    bitSet.clearBit(size - 1);
+    ref.clearBit(size - 1);
+    checkBitSet(bitSet, ref);
+    // Clearing only touches the non-empty words, and must leave the summary empty.
+    bitSet.clear();
+    ref.reset(false);
+    checkBitSet(bitSet, ref);
+    // The set must remain usable after clearing.
+    bitSet.setBit(0);
+    ref.setBit(0);
+    checkBitSet(bitSet, ref);
+}
+
+// Checks union and intersection of random sparse sets.
+static inline void testBulkOps(std::mt19937& rng, const size_t size) {
+    const double densities[] = {0.0, 0.001, 0.1, 1.0};
+    for (const double densA : densities) {
+        for (const double densB : densities) {
+            HierBitSet a{size}, b{size}, c{size};
+            DynBitSet  refA{size}, refB{size};
+            for (const size_t index : generateIndices(rng, size, densA)) {
+                a.setBit(index);
+                c.setBit(index);
+                refA.setBit(index);
+            }
+            for (const size_t index : generateIndices(rng, size, densB)) {
+                b.setBit(index);
+                refB.setBit(index);
+            }
+            DynBitSet refOr{refA}, refAnd{refA};
+            refOr  |= refB;
+            refAnd &= refB;
+            a |= b;
+            checkBitSet(a, refOr);
+            c &= b;
+            checkBitSet(c, refAnd);
+            // Intersection with the union must not change the set.
+            c &= a;
+            checkBitSet(c, refAnd);
+            // Clearing the result must restore an empty summary.
+            a.clear();
+            checkBitSet(a, DynBitSet{size});
+        }
+    }
+}
+
+int main() {
+    std::mt19937 rng{12345};
+    // Sizes around the word and the summary word (4096 bits) boundaries.
+    const size_t sizes[] = {1, 63, 64, 65, 4095, 4096, 4097, 100000};
+    for (const size_t size : sizes) {
+        for (size_t t = 0; t < 4; ++t) {
+            testBitOps(rng, size);
+        }
+        testBulkOps(rng, size);
+    }
+    return finishTest("HierBitSetTest");
+}
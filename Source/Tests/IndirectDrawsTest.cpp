@@ -0,0 +1,242 @@
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "Test.h"
+#include "../Common/DrawEncoding.h"
+#include "../Common/IndirectDraws.hpp"
+#include "../Common/JobSystem.h"
+
+// Root parameter of the per-draw root constants (as in the G-buffer pass).
+static constexpr uint32_t ROOT_PARAM = 1;
+
+// Draw call recorded by the reference encoder.
+struct ReferenceDraw {
+    uint32_t rootConstants[IndirectDraw::rootConstantCount];
+    uint32_t indexCount;
+    uint32_t firstIndex;
+};
+
+// Command encoder which records the draws together with the root constants set at the time.
+struct ReferenceEncoder {
+    void setRootConstants(const uint32_t param, const uint32_t count, const void* data,
+                          const uint32_t offset) {
+        CHECK(ROOT_PARAM == param && offset + count <= IndirectDraw::rootConstantCount);
+        memcpy(&rootConstants[offset], data, count * sizeof(uint32_t));
+        isSet = true;
+    }
+    void drawIndexed(const uint32_t indexCount, const uint32_t firstIndex) {
+        // Each range starts without a material set.
+        CHECK(isSet);
+        draws.push_back(ReferenceDraw{{rootConstants[0], rootConstants[1]},
+                                      indexCount, firstIndex});
+    }
+public:
+    uint32_t                   rootConstants[IndirectDraw::rootConstantCount] = {};
+    bool                       isSet = false;
+    std::vector<ReferenceDraw> draws;
+};
+
+// Test scene: objects sorted by material, with adjacent index ranges (like the scene loader).
+struct TestScene {
+    std::vector<DrawPacket> drawPackets;
+    uint32_t                indexCount;
+};
+
+static inline auto generateScene(std::mt19937& rng, const size_t objCount)
+-> TestScene {
+    std::uniform_int_distribution<uint32_t> matDistr{0, 15};
+    std::uniform_int_distribution<uint32_t> triDistr{1, 100};
+    std::vector<uint16_t> matIds(objCount);
+    for (uint16_t& matId : matIds) {
+        matId = static_cast<uint16_t>(matDistr(rng));
+    }
+    std::sort(matIds.begin(), matIds.end());
+    TestScene scene;
+    scene.indexCount = 0;
+    for (size_t i = 0; i < objCount; ++i) {
+        // Every third material has a bump map.
+        const uint32_t bumpTexId = (0 == matIds[i] % 3) ? 100u + matIds[i] : UINT32_MAX;
+        const uint32_t indexCount = 3 * triDistr(rng);
+        scene.drawPackets.push_back(makeDrawPacket(indexCount, scene.indexCount, matIds[i],
+                                                   bumpTexId));
+        scene.indexCount += indexCount;
+    }
+    return scene;
+}
+
+// Generates the sorted visible objects: a random subset, in a random order
+// which preserves some runs of neighboring objects (in either direction).
+static inline auto generateVisibleObjects(std::mt19937& rng, const size_t objCount)
+-> std::vector<ObjectSortPair> {
+    std::vector<ObjectSortPair> objSortPairs;
+    std::bernoulli_distribution visDistr{0.7};
+    for (uint32_t i = 0; i < objCount; ++i) {
+        if (visDistr(rng)) {
+            ObjectSortPair pair;
+            pair.key.integer = 0;
+            pair.index       = i;
+            objSortPairs.push_back(pair);
+        }
+    }
+    // Shuffle runs of up to 8 objects, and reverse some of them.
+    std::uniform_int_distribution<size_t> runDistr{1, 8};
+    std::vector<std::vector<ObjectSortPair>> runs;
+    for (size_t i = 0, n = objSortPairs.size(); i < n; ) {
+        const size_t end = std::min(n, i + runDistr(rng));
+        runs.emplace_back(objSortPairs.begin() + i, objSortPairs.begin() + end);
+        if (rng() % 2) {
+            std::reverse(runs.back().begin(), runs.back().end());
+        }
+        i = end;
+    }
+    std::shuffle(runs.begin(), runs.end(), rng);
+    objSortPairs.clear();
+    for (const auto& run : runs) {
+        objSortPairs.insert(objSortPairs.end(), run.begin(), run.end());
+    }
+    return objSortPairs;
+}
+
+// Compares the records of the range against the reference encoder,
+// and checks that they cover the indices of each visible object exactly once.
+static inline void checkRange(const TestScene& scene, const DrawRange& range,
+                              const ObjectSortPair* objSortPairs, const IndirectDraw* draws,
+                              const DrawCounts& counts) {
+    ReferenceEncoder encoder;
+    const DrawCounts refCounts = encodeDraws(encoder, range, objSortPairs,
+                                             scene.drawPackets.data());
+    CHECK(counts.objDrawCount   == refCounts.objDrawCount);
+    CHECK(counts.drawCount      == refCounts.drawCount);
+    CHECK(counts.matChangeCount == refCounts.matChangeCount);
+    CHECK(counts.objDrawCount   == range.end - range.begin);
+    CHECK(counts.drawCount      == encoder.draws.size());
+    const size_t drawCount = std::min(counts.drawCount, encoder.draws.size());
+    for (size_t i = 0; i < drawCount; ++i) {
+        const IndirectDraw&  draw = draws[i];
+        const ReferenceDraw& ref  = encoder.draws[i];
+        CHECK(draw.rootConstants[0]          == ref.rootConstants[0]);
+        CHECK(draw.rootConstants[1]          == ref.rootConstants[1]);
+        CHECK(draw.args.indexCountPerInstance == ref.indexCount);
+        CHECK(draw.args.instanceCount         == 1);
+        CHECK(draw.args.startIndexLocation    == ref.firstIndex);
+        CHECK(draw.args.baseVertexLocation    == 0);
+        CHECK(draw.args.startInstanceLocation == 0);
+    }
+    // Each index of a visible object must be drawn exactly once,
+    // with the root constants (material ID and bump map index) of the object.
+    std::vector<uint32_t> drawIds(scene.indexCount, UINT32_MAX);
+    for (uint32_t i = 0; i < drawCount; ++i) {
+        const DrawIndexedArgs& args = draws[i].args;
+        CHECK(args.startIndexLocation + args.indexCountPerInstance <= scene.indexCount);
+        const uint32_t end = std::min(args.startIndexLocation + args.indexCountPerInstance,
+                                      scene.indexCount);
+        for (uint32_t k = args.startIndexLocation; k < end; ++k) {
+            CHECK(UINT32_MAX == drawIds[k]);
+            drawIds[k] = i;
+        }
+    }
+    for (size_t i = range.begin; i < range.end; ++i) {
+        const DrawPacket& packet = scene.drawPackets[objSortPairs[i].index];
+        for (uint32_t k = packet.firstIndex; k < packet.firstIndex + packet.indexCount; ++k) {
+            CHECK(drawIds[k] < drawCount);
+            if (drawIds[k] >= drawCount) break;
+            const IndirectDraw& draw = draws[drawIds[k]];
+            CHECK(draw.rootConstants[0] == packet.matConstant);
+            CHECK(draw.rootConstants[1] == packet.bumpTexId);
+        }
+    }
+    size_t objIndexCount = 0, drawIndexCount = 0;
+    for (size_t i = range.begin; i < range.end; ++i) {
+        objIndexCount += scene.drawPackets[objSortPairs[i].index].indexCount;
+    }
+    for (size_t i = 0; i < drawCount; ++i) {
+        drawIndexCount += draws[i].args.indexCountPerInstance;
+    }
+    CHECK(objIndexCount == drawIndexCount);
+}
+
+// Checks the encoding of the root constants.
+static inline void testDrawPackets() {
+    const DrawPacket bumpy = makeDrawPacket(36, 12, 7, 42);
+    CHECK(bumpy.indexCount  == 36);
+    CHECK(bumpy.firstIndex  == 12);
+    CHECK(bumpy.matConstant == ((1u << 31) | 7));
+    CHECK(bumpy.bumpTexId   == 42);
+    const DrawPacket flat  = makeDrawPacket(3, 0, 65535, UINT32_MAX);
+    CHECK(flat.matConstant  == 65535);
+    CHECK(flat.bumpTexId    == UINT32_MAX);
+}
+
+// Checks the coalescing of draws in a hand-written case.
+static inline void testCoalescing() {
+    // Objects 0-2 share material 1 and are adjacent, object 3 has material 2.
+    const DrawPacket drawPackets[] = {
+        makeDrawPacket(3, 0,  1, UINT32_MAX), makeDrawPacket(6, 3,  1, UINT32_MAX),
+        makeDrawPacket(9, 9,  1, UINT32_MAX), makeDrawPacket(3, 18, 2, 5)
+    };
+    // Visible order: 1, 0 (merged backwards), 3 (new material), 2 (material changes back).
+    ObjectSortPair objSortPairs[4];
+    const uint32_t order[4] = {1, 0, 3, 2};
+    for (size_t i = 0; i < 4; ++i) {
+        objSortPairs[i].key.integer = static_cast<int32_t>(i);
+        objSortPairs[i].index       = order[i];
+    }
+    IndirectDraw draws[4];
+    const DrawCounts counts = buildIndirectDraws(DrawRange{0, 4}, objSortPairs, drawPackets,
+                                                 ROOT_PARAM, draws);
+    CHECK(counts.objDrawCount   == 4);
+    CHECK(counts.drawCount      == 3);
+    CHECK(counts.matChangeCount == 3);
+    CHECK(draws[0].args.startIndexLocation == 0 && draws[0].args.indexCountPerInstance == 9);
+    CHECK(draws[0].rootConstants[0] == 1 && draws[0].rootConstants[1] == UINT32_MAX);
+    CHECK(draws[1].args.startIndexLocation == 18 && draws[1].args.indexCountPerInstance == 3);
+    CHECK(draws[1].rootConstants[0] == ((1u << 31) | 2) && draws[1].rootConstants[1] == 5);
+    CHECK(draws[2].args.startIndexLocation == 9 && draws[2].args.indexCountPerInstance == 9);
+    CHECK(draws[2].rootConstants[0] == 1 && draws[2].rootConstants[1] == UINT32_MAX);
+}
+
+// Builds the records of random scenes split into command lists,
+// and compares them against the reference encoder.
+static inline void testRandomScenes(const bool isParallel) {
+    std::mt19937 rng{12345};
+    for (size_t t = 0; t < 64; ++t) {
+        const size_t objCount = 1 + rng() % 4000;
+        const TestScene scene = generateScene(rng, objCount);
+        const std::vector<ObjectSortPair> objSortPairs = generateVisibleObjects(rng, objCount);
+        const size_t count     = objSortPairs.size();
+        const size_t listCount = computeCommandListCount(count, 1 + t % 8, 8, 64);
+        std::vector<IndirectDraw> draws(std::max(count, size_t{1}));
+        std::vector<DrawCounts>   counts(listCount);
+        const auto buildRange = [&](size_t listIndex, DrawRange range) {
+            counts[listIndex] = buildIndirectDraws(range, objSortPairs.data(),
+                                                   scene.drawPackets.data(), ROOT_PARAM,
+                                                   &draws[range.begin]);
+        };
+        if (isParallel) {
+            recordDraws(count, listCount, buildRange);
+        } else {
+            for (size_t k = 0; k < listCount; ++k) {
+                buildRange(k, computeDrawRange(count, listCount, k));
+            }
+        }
+        // The ranges must partition the visible objects.
+        size_t end = 0;
+        for (size_t k = 0; k < listCount; ++k) {
+            const DrawRange range = computeDrawRange(count, listCount, k);
+            CHECK(range.begin == end);
+            end = range.end;
+            checkRange(scene, range, objSortPairs.data(), &draws[range.begin], counts[k]);
+        }
+        CHECK(end == count);
+    }
+}
+
+int main() {
+    JobSystem::start();
+    testDrawPackets();
+    testCoalescing();
+    testRandomScenes(false);
+    testRandomScenes(true);
+    JobSystem::stop();
+    return finishTest("IndirectDrawsTest");
+}
@@ -0,0 +1,231 @@
+#include <initializer_list>
+#include <vector>
+#include "Test.h"
+#include "../Common/RenderGraph.h"
+
+using Barrier    = RenderGraph::Barrier;
+using ResourceId = RenderGraph::ResourceId;
+
+// Resource states (bit masks, like D3D12_RESOURCE_STATES).
+static constexpr uint32_t COMMON      = 0x0;
+static constexpr uint32_t RT          = 0x4;
+static constexpr uint32_t UAV         = 0x8;
+static constexpr uint32_t DEPTH_WRITE = 0x10;
+static constexpr uint32_t NPS_READ    = 0x40;
+static constexpr uint32_t PS_READ     = 0x80;
+static constexpr uint32_t COPY_SRC    = 0x800;
+
+static inline auto transition(const ResourceId resource, const uint32_t before,
+                              const uint32_t after, const Barrier::Split split)
+-> Barrier {
+    return Barrier{Barrier::Type::TRANSITION, split, resource, before, after};
+}
+
+static inline auto aliasing(const ResourceId resource)
+-> Barrier {
+    return Barrier{Barrier::Type::ALIASING, Barrier::Split::NONE, resource, 0, 0};
+}
+
+// Compares the batch with the expected barriers, including their order.
+static inline void checkBatch(const std::vector<Barrier>& batch,
+                              const std::initializer_list<Barrier> expected) {
+    CHECK(batch.size() == expected.size());
+    if (batch.size() != expected.size()) return;
+    size_t i = 0;
+    for (const Barrier& barrier : expected) {
+        CHECK(batch[i].type     == barrier.type);
+        CHECK(batch[i].split    == barrier.split);
+        CHECK(batch[i].resource == barrier.resource);
+        CHECK(batch[i].before   == barrier.before);
+        CHECK(batch[i].after    == barrier.after);
+        ++i;
+    }
+}
+
+// Checks the transitions of imported and looped resources: the transitions into and out of
+// the graph, merging of consecutive reads, and the placement of split barriers.
+static inline void testPersistentResources() {
+    constexpr auto NONE  = Barrier::Split::NONE;
+    constexpr auto BEGIN = Barrier::Split::BEGIN;
+    constexpr auto END   = Barrier::Split::END;
+    RenderGraph graph;
+    // Written by pass 1, then read in different states by passes 2 and 3.
+    const ResourceId r = graph.importResource(COMMON);
+    // Written by pass 0, and read by pass 3.
+    const ResourceId s = graph.importResource(COPY_SRC);
+    // Only written by pass 0.
+    const ResourceId t = graph.importResource(COMMON);
+    // Used in the state it is imported in.
+    const ResourceId u = graph.importResource(PS_READ);
+    // Like the G-buffer: written by pass 1, and read by pass 2.
+    const ResourceId l = graph.importLoopedResource();
+    // Used in the same state by every pass.
+    const ResourceId m = graph.importLoopedResource();
+    // Never used.
+    graph.importResource(RT);
+    graph.importLoopedResource();
+    const RenderGraph::PassId p0 = graph.addPass();
+    const RenderGraph::PassId p1 = graph.addPass();
+    const RenderGraph::PassId p2 = graph.addPass();
+    const RenderGraph::PassId p3 = graph.addPass();
+    graph.write(p0, s, UAV);
+    graph.write(p0, t, RT);
+    graph.write(p0, m, DEPTH_WRITE);
+    graph.read(p0, u, PS_READ);
+    graph.write(p1, r, RT);
+    graph.write(p1, l, RT);
+    graph.write(p1, m, DEPTH_WRITE);
+    graph.read(p2, r, PS_READ);
+    graph.read(p2, l, PS_READ);
+    graph.read(p2, l, NPS_READ);
+    graph.write(p2, m, DEPTH_WRITE);
+    graph.read(p3, r, NPS_READ);
+    graph.read(p3, s, PS_READ);
+    graph.compile();
+    CHECK(graph.passCount() == 4);
+    checkBatch(graph.barriers(p0), {
+        transition(r, COMMON, RT, BEGIN),
+        transition(s, COPY_SRC, UAV, NONE),
+        transition(t, COMMON, RT, NONE)
+    });
+    checkBatch(graph.barriers(p1), {
+        transition(r, COMMON, RT, END),
+        transition(s, UAV, PS_READ, BEGIN),
+        transition(t, RT, COMMON, BEGIN),
+        // The transition has begun after the previous execution of the graph.
+        transition(l, PS_READ | NPS_READ, RT, END)
+    });
+    checkBatch(graph.barriers(p2), {
+        // Both reads are merged into a single state.
+        transition(r, RT, PS_READ | NPS_READ, NONE),
+        transition(l, RT, PS_READ | NPS_READ, NONE)
+    });
+    checkBatch(graph.barriers(p3), {
+        transition(s, UAV, PS_READ, END)
+    });
+    checkBatch(graph.finalBarriers(), {
+        transition(r, PS_READ | NPS_READ, COMMON, NONE),
+        transition(s, PS_READ, COPY_SRC, NONE),
+        transition(t, RT, COMMON, END),
+        transition(l, PS_READ | NPS_READ, RT, BEGIN)
+    });
+    // The first execution requires the transition to be begun up front.
+    checkBatch(graph.initialBarriers(), {
+        transition(l, PS_READ | NPS_READ, RT, BEGIN)
+    });
+    CHECK(graph.transientHeapSize() == 0);
+}
+
+// Checks the memory layout of transient resources with overlapping and disjoint lifetimes,
+// their transitions, and the aliasing barriers.
+static inline void testTransientResources() {
+    constexpr auto NONE = Barrier::Split::NONE;
+    RenderGraph graph;
+    const ResourceId a = graph.createTransient(1000, 256);    // Passes 0-1
+    const ResourceId b = graph.createTransient(500,  256);    // Passes 1-2
+    const ResourceId c = graph.createTransient(800,  256);    // Passes 2-3
+    const ResourceId d = graph.createTransient(200,  1024);   // Pass 3
+    const RenderGraph::PassId p0 = graph.addPass();
+    const RenderGraph::PassId p1 = graph.addPass();
+    const RenderGraph::PassId p2 = graph.addPass();
+    const RenderGraph::PassId p3 = graph.addPass();
+    graph.write(p0, a, RT);
+    graph.read(p1, a, PS_READ);
+    graph.write(p1, b, RT);
+    graph.read(p2, b, PS_READ);
+    graph.write(p2, c, UAV);
+    graph.read(p3, c, NPS_READ);
+    graph.write(p3, d, RT);
+    graph.compile();
+    // Larger resources are placed first. 'c' is disjoint from 'a', so it shares its memory.
+    // 'b' overlaps both 'a' and 'c', so it is placed after them (with the alignment).
+    // 'd' only overlaps 'c', so it shares the memory of 'b'.
+    CHECK(graph.transientOffset(a) == 0);
+    CHECK(graph.transientOffset(c) == 0);
+    CHECK(graph.transientOffset(b) == 1024);
+    CHECK(graph.transientOffset(d) == 1024);
+    CHECK(graph.transientHeapSize() == 1524);
+    // Transient resources are created in the state of their first use, and they return
+    // to it after the last use. Resources sharing memory require an aliasing barrier
+    // before the first use.
+    checkBatch(graph.barriers(p0), {
+        aliasing(a)
+    });
+    checkBatch(graph.barriers(p1), {
+        transition(a, RT, PS_READ, NONE),
+        aliasing(b)
+    });
+    checkBatch(graph.barriers(p2), {
+        transition(a, PS_READ, RT, NONE),
+        transition(b, RT, PS_READ, NONE),
+        aliasing(c)
+    });
+    checkBatch(graph.barriers(p3), {
+        transition(b, PS_READ, RT, NONE),
+        transition(c, UAV, NPS_READ, NONE),
+        aliasing(d)
+    });
+    checkBatch(graph.finalBarriers(), {
+        transition(c, NPS_READ, UAV, NONE)
+    });
+    checkBatch(graph.initialBarriers(), {});
+}
+
+// Checks that transient resources used at the same time never share memory,
+// and that no aliasing barriers are required then.
+static inline void testOverlappingLifetimes() {
+    RenderGraph graph;
+    const ResourceId a = graph.createTransient(300, 256);
+    const ResourceId b = graph.createTransient(100, 64);
+    const ResourceId c = graph.createTransient(200, 512);
+    const RenderGraph::PassId p0 = graph.addPass();
+    const RenderGraph::PassId p1 = graph.addPass();
+    graph.write(p0, a, RT);
+    graph.write(p0, b, RT);
+    graph.write(p0, c, UAV);
+    graph.read(p1, a, PS_READ);
+    graph.read(p1, c, PS_READ);
+    graph.compile();
+    CHECK(graph.transientOffset(a) == 0);
+    CHECK(graph.transientOffset(c) == 512);
+    CHECK(graph.transientOffset(b) == 320);
+    CHECK(graph.transientHeapSize() == 712);
+    checkBatch(graph.barriers(p0), {});
+    checkBatch(graph.barriers(p1), {
+        transition(a, RT, PS_READ, Barrier::Split::NONE),
+        transition(c, UAV, PS_READ, Barrier::Split::NONE)
+    });
+    checkBatch(graph.finalBarriers(), {
+        transition(a, PS_READ, RT, Barrier::Split::NONE),
+        transition(c, PS_READ, UAV, Barrier::Split::NONE)
+    });
+}
+
+// Checks that transient resources used by disjoint passes share memory.
+static inline void testDisjointLifetimes() {
+    RenderGraph graph;
+    std::vector<ResourceId> resources;
+    for (size_t i = 0; i < 4; ++i) {
+        resources.push_back(graph.createTransient(4096 - 1024 * i, 1024));
+        const RenderGraph::PassId pass = graph.addPass();
+        graph.write(pass, resources.back(), RT);
+    }
+    graph.compile();
+    CHECK(graph.transientHeapSize() == 4096);
+    for (size_t i = 0; i < 4; ++i) {
+        const RenderGraph::PassId pass = static_cast<RenderGraph::PassId>(i);
+        CHECK(graph.transientOffset(resources[i]) == 0);
+        checkBatch(graph.barriers(pass), {
+            aliasing(resources[i])
+        });
+    }
+    checkBatch(graph.finalBarriers(), {});
+}
+
+int main() {
+    testPersistentResources();
+    testTransientResources();
+    testOverlappingLifetimes();
+    testDisjointLifetimes();
+    return finishTest("RenderGraphTest");
+}
@@ -0,0 +1,161 @@
+#include <algorithm>
+#include <deque>
+#include <random>
+#include <vector>
+#include "Test.h"
+#include "../Common/SlotAllocator.h"
+
+static inline bool isValidIndex(const SlotHandle handle) {
+    return handle.index != UINT32_MAX;
+}
+
+// Checks that unused slots are allocated in order, and that a full table fails to allocate.
+static inline void testExhaustion() {
+    SlotAllocator slots{8};
+    for (uint32_t i = 0; i < 8; ++i) {
+        const SlotHandle handle = slots.allocate();
+        CHECK(handle.index == i && handle.generation == 0);
+        CHECK(slots.isValid(handle));
+    }
+    CHECK(slots.size() == 8 && slots.capacity() == 8);
+    CHECK(!isValidIndex(slots.allocate()));
+    // Handles of slots which have never been allocated are invalid.
+    SlotAllocator empty{8};
+    CHECK(!empty.isValid(SlotHandle{0, 0}));
+    CHECK(!empty.isValid(SlotHandle{UINT32_MAX, 0}));
+}
+
+// Checks that the handles become stale once the slot is freed, and remain stale after reuse.
+static inline void testStaleHandles() {
+    SlotAllocator slots{4};
+    const SlotHandle a = slots.allocate();
+    slots.free(a, 1);
+    CHECK(!slots.isValid(a));
+    // The slot is still in use by the GPU, so it is not reused yet.
+    CHECK(slots.size() == 1);
+    const SlotHandle b = slots.allocate();
+    CHECK(b.index == 1);
+    slots.reclaim(1);
+    CHECK(slots.size() == 1);
+    const SlotHandle c = slots.allocate();
+    CHECK(c.index == a.index && c.generation == a.generation + 1);
+    CHECK(slots.isValid(c) && !slots.isValid(a));
+    // Reuse the slot many times. None of the previous handles may become valid again.
+    std::vector<SlotHandle> staleHandles{a};
+    SlotHandle handle = c;
+    for (uint64_t fenceValue = 2; fenceValue < 100; ++fenceValue) {
+        slots.free(handle, fenceValue);
+        slots.reclaim(fenceValue);
+        staleHandles.push_back(handle);
+        handle = slots.allocate();
+        CHECK(handle.index == a.index);
+    }
+    for (const SlotHandle& stale : staleHandles) {
+        CHECK(!slots.isValid(stale));
+    }
+    CHECK(slots.isValid(handle) && slots.isValid(b));
+}
+
+// Checks that the most recently recycled slot is reused first.
+static inline void testLifoReuse() {
+    SlotAllocator slots{16};
+    SlotHandle handles[8];
+    for (SlotHandle& handle : handles) {
+        handle = slots.allocate();
+    }
+    slots.free(handles[2], 1);
+    slots.free(handles[5], 1);
+    slots.free(handles[3], 1);
+    slots.reclaim(1);
+    CHECK(slots.allocate().index == 3);
+    CHECK(slots.allocate().index == 5);
+    CHECK(slots.allocate().index == 2);
+    // Once the free list is empty, the unused slots are allocated.
+    CHECK(slots.allocate().index == 8);
+}
+
+// Checks that the slots are only recycled once the fence reaches their values.
+static inline void testReclaim() {
+    SlotAllocator slots{16};
+    SlotHandle handles[4];
+    for (SlotHandle& handle : handles) {
+        handle = slots.allocate();
+    }
+    slots.free(handles[0], 5);
+    slots.free(handles[1], 5);
+    slots.free(handles[2], 7);
+    slots.reclaim(4);
+    CHECK(slots.size() == 4);
+    slots.reclaim(6);
+    CHECK(slots.size() == 2);
+    slots.reclaim(6);
+    CHECK(slots.size() == 2);
+    slots.reclaim(100);
+    CHECK(slots.size() == 1);
+    // Reclaiming with a smaller value has no effect.
+    slots.free(handles[3], 101);
+    slots.reclaim(100);
+    CHECK(slots.size() == 1);
+    slots.reclaim(101);
+    CHECK(slots.size() == 0);
+}
+
+// Allocates and frees random slots, and compares the result with a reference model.
+static inline void testRandom() {
+    constexpr size_t capacity = 64;
+    SlotAllocator slots{capacity};
+    std::mt19937 rng{12345};
+    std::vector<SlotHandle> live, stale;
+    std::deque<std::pair<uint32_t, uint64_t>> pending;     // Index and fence value
+    std::vector<bool> isUsed(capacity);                     // Allocated or pending
+    uint64_t fenceValue = 0, completedValue = 0;
+    for (size_t i = 0; i < 20000; ++i) {
+        const uint32_t op = rng() % 4;
+        if (op < 2) {
+            const SlotHandle handle = slots.allocate();
+            size_t usedCount = 0;
+            for (const bool used : isUsed) usedCount += used;
+            CHECK(isValidIndex(handle) == (usedCount < capacity));
+            if (isValidIndex(handle)) {
+                CHECK(handle.index < capacity && !isUsed[handle.index]);
+                CHECK(slots.isValid(handle));
+                isUsed[handle.index] = true;
+                live.push_back(handle);
+            }
+        } else if (op == 2 && !live.empty()) {
+            const size_t k = rng() % live.size();
+            slots.free(live[k], fenceValue + 1);
+            pending.emplace_back(live[k].index, fenceValue + 1);
+            stale.push_back(live[k]);
+            live.erase(live.begin() + k);
+        } else {
+            // Submit a frame, and complete the frames with a delay.
+            const uint64_t lag = rng() % 3;
+            fenceValue++;
+            if (fenceValue > lag) {
+                completedValue = std::max(completedValue, fenceValue - lag);
+            }
+            slots.reclaim(completedValue);
+            while (!pending.empty() && pending.front().second <= completedValue) {
+                isUsed[pending.front().first] = false;
+                pending.pop_front();
+            }
+        }
+        CHECK(slots.size() == live.size() + pending.size());
+    }
+    for (const SlotHandle& handle : live) {
+        CHECK(slots.isValid(handle));
+    }
+    for (const SlotHandle& handle : stale) {
+        CHECK(!slots.isValid(handle));
+    }
+}
+
+int main() {
+    testExhaustion();
+    testStaleHandles();
+    testLifoReuse();
+    testReclaim();
+    testRandom();
+    return finishTest("SlotAllocatorTest");
+}
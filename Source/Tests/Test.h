@@ -0,0 +1,33 @@
+#pragma once
+
+#include "../Common/Utility.h"
+
+// Minimal test harness. Each test is a separate executable,
+// which returns a non-zero exit code if any of its checks has failed.
+
+// Number of failed checks. Only the first few failures are reported.
+static size_t g_failedCheckCount = 0;
+
+// For internal use only!
+static inline void reportFailure(const char* cond, const char* file, const int line) {
+    if (g_failedCheckCount++ < 16) {
+        printError("Check failed: %s (%s : %i)", cond, file, line);
+    }
+}
+
+// Checks the condition. Unlike assert(), it is also evaluated in release builds,
+// and a failure does not abort the test.
+#define CHECK(cond)                                            \
+    do {                                                       \
+        if (!(cond)) reportFailure(#cond, __FILE__, __LINE__); \
+    } while (0)
+
+// Reports the result of the test, and returns the exit code.
+static inline int finishTest(const char* testName) {
+    if (g_failedCheckCount > 0) {
+        printError("%s: %zu checks failed.", testName, g_failedCheckCount);
+        return 1;
+    }
+    printInfo("%s: all checks passed.", testName);
+    return 0;
+}
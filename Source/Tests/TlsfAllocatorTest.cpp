@@ -0,0 +1,245 @@
+#include <algorithm>
+#include <iterator>
+#include <map>
+#include <random>
+#include <vector>
+#include "Test.h"
+#include "../Common/TlsfAllocator.h"
+
+// Allocations are made in granules of 64 KiB (like placed resources).
+static constexpr size_t GRANULARITY = 64 * 1024;
+
+// Live allocations, keyed by offset. Used to check that the allocations do not overlap.
+using AllocationMap = std::map<size_t, TlsfAllocator::Allocation>;
+
+static inline bool isValid(const TlsfAllocator::Allocation& alloc) {
+    return alloc.block != TlsfAllocator::INVALID_BLOCK;
+}
+
+// Checks the allocation, and adds it to the map.
+static inline void checkAllocation(const TlsfAllocator::Allocation& alloc, const size_t size,
+                                   const size_t alignment, const size_t capacity,
+                                   AllocationMap& allocs) {
+    CHECK(alloc.offset % std::max(alignment, GRANULARITY) == 0);
+    CHECK(alloc.size == (size + GRANULARITY - 1) / GRANULARITY * GRANULARITY);
+    CHECK(alloc.offset + alloc.size <= capacity);
+    const auto next = allocs.lower_bound(alloc.offset);
+    if (next != allocs.end()) {
+        CHECK(alloc.offset + alloc.size <= next->second.offset);
+    }
+    if (next != allocs.begin()) {
+        const auto prev = std::prev(next);
+        CHECK(prev->second.offset + prev->second.size <= alloc.offset);
+    }
+    allocs[alloc.offset] = alloc;
+}
+
+// Compares the statistics with the live allocations.
+static inline void checkStats(const TlsfAllocator& allocator, const size_t capacity,
+                              const AllocationMap& allocs) {
+    const TlsfAllocator::Stats stats = allocator.computeStats();
+    size_t usedSize = 0;
+    for (const auto& pair : allocs) {
+        usedSize += pair.second.size;
+    }
+    CHECK(stats.capacity        == capacity);
+    CHECK(stats.usedSize        == usedSize);
+    CHECK(stats.freeSize        == capacity - usedSize);
+    CHECK(stats.allocationCount == allocs.size());
+    CHECK(stats.largestFreeSize <= stats.freeSize);
+    // The free blocks are merged, so the gaps between the allocations are the free blocks.
+    size_t freeBlockCount = 0, largestFreeSize = 0, end = 0;
+    for (const auto& pair : allocs) {
+        if (pair.second.offset > end) {
+            freeBlockCount++;
+            largestFreeSize = std::max(largestFreeSize, pair.second.offset - end);
+        }
+        end = pair.second.offset + pair.second.size;
+    }
+    if (capacity > end) {
+        freeBlockCount++;
+        largestFreeSize = std::max(largestFreeSize, capacity - end);
+    }
+    CHECK(stats.freeBlockCount  == freeBlockCount);
+    CHECK(stats.largestFreeSize == largestFreeSize);
+}
+
+// Checks that the offsets are aligned, and the sizes are rounded up to the granularity.
+static inline void testAlignment() {
+    constexpr size_t capacity = 1024 * GRANULARITY;
+    TlsfAllocator allocator{capacity, GRANULARITY};
+    AllocationMap allocs;
+    // Begin at an offset which is not aligned to the larger alignments.
+    const TlsfAllocator::Allocation first = allocator.allocate(1, 1);
+    CHECK(isValid(first) && first.offset == 0 && first.size == GRANULARITY);
+    checkAllocation(first, 1, 1, capacity, allocs);
+    const size_t alignments[] = {1, 256, GRANULARITY, 4 * GRANULARITY, 64 * GRANULARITY};
+    const size_t sizes[]      = {1, GRANULARITY - 1, GRANULARITY + 1, 5 * GRANULARITY};
+    for (const size_t alignment : alignments) {
+        for (const size_t size : sizes) {
+            const TlsfAllocator::Allocation alloc = allocator.allocate(size, alignment);
+            CHECK(isValid(alloc));
+            if (isValid(alloc)) {
+                checkAllocation(alloc, size, alignment, capacity, allocs);
+            }
+        }
+    }
+    // The padding skipped for the alignment remains available.
+    checkStats(allocator, capacity, allocs);
+}
+
+// Checks splitting of the free blocks, and merging with both neighbors.
+static inline void testSplitMerge() {
+    constexpr size_t capacity = 64 * GRANULARITY;
+    TlsfAllocator allocator{capacity, GRANULARITY};
+    AllocationMap allocs;
+    TlsfAllocator::Allocation a[3];
+    for (size_t i = 0; i < 3; ++i) {
+        a[i] = allocator.allocate(4 * GRANULARITY, GRANULARITY);
+        CHECK(isValid(a[i]) && a[i].offset == 4 * GRANULARITY * i);
+        checkAllocation(a[i], 4 * GRANULARITY, GRANULARITY, capacity, allocs);
+    }
+    checkStats(allocator, capacity, allocs);
+    CHECK(allocator.computeStats().freeBlockCount == 1);
+    // Freeing the middle block creates a hole.
+    allocator.free(a[1]);
+    allocs.erase(a[1].offset);
+    checkStats(allocator, capacity, allocs);
+    CHECK(allocator.computeStats().freeBlockCount == 2);
+    // Freeing the first block merges it with the next one.
+    allocator.free(a[0]);
+    allocs.erase(a[0].offset);
+    checkStats(allocator, capacity, allocs);
+    CHECK(allocator.computeStats().freeBlockCount == 2);
+    // Freeing the last block merges it with both neighbors.
+    allocator.free(a[2]);
+    allocs.erase(a[2].offset);
+    const TlsfAllocator::Stats stats = allocator.computeStats();
+    CHECK(stats.freeBlockCount  == 1);
+    CHECK(stats.largestFreeSize == capacity);
+    CHECK(stats.fragmentation   == 0.f);
+}
+
+// Checks that freed blocks are reused.
+static inline void testReuse() {
+    constexpr size_t capacity = 256 * GRANULARITY;
+    TlsfAllocator allocator{capacity, GRANULARITY};
+    AllocationMap allocs;
+    // Allocating and freeing the same size repeatedly must not leak any memory.
+    for (size_t i = 0; i < 1000; ++i) {
+        const TlsfAllocator::Allocation alloc = allocator.allocate(3 * GRANULARITY, 1);
+        CHECK(isValid(alloc) && alloc.offset == 0);
+        allocator.free(alloc);
+    }
+    checkStats(allocator, capacity, allocs);
+    // Punch a hole of 16 granules (the size of a class). The same size must reuse it.
+    TlsfAllocator::Allocation a[3];
+    for (size_t i = 0; i < 3; ++i) {
+        a[i] = allocator.allocate(16 * GRANULARITY, 1);
+        checkAllocation(a[i], 16 * GRANULARITY, 1, capacity, allocs);
+    }
+    allocator.free(a[1]);
+    allocs.erase(a[1].offset);
+    const TlsfAllocator::Allocation b = allocator.allocate(16 * GRANULARITY, 1);
+    CHECK(isValid(b) && b.offset == a[1].offset);
+    checkAllocation(b, 16 * GRANULARITY, 1, capacity, allocs);
+    checkStats(allocator, capacity, allocs);
+}
+
+// Checks the behavior of a full allocator.
+static inline void testExhaustion() {
+    constexpr size_t count    = 100;
+    constexpr size_t capacity = count * GRANULARITY;
+    // The size is rounded down to a multiple of the granularity.
+    TlsfAllocator allocator{capacity + GRANULARITY - 1, GRANULARITY};
+    AllocationMap allocs;
+    CHECK(!isValid(allocator.allocate(capacity + 1, 1)));
+    std::vector<TlsfAllocator::Allocation> blocks;
+    while (true) {
+        const TlsfAllocator::Allocation alloc = allocator.allocate(GRANULARITY, 1);
+        if (!isValid(alloc)) break;
+        checkAllocation(alloc, GRANULARITY, 1, capacity, allocs);
+        blocks.push_back(alloc);
+        if (blocks.size() > count) break;
+    }
+    CHECK(blocks.size() == count);
+    const TlsfAllocator::Stats stats = allocator.computeStats();
+    CHECK(stats.usedSize == capacity && stats.freeSize == 0 && stats.freeBlockCount == 0);
+    CHECK(stats.fragmentation == 0.f);
+    // Any free block can be reused once the allocator is full.
+    allocator.free(blocks[count / 2]);
+    allocs.erase(blocks[count / 2].offset);
+    CHECK(!isValid(allocator.allocate(2 * GRANULARITY, 1)));
+    const TlsfAllocator::Allocation alloc = allocator.allocate(GRANULARITY, 1);
+    CHECK(isValid(alloc) && alloc.offset == blocks[count / 2].offset);
+    checkAllocation(alloc, GRANULARITY, 1, capacity, allocs);
+    checkStats(allocator, capacity, allocs);
+}
+
+// Checks the fragmentation statistics of a checkerboard of free blocks.
+static inline void testFragmentation() {
+    constexpr size_t count    = 64;
+    constexpr size_t capacity = count * 2 * GRANULARITY;
+    TlsfAllocator allocator{capacity, GRANULARITY};
+    AllocationMap allocs;
+    std::vector<TlsfAllocator::Allocation> blocks;
+    for (size_t i = 0; i < count; ++i) {
+        blocks.push_back(allocator.allocate(2 * GRANULARITY, 1));
+        checkAllocation(blocks.back(), 2 * GRANULARITY, 1, capacity, allocs);
+    }
+    for (size_t i = 0; i < count; i += 2) {
+        allocator.free(blocks[i]);
+        allocs.erase(blocks[i].offset);
+    }
+    const TlsfAllocator::Stats stats = allocator.computeStats();
+    CHECK(stats.freeSize        == capacity / 2);
+    CHECK(stats.largestFreeSize == 2 * GRANULARITY);
+    CHECK(stats.freeBlockCount  == count / 2);
+    CHECK(stats.allocationCount == count / 2);
+    CHECK(stats.fragmentation   == 1.f - 2.f / count);
+    checkStats(allocator, capacity, allocs);
+    // Larger blocks do not fit, even though half of the memory is free.
+    CHECK(!isValid(allocator.allocate(3 * GRANULARITY, 1)));
+}
+
+// Allocates and frees random blocks, and compares the statistics with the live allocations.
+static inline void testRandom() {
+    constexpr size_t capacity = 4096 * GRANULARITY;
+    TlsfAllocator allocator{capacity, GRANULARITY};
+    AllocationMap allocs;
+    std::mt19937 rng{12345};
+    const size_t alignments[] = {1, GRANULARITY, 4 * GRANULARITY};
+    for (size_t i = 0; i < 20000; ++i) {
+        if (allocs.empty() || rng() % 3 != 0) {
+            const size_t size      = 1 + rng() % (64 * GRANULARITY);
+            const size_t alignment = alignments[rng() % 3];
+            const TlsfAllocator::Allocation alloc = allocator.allocate(size, alignment);
+            if (isValid(alloc)) {
+                checkAllocation(alloc, size, alignment, capacity, allocs);
+            }
+        } else {
+            auto it = allocs.begin();
+            std::advance(it, rng() % allocs.size());
+            allocator.free(it->second);
+            allocs.erase(it);
+        }
+        if (i % 100 == 0) {
+            checkStats(allocator, capacity, allocs);
+        }
+    }
+    for (const auto& pair : allocs) {
+        allocator.free(pair.second);
+    }
+    const TlsfAllocator::Stats stats = allocator.computeStats();
+    CHECK(stats.usedSize == 0 && stats.freeBlockCount == 1 && stats.largestFreeSize == capacity);
+}
+
+int main() {
+    testAlignment();
+    testSplitMerge();
+    testReuse();
+    testExhaustion();
+    testFragmentation();
+    testRandom();
+    return finishTest("TlsfAllocatorTest");
+}
@@ -0,0 +1,395 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+#include "Test.h"
+#include "../Common/JobSystem.h"
+#include "../Common/StreamCopy.h"
+#include "../Common/UploadRing.hpp"
+
+// Allocations are made in granules of 16 bytes.
+static constexpr size_t GRANULE_SIZE = 16;
+
+// Simulated command queue. Tracks the owners of the granules of the buffer,
+// and releases the granules of the committed allocations once their fence value is reached.
+struct FakeQueue {
+    struct Commit {
+        size_t   firstGranule;
+        size_t   granuleCount;
+        uint64_t fenceValue;
+    };
+    explicit FakeQueue(const size_t capacity)
+        : owners(capacity / GRANULE_SIZE)
+        , completedValue{0}
+        , waitCount{0} {
+        for (auto& owner : owners) {
+            owner = 0;
+        }
+    }
+    // Acquires the granules of the allocation. Fails if any of them is still in use.
+    bool acquire(const size_t offset, const size_t size, const uint32_t owner) {
+        bool isFree = true;
+        for (size_t g = offset / GRANULE_SIZE; g < (offset + size) / GRANULE_SIZE; ++g) {
+            uint32_t expected = 0;
+            isFree &= owners[g].compare_exchange_strong(expected, owner);
+        }
+        return isFree;
+    }
+    // Registers the allocation, which is released once the fence reaches 'fenceValue'.
+    void commit(const size_t offset, const size_t size, const uint64_t fenceValue) {
+        std::lock_guard<std::mutex> lock{mutex};
+        commits.push_back(Commit{offset / GRANULE_SIZE, size / GRANULE_SIZE, fenceValue});
+    }
+    // Completes the commands up to 'value'. The granules are released before the fence
+    // is updated, so the ring buffer cannot reuse them any sooner.
+    void signal(const uint64_t value) {
+        std::lock_guard<std::mutex> lock{mutex};
+        if (value <= completedValue) return;
+        auto isComplete = [value](const Commit& c) { return c.fenceValue <= value; };
+        for (const Commit& c : commits) {
+            if (!isComplete(c)) continue;
+            for (size_t g = c.firstGranule; g < c.firstGranule + c.granuleCount; ++g) {
+                owners[g] = 0;
+            }
+        }
+        commits.erase(std::remove_if(commits.begin(), commits.end(), isComplete),
+                      commits.end());
+        completedValue = value;
+    }
+public:
+    std::vector<std::atomic<uint32_t>> owners;
+    std::vector<Commit>                commits;
+    std::mutex                         mutex;
+    std::atomic<uint64_t>              completedValue;
+    std::atomic<size_t>                waitCount;
+};
+
+// Fence of the simulated queue. Waiting for a value completes the commands up to it.
+struct FakeFence {
+    uint64_t completedValue() const {
+        return queue->completedValue;
+    }
+    void wait(const uint64_t value) const {
+        queue->waitCount++;
+        queue->signal(value);
+    }
+public:
+    FakeQueue* queue;
+};
+
+using TestRing = UploadRing<FakeFence>;
+
+// Memory of the ring buffer, aligned for any of the tested alignments.
+struct TestBuffer {
+    explicit TestBuffer(const size_t capacity)
+        : memory{std::make_unique<byte_t[]>(capacity + 256)} {}
+    byte_t* begin() {
+        const size_t address = reinterpret_cast<size_t>(memory.get());
+        return reinterpret_cast<byte_t*>((address + 255) & ~size_t{255});
+    }
+public:
+    std::unique_ptr<byte_t[]> memory;
+};
+
+// Checks that the allocation is valid, and does not overlap the memory in use.
+static inline void checkAllocation(FakeQueue& queue, TestBuffer& buffer, const TestRing& ring,
+                                   const TestRing::Allocation& alloc, const size_t size,
+                                   const size_t alignment, const uint32_t owner) {
+    CHECK(alloc.address == buffer.begin() + alloc.offset);
+    CHECK(alloc.offset % alignment == 0);
+    CHECK(alloc.offset + size <= ring.capacity());
+    CHECK(queue.acquire(alloc.offset, size, owner));
+}
+
+// Checks that the offsets wrap around the end of the buffer,
+// and that the chunks which do not fit at the end start at the beginning.
+static inline void testWraparound() {
+    constexpr size_t capacity = 1024;
+    FakeQueue  queue{capacity};
+    TestBuffer buffer{capacity};
+    TestRing   ring{buffer.begin(), capacity, 4, FakeFence{&queue}};
+    // Virtual offset of the end of the last allocation.
+    uint64_t head = 0;
+    size_t   wrapCount = 0, prevOffset = 0;
+    for (uint32_t i = 1; i <= 32; ++i) {
+        const size_t size = (i % 2) ? 304 : 208;
+        const TestRing::Allocation alloc = ring.tryReserve(size, GRANULE_SIZE);
+        CHECK(alloc.address != nullptr);
+        if (!alloc.address) return;
+        checkAllocation(queue, buffer, ring, alloc, size, GRANULE_SIZE, i);
+        // The chunk must follow the previous one, unless it does not fit at the end.
+        uint64_t start = head;
+        if (start % capacity + size > capacity) {
+            start = (start / capacity + 1) * capacity;
+        }
+        head = start + size;
+        CHECK(alloc.offset == start % capacity);
+        wrapCount += alloc.offset < prevOffset;
+        prevOffset = alloc.offset;
+        // Submit and complete the copy right away.
+        queue.commit(alloc.offset, size, i);
+        ring.commit(alloc, i);
+        ring.closeSegment(i);
+        queue.signal(i);
+    }
+    CHECK(wrapCount >= 4);
+    // Fill the buffer without completing the copies.
+    size_t reservedSize = 0;
+    uint64_t fenceValue = 33;
+    while (true) {
+        const TestRing::Allocation alloc = ring.tryReserve(64, 64);
+        if (!alloc.address) break;
+        checkAllocation(queue, buffer, ring, alloc, 64, 64, 1000);
+        queue.commit(alloc.offset, 64, fenceValue);
+        ring.commit(alloc, fenceValue);
+        ring.closeSegment(fenceValue++);
+        reservedSize += 64;
+        CHECK(reservedSize <= capacity);
+        if (reservedSize > capacity) return;
+    }
+    // The chunks are aligned, so at most the skipped end of the buffer remains unused.
+    CHECK(reservedSize + 64 > capacity - 64);
+    // Once the copies complete, and the current segment is closed, the memory can be reused.
+    queue.signal(fenceValue - 1);
+    ring.closeSegment(fenceValue - 1);
+    const TestRing::Allocation alloc = ring.tryReserve(64, 64);
+    CHECK(alloc.address != nullptr);
+    if (alloc.address) {
+        checkAllocation(queue, buffer, ring, alloc, 64, 64, 2000);
+    }
+}
+
+// Checks that closing a segment is deferred while 'maxSegmentCount' segments are in flight.
+static inline void testSegmentLimit() {
+    constexpr size_t capacity = 1024;
+    FakeQueue  queue{capacity};
+    TestBuffer buffer{capacity};
+    TestRing   ring{buffer.begin(), capacity, 3, FakeFence{&queue}};
+    TestRing::Allocation allocs[6];
+    // Closing an empty segment has no effect.
+    ring.closeSegment(0);
+    allocs[0] = ring.tryReserve(64, GRANULE_SIZE);
+    CHECK(allocs[0].segment == 0);
+    ring.commit(allocs[0], 1);
+    ring.closeSegment(1);
+    allocs[1] = ring.tryReserve(64, GRANULE_SIZE);
+    CHECK(allocs[1].segment == 1);
+    ring.commit(allocs[1], 2);
+    ring.closeSegment(2);
+    allocs[2] = ring.tryReserve(64, GRANULE_SIZE);
+    CHECK(allocs[2].segment == 2);
+    ring.commit(allocs[2], 3);
+    // All 3 segments are in flight, so the current segment remains open.
+    ring.closeSegment(3);
+    allocs[3] = ring.tryReserve(64, GRANULE_SIZE);
+    CHECK(allocs[3].segment == 2);
+    ring.commit(allocs[3], 4);
+    ring.closeSegment(4);
+    allocs[4] = ring.tryReserve(64, GRANULE_SIZE);
+    CHECK(allocs[4].segment == 2);
+    ring.commit(allocs[4], 5);
+    // Once the oldest segment is retired, the current one can be closed.
+    queue.signal(1);
+    ring.closeSegment(5);
+    // The new segment is empty, so it remains open.
+    ring.closeSegment(5);
+    allocs[5] = ring.tryReserve(64, GRANULE_SIZE);
+    CHECK(allocs[5].segment == 3);
+}
+
+// Checks that waitForSpace() does not wait for commits which refer to unsubmitted commands.
+static inline void testWaitForSpace() {
+    constexpr size_t capacity = 1024;
+    FakeQueue  queue{capacity};
+    TestBuffer buffer{capacity};
+    TestRing   ring{buffer.begin(), capacity, 4, FakeFence{&queue}};
+    // The current segment cannot be waited for.
+    CHECK(!ring.waitForSpace());
+    const TestRing::Allocation alloc = ring.tryReserve(capacity, GRANULE_SIZE);
+    CHECK(alloc.address != nullptr && alloc.segment == 0);
+    CHECK(!ring.tryReserve(GRANULE_SIZE, GRANULE_SIZE).address);
+    // The allocation is made before submission 1, but committed after it,
+    // so the commands which use it will be submitted with the fence value of 2.
+    ring.closeSegment(1);
+    ring.commit(alloc, 2);
+    CHECK(!ring.waitForSpace());
+    CHECK(queue.waitCount == 0);
+    CHECK(!ring.tryReserve(GRANULE_SIZE, GRANULE_SIZE).address);
+    // Once the commands are submitted, the segment can be waited for.
+    ring.closeSegment(2);
+    CHECK(ring.waitForSpace());
+    CHECK(queue.waitCount == 1);
+    CHECK(queue.completedValue == 2);
+    // The segment is retired, and the entire buffer is available again.
+    CHECK(ring.tryReserve(capacity, GRANULE_SIZE).address != nullptr);
+}
+
+// Reserves and commits memory from multiple threads, while the consumer closes the segments,
+// and the simulated queue completes them with a delay.
+static inline void testConcurrency() {
+    constexpr size_t capacity    = 64 * 1024;
+    constexpr size_t threadCount = 4;
+    constexpr size_t allocCount  = 20000;
+    FakeQueue  queue{capacity};
+    TestBuffer buffer{capacity};
+    TestRing   ring{buffer.begin(), capacity, 8, FakeFence{&queue}};
+    // Like the copy queue submission, commits and segment closing are serialized.
+    std::mutex          copyMutex;
+    uint64_t            pendingValue = 1;   // Value of the next submission
+    std::atomic<size_t> activeWriterCount{threadCount};
+    std::atomic<size_t> failedCount{0};
+    const auto writer = [&](const uint32_t threadIndex) {
+        std::mt19937 rng{threadIndex};
+        const size_t alignments[] = {16, 64, 256};
+        for (uint32_t i = 0; i < allocCount; ++i) {
+            const size_t size      = GRANULE_SIZE * (1 + rng() % 64);
+            const size_t alignment = alignments[rng() % 3];
+            TestRing::Allocation alloc = ring.tryReserve(size, alignment);
+            while (!alloc.address) {
+                if (!ring.waitForSpace()) {
+                    std::this_thread::yield();
+                }
+                alloc = ring.tryReserve(size, alignment);
+            }
+            const bool isValid = alloc.address == buffer.begin() + alloc.offset &&
+                                 alloc.offset % alignment == 0 &&
+                                 alloc.offset + size <= capacity &&
+                                 queue.acquire(alloc.offset, size, threadIndex + 1);
+            failedCount += !isValid;
+            memset(alloc.address, static_cast<int>(threadIndex), size);
+            std::lock_guard<std::mutex> lock{copyMutex};
+            queue.commit(alloc.offset, size, pendingValue);
+            ring.commit(alloc, pendingValue);
+        }
+        activeWriterCount--;
+    };
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < threadCount; ++t) {
+        threads.emplace_back(writer, t);
+    }
+    // The consumer submits continuously, and each submission completes 2 submissions later.
+    uint64_t submittedValue = 0;
+    while (activeWriterCount > 0) {
+        {
+            std::lock_guard<std::mutex> lock{copyMutex};
+            submittedValue = pendingValue++;
+            ring.closeSegment(submittedValue);
+        }
+        if (submittedValue > 2) {
+            queue.signal(submittedValue - 2);
+        }
+        std::this_thread::yield();
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    ring.closeSegment(pendingValue);
+    queue.signal(pendingValue);
+    CHECK(0 == failedCount);
+    CHECK(queue.commits.empty());
+}
+
+// Copies data into a reservation using a parallel loop, while the buffer is nearly full.
+// Meanwhile, another loader is queued. The calling thread must not execute it while waiting
+// for the copy, since the loader would wait for the segment of the outer reservation.
+static inline void testNestedReservations() {
+    constexpr size_t capacity = 64 * 1024;
+    constexpr size_t size     = 16 * 1024;
+    FakeQueue  queue{capacity};
+    TestBuffer buffer{capacity};
+    TestRing   ring{buffer.begin(), capacity, 4, FakeFence{&queue}};
+    // Like the copy queue submission, commits and segment closing are serialized.
+    std::mutex copyMutex;
+    uint64_t   pendingValue = 1;    // Value of the next submission
+    // Reserves memory. If the buffer is full, submits the pending copies (like the renderer).
+    const auto reserve = [&]() {
+        TestRing::Allocation alloc = ring.tryReserve(size, 256);
+        while (!alloc.address) {
+            if (!ring.waitForSpace()) {
+                std::lock_guard<std::mutex> lock{copyMutex};
+                ring.closeSegment(pendingValue++);
+            }
+            alloc = ring.tryReserve(size, 256);
+        }
+        return alloc;
+    };
+    const auto commit = [&](const TestRing::Allocation& alloc) {
+        std::lock_guard<std::mutex> lock{copyMutex};
+        queue.commit(alloc.offset, size, pendingValue);
+        ring.commit(alloc, pendingValue);
+    };
+    // A deadlock cannot be reported by a check, so the test is aborted instead.
+    std::atomic<bool> isComplete{false};
+    std::thread watchdog{[&isComplete]() {
+        for (size_t i = 0; i < 300 && !isComplete; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+        if (!isComplete) {
+            printError("UploadRingTest: the nested reservation has deadlocked.");
+            std::abort();
+        }
+    }};
+    // A single worker, so that only the calling thread can execute the queued loader.
+    JobSystem::start(1);
+    // Fill the buffer with copies which have not been submitted yet.
+    TestRing::Allocation allocs[capacity / size];
+    for (uint32_t i = 0; i < capacity / size; ++i) {
+        allocs[i] = reserve();
+        CHECK(queue.acquire(allocs[i].offset, size, i + 1));
+        if (i + 1 < capacity / size) {
+            commit(allocs[i]);
+        }
+    }
+    // The last allocation is written by the calling thread and the worker.
+    const TestRing::Allocation outer = allocs[capacity / size - 1];
+    std::vector<byte_t> src(size);
+    for (size_t i = 0; i < size; ++i) {
+        src[i] = static_cast<byte_t>(i * 7 + (i >> 8));
+    }
+    std::atomic<bool>   isWorkerCopying{false};
+    std::atomic<size_t> failedCount{0};
+    JobHandle           loader;
+    JobSystem::isolatedParallelFor(2, 1, [&](size_t begin, size_t end) {
+        if (JobSystem::threadIndex() == JobSystem::workerCount()) {
+            // Queue the loader once the worker is busy.
+            while (!isWorkerCopying) {
+                std::this_thread::yield();
+            }
+            loader = JobSystem::schedule([&]() {
+                const TestRing::Allocation alloc = reserve();
+                failedCount += !queue.acquire(alloc.offset, size, UINT32_MAX);
+                commit(alloc);
+            });
+        } else {
+            // Keep the calling thread waiting.
+            isWorkerCopying = true;
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+        const size_t half = size / 2;
+        streamCopy(outer.address + begin * half, &src[begin * half], (end - begin) * half);
+    });
+    CHECK(0 == memcmp(outer.address, src.data(), size));
+    commit(outer);
+    JobSystem::wait(loader);
+    JobSystem::stop();
+    isComplete = true;
+    watchdog.join();
+    ring.closeSegment(pendingValue);
+    queue.signal(pendingValue);
+    CHECK(0 == failedCount);
+    CHECK(queue.commits.empty());
+}
+
+int main() {
+    testWraparound();
+    testSegmentLimit();
+    testWaitForSpace();
+    testConcurrency();
+    testNestedReservations();
+    return finishTest("UploadRingTest");
+}
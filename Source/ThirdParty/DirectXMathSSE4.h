@@ -19,10 +19,12 @@
 #error SSE4 not supported on ARM platform
 #endif
 
+#ifdef _MSC_VER
 #pragma warning(push)
 #pragma warning(disable : 4987)
 #include <intrin.h>
 #pragma warning(pop)
+#endif
 
 #include <smmintrin.h>
 
@@ -238,9 +238,9 @@ namespace DirectX
     {
     public:
         ScratchImage()
-            : _nimages(0), _size(0), _image(nullptr), _memory(nullptr) {}
+            : _nimages(0), _size(0), _image(nullptr), _memory(nullptr), _external(false) {}
         ScratchImage(ScratchImage&& moveFrom)
-            : _nimages(0), _size(0), _image(nullptr), _memory(nullptr) { *this = std::move(moveFrom); }
+            : _nimages(0), _size(0), _image(nullptr), _memory(nullptr), _external(false) { *this = std::move(moveFrom); }
         ~ScratchImage() { Release(); }
 
         ScratchImage& __cdecl operator= (ScratchImage&& moveFrom);
@@ -252,6 +252,12 @@ namespace DirectX
         HRESULT __cdecl Initialize3D( _In_ DXGI_FORMAT fmt, _In_ size_t width, _In_ size_t height, _In_ size_t depth, _In_ size_t mipLevels, _In_ DWORD flags = CP_FLAGS_NONE );
         HRESULT __cdecl InitializeCube( _In_ DXGI_FORMAT fmt, _In_ size_t width, _In_ size_t height, _In_ size_t nCubes, _In_ size_t mipLevels, _In_ DWORD flags = CP_FLAGS_NONE );
 
+        HRESULT __cdecl Initialize2DExternal( _In_ DXGI_FORMAT fmt, _In_ size_t width, _In_ size_t height, _In_ size_t arraySize, _In_ size_t mipLevels,
+                                              _In_reads_bytes_(size) uint8_t* memory, _In_ size_t size, _In_ size_t pitchAlignment, _In_ size_t imageAlignment );
+            // Places the images within externally owned memory, which is not freed by Release()
+            // Row pitches are aligned to 'pitchAlignment', and images to 'imageAlignment' bytes (both powers of 2)
+            // The images of an item are consecutive (mip level 0 first), e.g. as required to copy them to a Direct3D 12 texture
+
         HRESULT __cdecl InitializeFromImage( _In_ const Image& srcImage, _In_ bool allow1D = false, _In_ DWORD flags = CP_FLAGS_NONE );
         HRESULT __cdecl InitializeArrayFromImages( _In_reads_(nImages) const Image* images, _In_ size_t nImages, _In_ bool allow1D = false, _In_ DWORD flags = CP_FLAGS_NONE ); 
         HRESULT __cdecl InitializeCubeFromImages( _In_reads_(nImages) const Image* images, _In_ size_t nImages, _In_ DWORD flags = CP_FLAGS_NONE );
@@ -278,6 +284,7 @@ namespace DirectX
         TexMetadata _metadata;
         Image*      _image;
         uint8_t*    _memory;
+        bool        _external;
 
         // Hide copy constructor and assignment operator
         ScratchImage( const ScratchImage& );
@@ -452,6 +459,11 @@ namespace DirectX
         // levels of '0' indicates a full mipchain, otherwise is generates that number of total levels (including the source base image)
         // Defaults to Fant filtering which is equivalent to a box filter
 
+    HRESULT __cdecl GenerateMipMapsInto( _In_ const Image& baseImage, _In_ DWORD filter, _In_ const ScratchImage& mipChain );
+        // Generates the mip chain within the images of an initialized 2D 'mipChain' (e.g. placed in external memory)
+        // The metadata of the chain determines the number of levels. The images are only written if WIC filtering is used,
+        // which suits write-combined memory; otherwise, the mip chain is generated in system memory and copied
+
     HRESULT __cdecl GenerateMipMaps3D( _In_reads_(depth) const Image* baseImages, _In_ size_t depth, _In_ DWORD filter, _In_ size_t levels,
                                        _Out_ ScratchImage& mipChain );
     HRESULT __cdecl GenerateMipMaps3D( _In_reads_(nimages) const Image* srcImages, _In_ size_t nimages, _In_ const TexMetadata& metadata,
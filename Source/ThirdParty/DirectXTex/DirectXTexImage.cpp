@@ -240,11 +240,13 @@ ScratchImage& ScratchImage::operator= (ScratchImage&& moveFrom)
         _metadata = moveFrom._metadata;
         _image = moveFrom._image;
         _memory = moveFrom._memory;
+        _external = moveFrom._external;
 
         moveFrom._nimages = 0;
         moveFrom._size = 0;
         moveFrom._image = nullptr;
         moveFrom._memory = nullptr;
+        moveFrom._external = false;
     }
     return *this;
 }
@@ -473,6 +475,95 @@ HRESULT ScratchImage::InitializeCube( DXGI_FORMAT fmt, size_t width, size_t heig
     return S_OK;
 }
 
+_Use_decl_annotations_
+HRESULT ScratchImage::Initialize2DExternal( DXGI_FORMAT fmt, size_t width, size_t height, size_t arraySize, size_t mipLevels,
+                                            uint8_t* memory, size_t size, size_t pitchAlignment, size_t imageAlignment )
+{
+    if ( !IsValid(fmt) || !width || !height || !arraySize )
+        return E_INVALIDARG;
+
+    if ( !memory )
+        return E_POINTER;
+
+    if ( !pitchAlignment || ( pitchAlignment & ( pitchAlignment - 1 ) ) ||
+         !imageAlignment || ( imageAlignment & ( imageAlignment - 1 ) ) )
+        return E_INVALIDARG;
+
+    if ( IsPalettized(fmt) || IsPlanar(fmt) )
+        return HRESULT_FROM_WIN32( ERROR_NOT_SUPPORTED );
+
+    if ( !_CalculateMipLevels(width,height,mipLevels) )
+        return E_INVALIDARG;
+
+    Release();
+
+    _metadata.width = width;
+    _metadata.height = height;
+    _metadata.depth = 1;
+    _metadata.arraySize = arraySize;
+    _metadata.mipLevels = mipLevels;
+    _metadata.miscFlags = 0;
+    _metadata.miscFlags2 = 0;
+    _metadata.format = fmt;
+    _metadata.dimension = TEX_DIMENSION_TEXTURE2D;
+
+    size_t nimages = arraySize * mipLevels;
+
+    _image = new (std::nothrow) Image[ nimages ];
+    if ( !_image )
+        return E_OUTOFMEMORY;
+
+    _nimages = nimages;
+    memset( _image, 0, sizeof(Image) * nimages );
+
+    size_t index = 0;
+    size_t offset = 0;
+    for( size_t item = 0; item < arraySize; ++item )
+    {
+        size_t w = width;
+        size_t h = height;
+
+        for( size_t level = 0; level < mipLevels; ++level )
+        {
+            size_t rowPitch, slicePitch;
+            ComputePitch( fmt, w, h, rowPitch, slicePitch, CP_FLAGS_NONE );
+
+            // Pad the rows and the beginning of the image
+            rowPitch = ( rowPitch + pitchAlignment - 1 ) & ~( pitchAlignment - 1 );
+            slicePitch = rowPitch * ComputeScanlines( fmt, h );
+            offset = ( offset + imageAlignment - 1 ) & ~( imageAlignment - 1 );
+
+            if ( offset + slicePitch > size )
+            {
+                Release();
+                return E_INVALIDARG;
+            }
+
+            _image[index].width = w;
+            _image[index].height = h;
+            _image[index].format = fmt;
+            _image[index].rowPitch = rowPitch;
+            _image[index].slicePitch = slicePitch;
+            _image[index].pixels = memory + offset;
+            ++index;
+
+            offset += slicePitch;
+
+            if ( h > 1 )
+                h >>= 1;
+
+            if ( w > 1 )
+                w >>= 1;
+        }
+    }
+
+    _memory = memory;
+    _size = size;
+    _external = true;
+
+    return S_OK;
+}
+
 _Use_decl_annotations_
 HRESULT ScratchImage::InitializeFromImage( const Image& srcImage, bool allow1D, DWORD flags )
 {
@@ -659,9 +750,12 @@ void ScratchImage::Release()
 
     if ( _memory )
     {
-        _aligned_free( _memory );
+        // External memory is owned by the caller
+        if ( !_external )
+            _aligned_free( _memory );
         _memory = 0;
     }
+    _external = false;
     
     memset(&_metadata, 0, sizeof(_metadata));
 }
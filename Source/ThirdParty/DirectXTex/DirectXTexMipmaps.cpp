@@ -2676,6 +2676,80 @@ HRESULT GenerateMipMaps( const Image& baseImage, DWORD filter, size_t levels, Sc
     }
 }
 
+_Use_decl_annotations_
+HRESULT GenerateMipMapsInto( const Image& baseImage, DWORD filter, const ScratchImage& mipChain )
+{
+    if ( !IsValid( baseImage.format ) )
+        return E_INVALIDARG;
+
+    if ( !baseImage.pixels || !mipChain.GetPixels() )
+        return E_POINTER;
+
+    const TexMetadata& mdata = mipChain.GetMetadata();
+    if ( mdata.dimension != TEX_DIMENSION_TEXTURE2D || mdata.arraySize != 1 || mdata.mipLevels <= 1
+         || mdata.format != baseImage.format || mdata.width != baseImage.width || mdata.height != baseImage.height )
+        return E_INVALIDARG;
+
+    if ( IsCompressed(baseImage.format) || IsTypeless(baseImage.format) || IsPlanar(baseImage.format) || IsPalettized(baseImage.format) )
+    {
+        return HRESULT_FROM_WIN32( ERROR_NOT_SUPPORTED );
+    }
+
+    const size_t levels = mdata.mipLevels;
+
+    if ( _UseWICFiltering( baseImage.format, filter ) )
+    {
+        switch(filter & TEX_FILTER_MASK)
+        {
+            case 0:
+            case TEX_FILTER_POINT:
+            case TEX_FILTER_FANT: // Equivalent to Box filter
+            case TEX_FILTER_LINEAR:
+            case TEX_FILTER_CUBIC:
+                {
+                    WICPixelFormatGUID pfGUID;
+                    if ( _DXGIToWIC( baseImage.format, pfGUID, true ) )
+                    {
+                        // Every level is resized from the base image, so the mip chain is only written
+                        return _GenerateMipMapsUsingWIC( baseImage, filter, levels, pfGUID, mipChain, 0 );
+                    }
+                }
+                break;
+
+            default:
+                return HRESULT_FROM_WIN32( ERROR_NOT_SUPPORTED );
+        }
+    }
+
+    // Generate the mip chain in system memory (the custom filters read the previous level), and copy it
+    ScratchImage temp;
+    HRESULT hr = GenerateMipMaps( baseImage, filter, levels, temp );
+    if ( FAILED(hr) )
+        return hr;
+
+    for( size_t level = 0; level < levels; ++level )
+    {
+        const Image* src = temp.GetImage( level, 0, 0 );
+        const Image* dst = mipChain.GetImage( level, 0, 0 );
+        if ( !src || !dst )
+            return E_POINTER;
+
+        assert( src->width == dst->width && src->height == dst->height );
+
+        const uint8_t* pSrc = src->pixels;
+        uint8_t* pDest = dst->pixels;
+        const size_t msize = std::min<size_t>( src->rowPitch, dst->rowPitch );
+        for( size_t h = 0; h < src->height; ++h )
+        {
+            memcpy_s( pDest, dst->rowPitch, pSrc, msize );
+            pSrc += src->rowPitch;
+            pDest += dst->rowPitch;
+        }
+    }
+
+    return S_OK;
+}
+
 _Use_decl_annotations_
 HRESULT GenerateMipMaps( const Image* srcImages, size_t nimages, const TexMetadata& metadata,
                          DWORD filter, size_t levels, ScratchImage& mipChain )